@@ -5,9 +5,9 @@ output=${program%.*}
 
 function compile {
   if [[ "$OSTYPE" == "linux"* ]]; then
-    errs="$((g++ -std=c++11 -Wall -Wno-deprecated -O3 -fomit-frame-pointer -pipe -DFX -DXMESA -lGL -lGLU -lglut -lX11 -lm -g $filepath -o $output) 2>&1)"
+    errs="$((g++ -std=c++11 -pthread -Wall -Wno-deprecated -O3 -fomit-frame-pointer -pipe -DFX -DXMESA -lGL -lGLU -lglut -lX11 -lEGL -lm -g $filepath -o $output) 2>&1)"
   elif [[ "$OSTYPE" == "darwin"* ]]; then
-    errs="$((g++ -std=c++11 -Wall -O3 -framework OpenGL -I/usr/local/include -L/usr/local/lib -lglfw3 -lGLEW $filepath -o $output) 2>&1)"
+    errs="$((g++ -std=c++11 -pthread -Wall -O3 -framework OpenGL -I/usr/local/include -L/usr/local/lib -lglfw3 -lGLEW $filepath -o $output) 2>&1)"
   else
     echo "OS not supported"
     exit -1
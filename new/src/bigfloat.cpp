@@ -0,0 +1,263 @@
+/**
+ * [Program description]
+ */
+
+#include <ctype.h>
+
+#include "bigfloat.hpp"
+
+/**
+ * Constructor to create a fixed-point number with a given number of limbs,
+ * from a double, which must fit in the integer limb.
+ */
+BigFloat::BigFloat(GLuint limbCount, GLdouble value)
+{
+  limbs = std::vector<GLuint>(std::max(limbCount, 2u), 0);
+
+  GLdouble magnitude = fabs(value);
+  GLdouble integer = floor(magnitude);
+  GLdouble fraction = magnitude - integer;
+
+  limbs.back() = integer;
+
+  for (GLint i = limbs.size() - 2; i >= 0 && fraction > 0.0; i--) {
+    fraction *= BIG_FLOAT_LIMB_BASE;
+    limbs[i] = floor(fraction);
+    fraction -= limbs[i];
+  }
+
+  if (value < 0.0) {
+    *this = negate();
+  }
+}
+
+/**
+ * Create a fixed-point number from its decimal text, such as "-1.25" or
+ * "3.5e-40". Digits beyond the precision of the limbs are lost.
+ */
+BigFloat BigFloat::fromString(std::string text, GLuint limbCount)
+{
+  BigFloat number(limbCount);
+  GLuint isNegative = false;
+  GLuint integer = 0;
+  GLint exponent = 0;
+  size_t i = 0;
+
+  if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+    isNegative = text[i++] == '-';
+  }
+
+  size_t integerStart = i;
+
+  while (i < text.size() && isdigit(text[i])) {
+    integer = integer * 10 + (text[i++] - '0');
+  }
+
+  size_t fractionStart = i, fractionEnd = i;
+
+  if (i < text.size() && text[i] == '.') {
+    fractionStart = ++i;
+
+    while (i < text.size() && isdigit(text[i])) {
+      i++;
+    }
+
+    fractionEnd = i;
+  }
+
+  if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+    exponent = atoi(text.c_str() + i + 1);
+    i = text.size();
+  }
+
+  if (i != text.size() || (integerStart == fractionStart &&
+                           fractionStart == fractionEnd)) {
+    fprintf(stderr, "invalid number: %s\n", text.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  // Build the fraction from its last digit, dividing by ten after each one.
+  for (size_t j = fractionEnd; j > fractionStart; j--) {
+    number.limbs.back() = text[j - 1] - '0';
+    number.divideSmall(10);
+  }
+
+  number.limbs.back() = integer;
+
+  for (; exponent > 0; exponent--) {
+    number.multiplySmall(10);
+  }
+
+  for (; exponent < 0; exponent++) {
+    number.divideSmall(10);
+  }
+
+  return isNegative ? number.negate() : number;
+}
+
+/**
+ * Get the number of limbs needed to tell apart two numbers a given distance
+ * apart, with guard bits for the rounding errors of long orbits.
+ */
+GLuint BigFloat::getLimbCount(GLdouble precision)
+{
+  GLuint bitCount = std::max(-log2(precision), 0.0) + BIG_FLOAT_GUARD_BITS;
+
+  return bitCount / 32 + 2;
+}
+
+/**
+ * Check whether the number is negative, from the sign bit of its integer
+ * limb.
+ */
+GLuint BigFloat::isNegative() const
+{
+  return limbs.back() >> 31;
+}
+
+/**
+ * Get the negative of the number, by inverting its bits and adding one.
+ */
+BigFloat BigFloat::negate() const
+{
+  BigFloat result = *this;
+  GLuint64 carry = 1;
+
+  for (GLuint i = 0; i < limbs.size(); i++) {
+    carry += (GLuint)~limbs[i];
+    result.limbs[i] = carry;
+    carry >>= 32;
+  }
+
+  return result;
+}
+
+/**
+ * Add another number with the same number of limbs.
+ */
+BigFloat BigFloat::add(const BigFloat& other) const
+{
+  BigFloat result = *this;
+  GLuint64 carry = 0;
+
+  for (GLuint i = 0; i < limbs.size(); i++) {
+    carry += (GLuint64)limbs[i] + other.limbs[i];
+    result.limbs[i] = carry;
+    carry >>= 32;
+  }
+
+  return result;
+}
+
+/**
+ * Subtract another number with the same number of limbs.
+ */
+BigFloat BigFloat::subtract(const BigFloat& other) const
+{
+  return add(other.negate());
+}
+
+/**
+ * Multiply by another number with the same number of limbs. The magnitudes
+ * are multiplied limb by limb (schoolbook multiplication), and the limbs below
+ * the precision of the result are dropped.
+ */
+BigFloat BigFloat::multiply(const BigFloat& other) const
+{
+  GLuint isResultNegative = isNegative() != other.isNegative();
+  BigFloat a = isNegative() ? negate() : *this;
+  BigFloat b = other.isNegative() ? other.negate() : other;
+  GLuint limbCount = limbs.size();
+  std::vector<GLuint> product(limbCount * 2, 0);
+
+  for (GLuint i = 0; i < limbCount; i++) {
+    GLuint64 carry = 0;
+
+    if (a.limbs[i] == 0) {
+      continue;
+    }
+
+    for (GLuint j = 0; j < limbCount; j++) {
+      carry += (GLuint64)a.limbs[i] * b.limbs[j] + product[i + j];
+      product[i + j] = carry;
+      carry >>= 32;
+    }
+
+    product[i + limbCount] = carry;
+  }
+
+  BigFloat result(limbCount);
+
+  std::copy(product.begin() + limbCount - 1,
+            product.begin() + limbCount * 2 - 1, result.limbs.begin());
+
+  return isResultNegative ? result.negate() : result;
+}
+
+/**
+ * Multiply a non-negative number by a small whole number in place. Anything
+ * carried out of the integer limb is lost.
+ */
+GLvoid BigFloat::multiplySmall(GLuint factor)
+{
+  GLuint64 carry = 0;
+
+  for (GLuint i = 0; i < limbs.size(); i++) {
+    carry += (GLuint64)limbs[i] * factor;
+    limbs[i] = carry;
+    carry >>= 32;
+  }
+}
+
+/**
+ * Divide a non-negative number by a small whole number in place, from the
+ * most significant limb down.
+ */
+GLvoid BigFloat::divideSmall(GLuint divisor)
+{
+  GLuint64 remainder = 0;
+
+  for (GLint i = limbs.size() - 1; i >= 0; i--) {
+    remainder = (remainder << 32) | limbs[i];
+    limbs[i] = remainder / divisor;
+    remainder %= divisor;
+  }
+}
+
+/**
+ * Convert the number to the nearest double, from its most significant limbs.
+ */
+GLdouble BigFloat::toDouble() const
+{
+  BigFloat magnitude = isNegative() ? negate() : *this;
+  GLint last = limbs.size() - 1;
+  GLdouble value = 0.0;
+
+  for (GLint i = last; i >= 0 && i >= last - 3; i--) {
+    value += ldexp((GLdouble)magnitude.limbs[i], 32 * (i - last));
+  }
+
+  return isNegative() ? -value : value;
+}
+
+/**
+ * Convert the number to decimal text with a given number of digits after the
+ * decimal point, leaving out trailing zeros.
+ */
+std::string BigFloat::toString(GLuint digitCount) const
+{
+  BigFloat magnitude = isNegative() ? negate() : *this;
+  std::string text = (isNegative() ? "-" : "") +
+                     std::to_string(magnitude.limbs.back()) + ".";
+
+  // Each digit is moved into the integer limb by multiplying by ten.
+  for (GLuint i = 0; i < digitCount; i++) {
+    magnitude.limbs.back() = 0;
+    magnitude.multiplySmall(10);
+    text += '0' + magnitude.limbs.back();
+  }
+
+  size_t end = text.find_last_not_of('0');
+
+  return text.substr(0, (text[end] == '.') ? end + 2 : end + 1);
+}
@@ -0,0 +1,38 @@
+/**
+ * [Program description]
+ */
+
+#ifndef BIG_FLOAT_HEADER
+#define BIG_FLOAT_HEADER
+
+// Value of one unit of a limb.
+#define BIG_FLOAT_LIMB_BASE 4294967296.0
+
+// Number of bits kept beyond the precision a number is asked for.
+#define BIG_FLOAT_GUARD_BITS 64
+
+class BigFloat
+{
+  public:
+    /**
+     * limbs - 32-bit digits of the number in two's complement, least
+     *         significant first, where the last limb is the integer part and
+     *         the others are the fraction
+     */
+    std::vector<GLuint> limbs;
+
+    BigFloat(GLuint limbCount = 2, GLdouble value = 0.0);
+    static BigFloat fromString(std::string text, GLuint limbCount);
+    static GLuint getLimbCount(GLdouble precision);
+    GLuint isNegative() const;
+    BigFloat negate() const;
+    BigFloat add(const BigFloat& other) const;
+    BigFloat subtract(const BigFloat& other) const;
+    BigFloat multiply(const BigFloat& other) const;
+    GLvoid multiplySmall(GLuint factor);
+    GLvoid divideSmall(GLuint divisor);
+    GLdouble toDouble() const;
+    std::string toString(GLuint digitCount) const;
+};
+
+#endif
@@ -0,0 +1,326 @@
+/**
+ * [Program description]
+ */
+
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "capture.hpp"
+
+/**
+ * Constructor to create a capture which is not yet capturing.
+ */
+FrameCapture::FrameCapture()
+{
+  width = 0;
+  height = 0;
+  format = PPM;
+  isCapturing = false;
+  nextSlot = 0;
+  isStopping = false;
+  frameCount = 0;
+  droppedFrameCount = 0;
+}
+
+/**
+ * Start capturing frames of the given size, which are written to a new
+ * directory of PPM images or a new Y4M video in the `captures` directory,
+ * named after the time the capture started.
+ *
+ * Frames are read back into a ring of pixel buffers, so reading a frame only
+ * queues a copy on the GPU, and a fence marks when the copy has finished. The
+ * finished frames are handed to a background thread which encodes them, so
+ * neither the GPU nor the render loop waits for the disk.
+ */
+GLvoid FrameCapture::start(GLuint desiredWidth, GLuint desiredHeight,
+                           Format desiredFormat, GLuint frameRate)
+{
+  GLchar name[64];
+  time_t now = time(nullptr);
+
+  width = desiredWidth;
+  height = desiredHeight;
+  format = desiredFormat;
+  frameCount = 0;
+  droppedFrameCount = 0;
+  isStopping = false;
+
+  strftime(name, sizeof(name), "captures/capture-%Y%m%d-%H%M%S",
+           localtime(&now));
+  mkdir("captures", 0755);
+
+  if (format == Y4M) {
+    path = std::string(name) + ".y4m";
+    file.open(path.c_str(), std::ios::binary);
+
+    // The frames are stored without chroma subsampling, since frame sizes
+    // with odd dimensions can't be halved, and in full range, which players
+    // only assume when the header says so.
+    file << "YUV4MPEG2 W" << width << " H" << height << " F" << frameRate
+         << ":1 Ip A1:1 C444 XCOLORRANGE=FULL\n";
+  } else {
+    path = name;
+    mkdir(path.c_str(), 0755);
+  }
+
+  if ((format == Y4M && !file) ||
+      (format == PPM && access(path.c_str(), W_OK) != 0)) {
+    fprintf(stderr, "failed to start capture: %s\n", path.c_str());
+
+    exit(EXIT_FAILURE);
+  }
+
+  slots = std::vector<Slot>(CAPTURE_RING_SIZE);
+  nextSlot = 0;
+
+  for (Slot& slot : slots) {
+    glGenBuffers(1, &slot.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, nullptr,
+                 GL_STREAM_READ);
+    slot.fence = nullptr;
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  thread = std::thread(&FrameCapture::encodeFrames, this);
+  isCapturing = true;
+
+  printf("capturing to %s\n", path.c_str());
+}
+
+/**
+ * Capture the frame which has just been drawn. Any earlier frames which have
+ * finished reading back are collected first, so a frame normally reaches the
+ * encoder one frame after it is drawn. The render loop only waits when every
+ * slot of the ring is still being read back.
+ */
+GLvoid FrameCapture::captureFrame()
+{
+  if (!isCapturing) {
+    return;
+  }
+
+  collectFrames(false);
+
+  Slot& slot = slots[nextSlot];
+
+  if (slot.fence != nullptr) {
+    collectSlot(slot, true);
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  nextSlot = (nextSlot + 1) % slots.size();
+}
+
+/**
+ * Collect the frames which have been read back, from the oldest onwards, so
+ * that they are encoded in order.
+ */
+GLvoid FrameCapture::collectFrames(GLuint isWaiting)
+{
+  for (GLuint i = 0; i < slots.size(); i++) {
+    Slot& slot = slots[(nextSlot + i) % slots.size()];
+
+    if (slot.fence != nullptr && !collectSlot(slot, isWaiting)) {
+      break;
+    }
+  }
+}
+
+/**
+ * Queue the frame of a slot for encoding, if it has finished reading back, or
+ * once it has when waiting. Returns whether the frame was collected.
+ */
+GLuint FrameCapture::collectSlot(Slot& slot, GLuint isWaiting)
+{
+  GLenum status;
+
+  do {
+    status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                              isWaiting ? 1000000000 : 0);
+  } while (isWaiting && status == GL_TIMEOUT_EXPIRED);
+
+  if (status == GL_TIMEOUT_EXPIRED) {
+    return false;
+  }
+
+  glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+  frameCount++;
+
+  std::vector<GLubyte> pixels;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Drop the frame rather than stall the render loop when the encoder
+    // can't keep up.
+    if (queue.size() >= CAPTURE_QUEUE_LENGTH) {
+      droppedFrameCount++;
+      return true;
+    }
+
+    if (!pool.empty()) {
+      pixels.swap(pool.back());
+      pool.pop_back();
+    }
+  }
+
+  pixels.resize(width * height * 4);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  const GLvoid* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                        pixels.size(), GL_MAP_READ_BIT);
+  if (data != nullptr) {
+    memcpy(pixels.data(), data, pixels.size());
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(std::move(pixels));
+  }
+
+  condition.notify_one();
+
+  return true;
+}
+
+/**
+ * Stop capturing, once the frames still being read back and encoded have
+ * been written.
+ */
+GLvoid FrameCapture::stop()
+{
+  if (!isCapturing) {
+    return;
+  }
+
+  collectFrames(true);
+
+  for (Slot& slot : slots) {
+    glDeleteBuffers(1, &slot.buffer);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isStopping = true;
+  }
+
+  condition.notify_one();
+  thread.join();
+
+  if (format == Y4M) {
+    file.close();
+  }
+
+  isCapturing = false;
+  pool.clear();
+
+  printf("captured %d frames to %s", frameCount - droppedFrameCount,
+         path.c_str());
+  if (droppedFrameCount > 0) {
+    printf(" (%d dropped)", droppedFrameCount);
+  }
+  printf("\n");
+}
+
+/**
+ * Encode the queued frames on the background thread until the capture stops.
+ */
+GLvoid FrameCapture::encodeFrames()
+{
+  GLuint index = 0;
+
+  while (true) {
+    std::vector<GLubyte> pixels;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      condition.wait(lock, [this]() { return !queue.empty() || isStopping; });
+
+      if (queue.empty()) {
+        return;
+      }
+
+      pixels.swap(queue.front());
+      queue.pop_front();
+    }
+
+    if (format == Y4M) {
+      writeY4m(pixels);
+    } else {
+      writePpm(pixels, index);
+    }
+
+    index++;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pool.push_back(std::move(pixels));
+  }
+}
+
+/**
+ * Write a frame as a binary PPM image. OpenGL stores the bottom row first, so
+ * the rows are written in reverse.
+ */
+GLvoid FrameCapture::writePpm(std::vector<GLubyte>& pixels, GLuint index)
+{
+  GLchar filename[32];
+  std::vector<GLubyte> row(width * 3);
+
+  snprintf(filename, sizeof(filename), "/frame-%05d.ppm", index);
+
+  std::ofstream image((path + filename).c_str(), std::ios::binary);
+  image << "P6\n" << width << " " << height << "\n255\n";
+
+  for (GLint y = height - 1; y >= 0; y--) {
+    const GLubyte* source = &pixels[y * width * 4];
+
+    for (GLuint x = 0; x < width; x++) {
+      row[x * 3]     = source[x * 4];
+      row[x * 3 + 1] = source[x * 4 + 1];
+      row[x * 3 + 2] = source[x * 4 + 2];
+    }
+
+    image.write((const GLchar*)row.data(), row.size());
+  }
+}
+
+/**
+ * Write a frame to the Y4M stream, converting it to full range BT.601 YCbCr
+ * with fixed point arithmetic. Each plane is written top row first.
+ */
+GLvoid FrameCapture::writeY4m(std::vector<GLubyte>& pixels)
+{
+  std::vector<GLubyte> planes(width * height * 3);
+  GLubyte* luma = &planes[0];
+  GLubyte* blue = &planes[width * height];
+  GLubyte* red = &planes[width * height * 2];
+
+  for (GLuint y = 0; y < height; y++) {
+    const GLubyte* source = &pixels[(height - 1 - y) * width * 4];
+    GLuint offset = y * width;
+
+    for (GLuint x = 0; x < width; x++) {
+      GLint r = source[x * 4];
+      GLint g = source[x * 4 + 1];
+      GLint b = source[x * 4 + 2];
+
+      luma[offset + x] = (77 * r + 150 * g + 29 * b + 128) >> 8;
+      blue[offset + x] = std::min((-43 * r - 85 * g + 128 * b + 32896) >> 8,
+                                  255);
+      red[offset + x]  = std::min((128 * r - 107 * g - 21 * b + 32896) >> 8,
+                                  255);
+    }
+  }
+
+  file << "FRAME\n";
+  file.write((const GLchar*)planes.data(), planes.size());
+}
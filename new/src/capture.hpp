@@ -0,0 +1,76 @@
+/**
+ * [Program description]
+ */
+
+#ifndef CAPTURE_HEADER
+#define CAPTURE_HEADER
+
+#define CAPTURE_RING_SIZE 3
+#define CAPTURE_QUEUE_LENGTH 8
+
+class FrameCapture
+{
+  public:
+    typedef enum {
+      PPM,
+      Y4M
+    } Format;
+
+    typedef struct {
+      GLuint buffer;
+      GLsync fence;
+    } Slot;
+
+    /**
+     * width - width of the captured frames (in pixels)
+     * height - height of the captured frames (in pixels)
+     * format - format the frames are encoded in
+     * path - directory or file the frames are written to
+     * isCapturing - whether frames are being captured
+     *
+     * slots - ring of pixel buffers which frames are read back into
+     * nextSlot - position of the slot the next frame is read into, which is
+     *            also the oldest frame still being read back
+     *
+     * thread - background thread which encodes the frames
+     * mutex - lock on the frame queue and pool
+     * condition - signals the encoder when a frame is queued
+     * queue - frames waiting to be encoded
+     * pool - frame buffers which are free to reuse
+     * isStopping - whether the encoder should stop once the queue is empty
+     * file - stream the frames are written to, for the Y4M format
+     * frameCount - number of frames read back in this capture
+     * droppedFrameCount - number of frames dropped while the encoder was busy
+     */
+    GLuint width;
+    GLuint height;
+    Format format;
+    std::string path;
+    GLuint isCapturing;
+
+    std::vector<Slot> slots;
+    GLuint nextSlot;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::vector<GLubyte>> queue;
+    std::vector<std::vector<GLubyte>> pool;
+    GLuint isStopping;
+    std::ofstream file;
+    GLuint frameCount;
+    GLuint droppedFrameCount;
+
+    FrameCapture();
+    GLvoid start(GLuint desiredWidth, GLuint desiredHeight,
+                 Format desiredFormat, GLuint frameRate);
+    GLvoid captureFrame();
+    GLvoid collectFrames(GLuint isWaiting);
+    GLuint collectSlot(Slot& slot, GLuint isWaiting);
+    GLvoid stop();
+    GLvoid encodeFrames();
+    GLvoid writePpm(std::vector<GLubyte>& pixels, GLuint index);
+    GLvoid writeY4m(std::vector<GLubyte>& pixels);
+};
+
+#endif
@@ -0,0 +1,448 @@
+/**
+ * [Program description]
+ */
+
+#include <float.h>
+#include <limits.h>
+
+#include "chaosgame.hpp"
+
+/**
+ * Constructor to create a chaos game of one of the preset iterated function
+ * systems, from the profile's values.
+ */
+ChaosGame::ChaosGame(std::map<std::string, GLfloat>& env)
+{
+  type = (Type)std::min((GLuint)env["chaosType"],
+                        (GLuint)SIERPINSKI_TETRAHEDRON);
+  iterationCount = std::min(std::max(env["chaosIterationCount"], 1.0f),
+                            (GLfloat)CHAOS_ITERATION_LIMIT);
+
+  std::vector<Map> presetMaps;
+
+  // Maps are given as {matrix}, {translation}, probability.
+  switch (type) {
+    case BARNSLEY_FERN:
+      presetMaps = {
+        {{0.0f, 0.0f, 0.0f, 0.0f, 0.16f, 0.0f, 0.0f, 0.0f, 0.0f},
+         {0.0f, 0.0f, 0.0f}, 0.01f},
+        {{0.85f, 0.04f, 0.0f, -0.04f, 0.85f, 0.0f, 0.0f, 0.0f, 0.0f},
+         {0.0f, 1.6f, 0.0f}, 0.85f},
+        {{0.2f, -0.26f, 0.0f, 0.23f, 0.22f, 0.0f, 0.0f, 0.0f, 0.0f},
+         {0.0f, 1.6f, 0.0f}, 0.07f},
+        {{-0.15f, 0.28f, 0.0f, 0.26f, 0.24f, 0.0f, 0.0f, 0.0f, 0.0f},
+         {0.0f, 0.44f, 0.0f}, 0.07f}
+      };
+      setMaps(presetMaps, 2);
+      break;
+    case SIERPINSKI_TRIANGLE:
+      for (GLuint i = 0; i < 3; i++) {
+        Map map = {{0.5f, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f},
+                   {0.5f * (i == 1) + 0.25f * (i == 2),
+                    0.4330127f * (i == 2), 0.0f}, 1.0f};
+
+        presetMaps.push_back(map);
+      }
+      setMaps(presetMaps, 2);
+      break;
+    case HEIGHWAY_DRAGON:
+      presetMaps = {
+        {{0.5f, -0.5f, 0.0f, 0.5f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f},
+         {0.0f, 0.0f, 0.0f}, 0.5f},
+        {{-0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f},
+         {1.0f, 0.0f, 0.0f}, 0.5f}
+      };
+      setMaps(presetMaps, 2);
+      break;
+    case SIERPINSKI_TETRAHEDRON:
+      // Each map halves the distance to one corner of the tetrahedron.
+      for (GLuint i = 0; i < 4; i++) {
+        Map map = {{0.5f, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f, 0.0f, 0.5f},
+                   {(i == 0 || i == 1) ? 0.5f : -0.5f,
+                    (i == 0 || i == 2) ? 0.5f : -0.5f,
+                    (i == 0 || i == 3) ? 0.5f : -0.5f}, 1.0f};
+
+        presetMaps.push_back(map);
+      }
+      setMaps(presetMaps, 3);
+      break;
+  }
+}
+
+/**
+ * Get the name of a preset iterated function system.
+ */
+const GLchar* ChaosGame::getName(GLuint type)
+{
+  const GLchar* names[] = {"Barnsley fern", "Sierpinski triangle",
+                           "Heighway dragon", "Sierpinski tetrahedron"};
+
+  return names[std::min(type, (GLuint)SIERPINSKI_TETRAHEDRON)];
+}
+
+/**
+ * Load the maps from a file, with one map per line. A 2D map is given as
+ * "a b c d e f p", for x' = ax + by + e and y' = cx + dy + f, chosen with
+ * probability p. A 3D map is given as its matrix's rows, its translation and
+ * its probability. Lines starting with # are skipped.
+ */
+GLvoid ChaosGame::loadMaps(const GLchar* filename)
+{
+  std::ifstream file(filename);
+  std::string line;
+  std::vector<Map> loadedMaps;
+  GLuint loadedDimensionCount = 0;
+
+  if (!file) {
+    fprintf(stderr, "failed to read maps: %s\n", filename);
+    exit(EXIT_FAILURE);
+  }
+
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+    std::vector<GLfloat> values;
+    GLfloat value;
+
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    while (stream >> value) {
+      values.push_back(value);
+    }
+
+    GLuint lineDimensionCount = (values.size() == 7) ? 2 :
+                                (values.size() == 13) ? 3 : 0;
+
+    if (values.empty()) {
+      continue;
+    }
+
+    if (lineDimensionCount == 0 || (loadedDimensionCount != 0 &&
+                                    lineDimensionCount !=
+                                    loadedDimensionCount)) {
+      fprintf(stderr, "invalid map in %s: %s\n", filename, line.c_str());
+      exit(EXIT_FAILURE);
+    }
+
+    Map map = {{0.0f}, {0.0f}, values.back()};
+
+    if (lineDimensionCount == 2) {
+      map.matrix[0] = values[0];
+      map.matrix[1] = values[1];
+      map.matrix[3] = values[2];
+      map.matrix[4] = values[3];
+      map.translation[0] = values[4];
+      map.translation[1] = values[5];
+    } else {
+      std::copy(values.begin(), values.begin() + 9, map.matrix);
+      std::copy(values.begin() + 9, values.begin() + 12, map.translation);
+    }
+
+    loadedDimensionCount = lineDimensionCount;
+    loadedMaps.push_back(map);
+  }
+
+  if (loadedMaps.empty()) {
+    fprintf(stderr, "no maps in %s\n", filename);
+    exit(EXIT_FAILURE);
+  }
+
+  setMaps(loadedMaps, loadedDimensionCount);
+}
+
+/**
+ * Set the maps, and build the alias table which chooses between them with
+ * one random number whatever their probabilities (Vose's alias method).
+ */
+GLvoid ChaosGame::setMaps(const std::vector<Map>& desiredMaps,
+                          GLuint desiredDimensionCount)
+{
+  GLuint mapCount = desiredMaps.size();
+  std::vector<GLdouble> scaledProbabilities(mapCount);
+  std::vector<GLuint> small, large;
+  GLdouble totalProbability = 0.0;
+
+  maps = desiredMaps;
+  dimensionCount = desiredDimensionCount;
+
+  for (GLuint i = 0; i < mapCount; i++) {
+    totalProbability += std::max(maps[i].probability, 0.0f);
+  }
+
+  if (totalProbability <= 0.0) {
+    fprintf(stderr, "maps have no probability\n");
+    exit(EXIT_FAILURE);
+  }
+
+  thresholds = std::vector<GLuint64>(mapCount, 1ull << 32);
+  aliases = std::vector<GLuint>(mapCount);
+
+  for (GLuint i = 0; i < mapCount; i++) {
+    scaledProbabilities[i] = std::max(maps[i].probability, 0.0f) * mapCount /
+                             totalProbability;
+    aliases[i] = i;
+    (scaledProbabilities[i] < 1.0 ? small : large).push_back(i);
+  }
+
+  // Fill each slot of a map with too little probability from a map with too
+  // much.
+  while (!small.empty() && !large.empty()) {
+    GLuint lesser = small.back(), greater = large.back();
+
+    small.pop_back();
+    large.pop_back();
+    thresholds[lesser] = scaledProbabilities[lesser] * 4294967296.0;
+    aliases[lesser] = greater;
+    scaledProbabilities[greater] -= 1.0 - scaledProbabilities[lesser];
+    (scaledProbabilities[greater] < 1.0 ? small : large).push_back(greater);
+  }
+
+  findBounds();
+}
+
+/**
+ * Find the bounds of the attractor from a short run of the chaos game.
+ */
+GLvoid ChaosGame::findBounds()
+{
+  GLuint64 state = 0;
+  glm::vec3 point(0.0f);
+
+  minimum = glm::vec3(FLT_MAX);
+  maximum = glm::vec3(-FLT_MAX);
+
+  for (GLuint i = 0; i < CHAOS_BOUNDS_ITERATION_COUNT + CHAOS_SKIP_COUNT;
+       i++) {
+    const Map& map = maps[chooseMap(getNextRandom(state))];
+    glm::vec3 next;
+
+    for (GLuint row = 0; row < 3; row++) {
+      next[row] = map.translation[row] + map.matrix[row * 3] * point.x +
+                  map.matrix[row * 3 + 1] * point.y +
+                  map.matrix[row * 3 + 2] * point.z;
+    }
+
+    point = next;
+
+    if (i >= CHAOS_SKIP_COUNT) {
+      minimum = glm::min(minimum, point);
+      maximum = glm::max(maximum, point);
+    }
+  }
+
+  glm::vec3 margin = (maximum - minimum) * CHAOS_BOUNDS_MARGIN;
+
+  minimum -= margin;
+  maximum += margin;
+}
+
+/**
+ * Run the chaos game and count the points which land in each cell of a
+ * histogram of the given size along each axis, as [x + sizeX * (y + sizeY *
+ * z)]. The attractor is scaled evenly to fit the axes with more than one cell,
+ * and centred in them.
+ *
+ * Each stream of iterations has its own random numbers, and the threads take
+ * the streams one at a time. Every thread counts into a histogram of its own,
+ * so the threads never share a cell, and the histograms are then added
+ * together with the cells split between the threads. Only as many threads run
+ * as have room for their histograms, and a thread adds its histogram to the
+ * total before a stream which could overflow one of its cells.
+ */
+GLvoid ChaosGame::accumulate(GLuint64 seed, const GLuint* sizes,
+                             std::vector<GLuint64>& histogram)
+{
+  GLuint cellCount = sizes[0] * sizes[1] * sizes[2];
+  GLfloat extent = 0.0f;
+  GLfloat origin[3], scales[3];
+
+  for (GLuint axis = 0; axis < 3; axis++) {
+    if (sizes[axis] > 1) {
+      extent = std::max(extent, maximum[axis] - minimum[axis]);
+    }
+  }
+
+  extent = std::max(extent, FLT_MIN);
+
+  for (GLuint axis = 0; axis < 3; axis++) {
+    origin[axis] = (minimum[axis] + maximum[axis] - extent) / 2.0f;
+    scales[axis] = (sizes[axis] > 1) ? sizes[axis] / extent : 0.0f;
+  }
+
+  GLuint64 threadLimit = CHAOS_HISTOGRAM_MEMORY_LIMIT /
+                         ((GLuint64)cellCount * sizeof(GLuint));
+  GLuint threadCount = std::min((GLuint64)getThreadCount(),
+                                std::max(threadLimit, (GLuint64)1));
+  GLuint64 streamLimit = iterationCount / CHAOS_STREAM_COUNT + 1;
+  std::vector<std::vector<GLuint>> threadHistograms(threadCount);
+  std::atomic<GLuint> nextStream(0);
+  std::mutex histogramMutex;
+
+  histogram = std::vector<GLuint64>(cellCount, 0);
+
+  runOnThreads([&](GLuint thread) {
+    if (thread >= threadCount) {
+      return;
+    }
+
+    std::vector<GLuint>& threadHistogram = threadHistograms[thread];
+    GLuint64 countedLimit = 0;
+    GLuint stream;
+
+    threadHistogram = std::vector<GLuint>(cellCount, 0);
+
+    // Add the histogram to the total before its next stream could overflow
+    // one of its cells, which has at most countedLimit points so far.
+    while ((stream = nextStream++) < CHAOS_STREAM_COUNT) {
+      if (countedLimit + streamLimit > UINT_MAX) {
+        std::lock_guard<std::mutex> lock(histogramMutex);
+
+        for (GLuint cell = 0; cell < cellCount; cell++) {
+          histogram[cell] += threadHistogram[cell];
+          threadHistogram[cell] = 0;
+        }
+
+        countedLimit = 0;
+      }
+
+      countedLimit += streamLimit;
+
+      if (dimensionCount == 2) {
+        iterateStream<2>(seed, stream, sizes, origin, scales,
+                         threadHistogram.data());
+      } else {
+        iterateStream<3>(seed, stream, sizes, origin, scales,
+                         threadHistogram.data());
+      }
+    }
+  });
+
+  runOnThreads([&](GLuint thread) {
+    GLuint start = (GLuint64)cellCount * thread / getThreadCount();
+    GLuint end = (GLuint64)cellCount * (thread + 1) / getThreadCount();
+
+    for (GLuint cell = start; cell < end; cell++) {
+      for (GLuint i = 0; i < threadCount; i++) {
+        histogram[cell] += threadHistograms[i][cell];
+      }
+    }
+  });
+}
+
+/**
+ * Run one stream of the chaos game into a histogram. The stream's share of
+ * the iterations is fixed by its index, and its random numbers by the seed
+ * and its index. Only the coordinates the maps use are transformed.
+ */
+template <GLuint dimensions>
+GLvoid ChaosGame::iterateStream(GLuint64 seed, GLuint stream,
+                                const GLuint* sizes, const GLfloat* origin,
+                                const GLfloat* scales, GLuint* histogram)
+{
+  GLuint64 state = seed ^ ((stream + 1) * 0x9e3779b97f4a7c15ull);
+  GLuint64 count = iterationCount / CHAOS_STREAM_COUNT +
+                   (stream < iterationCount % CHAOS_STREAM_COUNT);
+  GLfloat point[3] = {0.0f, 0.0f, 0.0f};
+
+  getNextRandom(state);
+
+  for (GLuint64 i = 0; i < count + CHAOS_SKIP_COUNT; i++) {
+    const Map& map = maps[chooseMap(getNextRandom(state))];
+    GLfloat next[dimensions];
+
+    for (GLuint row = 0; row < dimensions; row++) {
+      next[row] = map.translation[row];
+
+      for (GLuint column = 0; column < dimensions; column++) {
+        next[row] += map.matrix[row * 3 + column] * point[column];
+      }
+    }
+
+    std::copy(next, next + dimensions, point);
+
+    if (i < CHAOS_SKIP_COUNT) {
+      continue;
+    }
+
+    GLuint cell = 0, stride = 1, isInside = true;
+
+    for (GLuint axis = 0; axis < 3 && isInside; axis++) {
+      GLfloat position = (point[axis] - origin[axis]) * scales[axis];
+
+      isInside = position >= 0.0f && position < sizes[axis];
+      cell += isInside ? (GLuint)position * stride : 0;
+      stride *= sizes[axis];
+    }
+
+    if (isInside) {
+      histogram[cell]++;
+    }
+  }
+}
+
+/**
+ * Choose a map with a 64-bit random number. The top half picks a slot of the
+ * alias table, and the bottom half picks between its map and its alias.
+ */
+GLuint ChaosGame::chooseMap(GLuint64 random)
+{
+  GLuint slot = ((random >> 32) * maps.size()) >> 32;
+
+  return (random & 0xffffffffull) < thresholds[slot] ? slot : aliases[slot];
+}
+
+/**
+ * Run the chaos game into a cube of cells, and create a point at each cell
+ * which was landed in, in the cube from -1 to 1. The points are coloured by
+ * the log of their counts.
+ */
+GLvoid ChaosGame::createPointCloud(GLuint64 seed, GLuint resolution,
+                                   glm::vec3 colour,
+                                   std::vector<GLfloat>& vertexData)
+{
+  GLuint sizes[3] = {resolution, resolution, resolution};
+  std::vector<GLuint64> histogram;
+
+  accumulate(seed, sizes, histogram);
+
+  GLfloat logMaximum = log1pf(*std::max_element(histogram.begin(),
+                                                histogram.end()));
+
+  vertexData.clear();
+
+  for (GLuint i = 0; i < histogram.size(); i++) {
+    if (histogram[i] == 0) {
+      continue;
+    }
+
+    GLfloat brightness = 0.25f + 0.75f * log1pf(histogram[i]) / logMaximum;
+    GLuint cell[3] = {i % resolution, i / resolution % resolution,
+                      i / (resolution * resolution)};
+
+    for (GLuint axis = 0; axis < 3; axis++) {
+      vertexData.push_back((cell[axis] + 0.5f) * 2.0f / resolution - 1.0f);
+    }
+
+    vertexData.push_back(0.0f);
+    vertexData.push_back(1.0f);
+    vertexData.push_back(0.0f);
+
+    for (GLuint channel = 0; channel < 3; channel++) {
+      vertexData.push_back(colour[channel] * brightness);
+    }
+  }
+}
+
+/**
+ * Get the next random number of a stream (SplitMix64).
+ */
+GLuint64 ChaosGame::getNextRandom(GLuint64& state)
+{
+  GLuint64 value = (state += 0x9e3779b97f4a7c15ull);
+
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+
+  return value ^ (value >> 31);
+}
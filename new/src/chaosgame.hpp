@@ -0,0 +1,88 @@
+/**
+ * [Program description]
+ */
+
+#ifndef CHAOS_GAME_HEADER
+#define CHAOS_GAME_HEADER
+
+// Number of random number streams the iterations are split between, which
+// the threads take one at a time. The histogram is the same for any number of
+// threads.
+#define CHAOS_STREAM_COUNT 256
+
+// Largest number of iterations, which keeps each stream's share of them
+// within the range of a cell of a thread's histogram.
+#define CHAOS_ITERATION_LIMIT ((GLuint64)CHAOS_STREAM_COUNT << 31)
+
+// Largest number of bytes of the threads' histograms together. Fewer threads
+// run the chaos game when each histogram is too large for all of them.
+#define CHAOS_HISTOGRAM_MEMORY_LIMIT (1ull << 30)
+
+// Number of iterations of each stream skipped while its point moves onto the
+// attractor.
+#define CHAOS_SKIP_COUNT 32
+
+// Number of iterations used to find the bounds of the attractor.
+#define CHAOS_BOUNDS_ITERATION_COUNT 100000
+
+// Fraction of the attractor's size added around it, for points the bounds
+// missed.
+#define CHAOS_BOUNDS_MARGIN 0.02f
+
+class ChaosGame
+{
+  public:
+    typedef enum {
+      BARNSLEY_FERN,
+      SIERPINSKI_TRIANGLE,
+      HEIGHWAY_DRAGON,
+      SIERPINSKI_TETRAHEDRON
+    } Type;
+
+    // Affine map of x' = matrix * x + translation, with the matrix's rows in
+    // order, chosen with the given probability.
+    typedef struct {
+      GLfloat matrix[9];
+      GLfloat translation[3];
+      GLfloat probability;
+    } Map;
+
+    /**
+     * type - preset set of maps
+     * iterationCount - number of iterations of the chaos game
+     * maps - affine maps of the iterated function system
+     * dimensionCount - number of coordinates the maps use (2 or 3)
+     * thresholds - chance of each slot of the alias table choosing its own
+     *              map rather than its alias, out of 2^32
+     * aliases - map chosen by each slot of the alias table otherwise
+     * minimum - lowest corner of the attractor's bounds
+     * maximum - highest corner of the attractor's bounds
+     */
+    Type type;
+    GLuint64 iterationCount;
+    std::vector<Map> maps;
+    GLuint dimensionCount;
+    std::vector<GLuint64> thresholds;
+    std::vector<GLuint> aliases;
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+
+    ChaosGame(std::map<std::string, GLfloat>& env);
+    static const GLchar* getName(GLuint type);
+    GLvoid loadMaps(const GLchar* filename);
+    GLvoid setMaps(const std::vector<Map>& desiredMaps,
+                   GLuint desiredDimensionCount);
+    GLvoid findBounds();
+    GLvoid accumulate(GLuint64 seed, const GLuint* sizes,
+                      std::vector<GLuint64>& histogram);
+    template <GLuint dimensions>
+    GLvoid iterateStream(GLuint64 seed, GLuint stream, const GLuint* sizes,
+                         const GLfloat* origin, const GLfloat* scales,
+                         GLuint* histogram);
+    GLuint chooseMap(GLuint64 random);
+    GLvoid createPointCloud(GLuint64 seed, GLuint resolution,
+                            glm::vec3 colour, std::vector<GLfloat>& vertexData);
+    static GLuint64 getNextRandom(GLuint64& state);
+};
+
+#endif
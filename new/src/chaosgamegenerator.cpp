@@ -0,0 +1,57 @@
+/**
+ * [Program description]
+ */
+
+#include <float.h>
+
+#include "chaosgamegenerator.hpp"
+
+/**
+ * Constructor to create a generator of the density of an iterated function
+ * system's attractor, from the profile's values.
+ */
+ChaosGameGenerator::ChaosGameGenerator(std::map<std::string, GLfloat>& env) :
+  chaosGame(env)
+{
+  isPeriodic = false;
+  yRange = env["fractalYRange"];
+  baseColour = glm::vec3(env["fractalColourRed"], env["fractalColourGreen"],
+                         env["fractalColourBlue"]);
+}
+
+/**
+ * Generate the heights from the number of chaos game points which land on
+ * each point of the plane, along the first two axes of the maps. The counts
+ * span many orders of magnitude, so the heights and colours follow their
+ * logs, and points which are never landed on are left at zero.
+ */
+GLvoid ChaosGameGenerator::generate(HeightPlane& plane)
+{
+  GLuint size = plane.size;
+  GLuint sizes[3] = {size, size, 1};
+  GLuint64 seed = ((GLuint64)rand() << 32) ^ rand();
+  std::vector<GLuint64> histogram;
+
+  chaosGame.accumulate(seed, sizes, histogram);
+
+  GLfloat logMaximum = std::max(log1pf(*std::max_element(histogram.begin(),
+                                                         histogram.end())),
+                                FLT_MIN);
+
+  if (plane.isQuantised) {
+    plane.setRange(0.0f, yRange);
+  }
+
+  colours = std::vector<glm::vec3>(size * size);
+
+  // Rows of the plane follow the maps' Y axis, so the attractor is upright
+  // when viewed along the plane's X axis.
+  for (GLuint x = 0; x < size; x++) {
+    for (GLuint z = 0; z < size; z++) {
+      GLfloat density = log1pf(histogram[x * size + z]) / logMaximum;
+
+      plane.set(x, z, yRange * density);
+      colours[x * size + z] = baseColour * (0.25f + 0.75f * density);
+    }
+  }
+}
@@ -0,0 +1,24 @@
+/**
+ * [Program description]
+ */
+
+#ifndef CHAOS_GAME_GENERATOR_HEADER
+#define CHAOS_GAME_GENERATOR_HEADER
+
+class ChaosGameGenerator : public Generator
+{
+  public:
+    /**
+     * yRange - Y value of the densest points
+     * baseColour - colour of the densest points
+     * chaosGame - chaos game of the iterated function system
+     */
+    GLfloat yRange;
+    glm::vec3 baseColour;
+    ChaosGame chaosGame;
+
+    ChaosGameGenerator(std::map<std::string, GLfloat>& env);
+    GLvoid generate(HeightPlane& plane);
+};
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ * [Program description]
+ */
+
+#include "culler.hpp"
+
+/**
+ * Constructor to create an empty culler.
+ */
+Culler::Culler()
+{
+  visibleChunkCount = 0;
+  visibleIndexCount = 0;
+
+  for (GLuint i = 0; i < HORIZON_BIN_COUNT; i++) {
+    horizon[i] = -INFINITY;
+  }
+}
+
+/**
+ * Extract the six frustum planes from a combined model-view-projection matrix
+ * so that the planes are expressed in the model's coordinate space.
+ */
+GLvoid Culler::updateFrustum(glm::mat4 modelViewProjection)
+{
+  glm::vec4 rows[4];
+
+  for (GLuint i = 0; i < 4; i++) {
+    rows[i] = glm::vec4(modelViewProjection[0][i], modelViewProjection[1][i],
+                        modelViewProjection[2][i], modelViewProjection[3][i]);
+  }
+
+  frustumPlanes[0] = rows[3] + rows[0]; // left
+  frustumPlanes[1] = rows[3] - rows[0]; // right
+  frustumPlanes[2] = rows[3] + rows[1]; // bottom
+  frustumPlanes[3] = rows[3] - rows[1]; // top
+  frustumPlanes[4] = rows[3] + rows[2]; // near
+  frustumPlanes[5] = rows[3] - rows[2]; // far
+}
+
+/**
+ * Check whether an axis-aligned bounding box is at least partially inside the
+ * frustum. Only the corner furthest along each plane's normal is tested.
+ */
+GLuint Culler::isBoxInFrustum(glm::vec3 minimum, glm::vec3 maximum)
+{
+  for (GLuint i = 0; i < 6; i++) {
+    glm::vec4 plane = frustumPlanes[i];
+    glm::vec3 corner(plane.x > 0.0f ? maximum.x : minimum.x,
+                     plane.y > 0.0f ? maximum.y : minimum.y,
+                     plane.z > 0.0f ? maximum.z : minimum.z);
+
+    if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z +
+        plane.w < 0.0f) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Check whether the given slope lies below the horizon across every bin in
+ * the (wrapping) range of azimuth bins.
+ */
+GLuint Culler::isBoxBelowHorizon(GLint firstBin, GLint lastBin, GLfloat slope)
+{
+  if (lastBin - firstBin >= HORIZON_BIN_COUNT) {
+    return false;
+  }
+
+  for (GLint bin = firstBin; bin <= lastBin; bin++) {
+    GLint index = ((bin % HORIZON_BIN_COUNT) + HORIZON_BIN_COUNT) %
+                  HORIZON_BIN_COUNT;
+
+    if (horizon[index] <= slope) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Raise the horizon to at least the given slope across the (wrapping) range
+ * of azimuth bins.
+ */
+GLvoid Culler::raiseHorizon(GLint firstBin, GLint lastBin, GLfloat slope)
+{
+  for (GLint bin = firstBin; bin <= lastBin; bin++) {
+    GLint index = ((bin % HORIZON_BIN_COUNT) + HORIZON_BIN_COUNT) %
+                  HORIZON_BIN_COUNT;
+
+    horizon[index] = std::max(horizon[index], slope);
+  }
+}
+
+/**
+ * Determine which chunks of the fractal are visible and build the lists of
+ * index ranges used by glMultiDrawElements(), for both the
+ * triangles and the wireframe lines.
+ *
+ * Chunks outside the frustum are discarded first. If horizon culling is
+ * enabled, the remaining chunks are then processed front to back while a
+ * horizon is built from the chunks nearer to the camera. A chunk's lowest
+ * point at its furthest distance is guaranteed to block every ray in its
+ * azimuth range which passes underneath it, so a chunk whose highest point is
+ * below this horizon cannot be seen.
+ */
+GLvoid Culler::cullChunks(Fractal& fractal, glm::mat4 model, glm::mat4 view,
+                          glm::mat4 projection, glm::vec3 cameraPosition,
+                          GLuint isHorizonCullingEnabled)
+{
+  using namespace glm;
+
+  GLuint chunkTotal = fractal.chunkCount * fractal.chunkCount;
+  std::vector<ChunkSpan> spans;
+  vec4 camera = inverse(model) * vec4(cameraPosition, 1.0f);
+  GLfloat binScale = HORIZON_BIN_COUNT / (2.0f * M_PI);
+
+  updateFrustum(projection * view * model);
+
+  visibleCounts.clear();
+  visibleOffsets.clear();
+  visibleLineCounts.clear();
+  visibleLineOffsets.clear();
+  visibleIndexCount = 0;
+
+  for (GLuint chunk = 0; chunk < chunkTotal; chunk++) {
+    vec3 minimum = fractal.getChunkMinimum(chunk);
+    vec3 maximum = fractal.getChunkMaximum(chunk);
+
+    if (!isBoxInFrustum(minimum, maximum)) {
+      continue;
+    }
+
+    ChunkSpan span;
+    span.chunk = chunk;
+
+    // Horizontal distances from the camera to the chunk's footprint.
+    GLfloat dx = std::max(std::max(minimum.x - camera.x, camera.x - maximum.x),
+                          0.0f);
+    GLfloat dz = std::max(std::max(minimum.z - camera.z, camera.z - maximum.z),
+                          0.0f);
+    GLfloat fx = std::max(fabs(minimum.x - camera.x), fabs(maximum.x - camera.x));
+    GLfloat fz = std::max(fabs(minimum.z - camera.z), fabs(maximum.z - camera.z));
+    span.nearest = sqrt(dx * dx + dz * dz);
+    span.farthest = sqrt(fx * fx + fz * fz);
+
+    // Azimuth range covered by the footprint, relative to its centre.
+    GLfloat centre = atan2(0.5f * (minimum.z + maximum.z) - camera.z,
+                           0.5f * (minimum.x + maximum.x) - camera.x);
+    GLfloat low = 0.0f, high = 0.0f;
+
+    for (GLuint i = 0; i < 4; i++) {
+      GLfloat angle = atan2(((i & 2) ? maximum.z : minimum.z) - camera.z,
+                            ((i & 1) ? maximum.x : minimum.x) - camera.x) -
+                      centre;
+
+      if (angle > M_PI) {
+        angle -= 2.0f * M_PI;
+      } else if (angle < -M_PI) {
+        angle += 2.0f * M_PI;
+      }
+
+      low = std::min(low, angle);
+      high = std::max(high, angle);
+    }
+
+    span.firstBin = (centre + low + M_PI) * binScale;
+    span.lastBin = (centre + high + M_PI) * binScale;
+    spans.push_back(span);
+  }
+
+  if (isHorizonCullingEnabled) {
+    std::vector<ChunkSpan> occluders = spans;
+    GLuint occluder = 0;
+
+    for (GLuint i = 0; i < HORIZON_BIN_COUNT; i++) {
+      horizon[i] = -INFINITY;
+    }
+
+    std::sort(spans.begin(), spans.end(),
+              [](const ChunkSpan& a, const ChunkSpan& b) {
+                return a.nearest < b.nearest;
+              });
+    std::sort(occluders.begin(), occluders.end(),
+              [](const ChunkSpan& a, const ChunkSpan& b) {
+                return a.farthest < b.farthest;
+              });
+
+    GLuint remaining = 0;
+
+    for (GLuint i = 0; i < spans.size(); i++) {
+      ChunkSpan span = spans[i];
+
+      // Only chunks which lie entirely in front of this one may occlude it.
+      while (occluder < occluders.size() &&
+             occluders[occluder].farthest <= span.nearest) {
+        ChunkSpan blocker = occluders[occluder++];
+
+        if (blocker.nearest > 0.0f) {
+          GLfloat height = fractal.chunkMinHeights[blocker.chunk] - camera.y;
+          GLfloat slope = height / ((height > 0.0f) ? blocker.farthest :
+                                                      blocker.nearest);
+
+          raiseHorizon(ceil(blocker.firstBin), floor(blocker.lastBin) - 1,
+                       slope);
+        }
+      }
+
+      if (span.nearest > 0.0f) {
+        GLfloat height = fractal.chunkMaxHeights[span.chunk] - camera.y;
+        GLfloat slope = height / ((height > 0.0f) ? span.nearest :
+                                                    span.farthest);
+
+        if (isBoxBelowHorizon(floor(span.firstBin), floor(span.lastBin),
+                              slope)) {
+          continue;
+        }
+      }
+
+      spans[remaining++] = span;
+    }
+
+    spans.resize(remaining);
+  }
+
+  for (GLuint i = 0; i < spans.size(); i++) {
+    GLuint chunk = spans[i].chunk;
+
+    visibleCounts.push_back(fractal.chunkIndexCounts[chunk]);
+    visibleOffsets.push_back((const GLvoid*)(fractal.chunkIndexOffsets[chunk] *
+                                             sizeof(GLuint)));
+    visibleLineCounts.push_back(fractal.chunkLineCounts[chunk]);
+    visibleLineOffsets.push_back((const GLvoid*)
+                                 (fractal.chunkLineOffsets[chunk] *
+                                  sizeof(GLuint)));
+    visibleIndexCount += fractal.chunkIndexCounts[chunk];
+  }
+
+  visibleChunkCount = spans.size();
+}
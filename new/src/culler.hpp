@@ -0,0 +1,52 @@
+/**
+ * [Program description]
+ */
+
+#ifndef CULLER_HEADER
+#define CULLER_HEADER
+
+#define HORIZON_BIN_COUNT 256
+
+class Culler
+{
+  public:
+    typedef struct {
+      GLuint chunk;
+      GLfloat nearest;
+      GLfloat farthest;
+      GLfloat firstBin;
+      GLfloat lastBin;
+    } ChunkSpan;
+
+    /**
+     * frustumPlanes - clipping planes of the view frustum in model space
+     * horizon - highest occluding slope (dY/distance) per azimuth bin
+     *
+     * visibleCounts - index count of each chunk that survived culling
+     * visibleOffsets - byte offset of each chunk that survived culling
+     * visibleLineCounts - line index count of each visible chunk
+     * visibleLineOffsets - line byte offset of each visible chunk
+     * visibleChunkCount - number of chunks that survived culling
+     * visibleIndexCount - total number of indices that survived culling
+     */
+    glm::vec4 frustumPlanes[6];
+    GLfloat horizon[HORIZON_BIN_COUNT];
+
+    std::vector<GLsizei> visibleCounts;
+    std::vector<const GLvoid*> visibleOffsets;
+    std::vector<GLsizei> visibleLineCounts;
+    std::vector<const GLvoid*> visibleLineOffsets;
+    GLuint visibleChunkCount;
+    GLuint visibleIndexCount;
+
+    Culler();
+    GLvoid updateFrustum(glm::mat4 modelViewProjection);
+    GLuint isBoxInFrustum(glm::vec3 minimum, glm::vec3 maximum);
+    GLuint isBoxBelowHorizon(GLint firstBin, GLint lastBin, GLfloat slope);
+    GLvoid raiseHorizon(GLint firstBin, GLint lastBin, GLfloat slope);
+    GLvoid cullChunks(Fractal& fractal, glm::mat4 model, glm::mat4 view,
+                      glm::mat4 projection, glm::vec3 cameraPosition,
+                      GLuint isHorizonCullingEnabled);
+};
+
+#endif
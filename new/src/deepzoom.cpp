@@ -0,0 +1,322 @@
+/**
+ * [Program description]
+ */
+
+#include "deepzoom.hpp"
+
+/**
+ * Constructor to create a deep zoom of the Mandelbrot set, which iterates
+ * each point up to a given number of times.
+ */
+DeepZoom::DeepZoom(GLuint desiredIterationCount)
+{
+  iterationCount = desiredIterationCount;
+  size = 0;
+  step = 0.0;
+  skipCount = 0;
+  referenceCount = 0;
+}
+
+/**
+ * Calculate the smooth iteration count of each point of a square of the
+ * Mandelbrot set, whose centre is given as decimal text so that it keeps more
+ * precision than a double, or -1 for points which haven't escaped.
+ *
+ * Only the orbit of a reference point is calculated at full precision. Each
+ * point is iterated as a small difference (a perturbation) from the reference
+ * orbit in doubles:
+ *
+ *   d(n + 1) = 2 Z(n) d(n) + d(n)^2 + dc
+ *
+ * The first iterations of every point are skipped with a series in dc, and
+ * points whose perturbations lose their precision are recalculated from a new
+ * reference orbit at one of them, until none are left.
+ */
+GLvoid DeepZoom::calculate(const std::string& centreReal,
+                           const std::string& centreImaginary,
+                           GLdouble width, GLuint desiredSize,
+                           std::vector<GLfloat>& counts)
+{
+  size = desiredSize;
+  step = width / size;
+  referenceCount = 0;
+
+  GLuint limbCount = BigFloat::getLimbCount(step);
+  BigFloat real = BigFloat::fromString(centreReal, limbCount);
+  BigFloat imaginary = BigFloat::fromString(centreImaginary, limbCount);
+
+  calculateOrbit(real, imaginary);
+  calculateSeries(width / 2.0 * M_SQRT2);
+  checkSeries(width / 2.0);
+
+  glitches.clear();
+  calculatePoints(nullptr, size * size, 0.0, 0.0, counts);
+
+  // The series is only valid around the first reference.
+  GLuint firstSkipCount = skipCount;
+  skipCount = 0;
+
+  while (!glitches.empty() && referenceCount <= DEEP_ZOOM_REFERENCE_LIMIT) {
+    std::vector<GLuint> points;
+    points.swap(glitches);
+
+    GLuint reference = points[points.size() / 2];
+    GLdouble offsetReal = ((GLdouble)(reference % size) - size / 2.0) * step;
+    GLdouble offsetImaginary = ((GLdouble)(reference / size) - size / 2.0) *
+                               step;
+
+    calculateOrbit(real.add(BigFloat(limbCount, offsetReal)),
+                   imaginary.add(BigFloat(limbCount, offsetImaginary)));
+    calculatePoints(&points[0], points.size(), offsetReal, offsetImaginary,
+                    counts);
+  }
+
+  skipCount = firstSkipCount;
+}
+
+/**
+ * Calculate the orbit of a reference point at full precision, keeping each
+ * value rounded to doubles, until it escapes or reaches the last iteration.
+ */
+GLvoid DeepZoom::calculateOrbit(const BigFloat& real,
+                                const BigFloat& imaginary)
+{
+  GLuint limbCount = real.limbs.size();
+  BigFloat zReal(limbCount), zImaginary(limbCount);
+
+  orbitReals.clear();
+  orbitImaginaries.clear();
+  referenceCount++;
+
+  for (GLuint n = 0; n <= iterationCount; n++) {
+    GLdouble valueReal = zReal.toDouble();
+    GLdouble valueImaginary = zImaginary.toDouble();
+
+    orbitReals.push_back(valueReal);
+    orbitImaginaries.push_back(valueImaginary);
+
+    // Escaping here also keeps the squares within the integer limb.
+    if (valueReal * valueReal + valueImaginary * valueImaginary >
+        ESCAPE_BAILOUT) {
+      break;
+    }
+
+    BigFloat real2 = zReal.multiply(zReal);
+    BigFloat imaginary2 = zImaginary.multiply(zImaginary);
+    BigFloat product = zReal.multiply(zImaginary);
+
+    zReal = real2.subtract(imaginary2).add(real);
+    zImaginary = product.add(product).add(imaginary);
+  }
+}
+
+/**
+ * Calculate the coefficients of the series which approximates every point's
+ * perturbation from the reference orbit,
+ *
+ *   d(n) = A(n) dc + B(n) dc^2 + C(n) dc^3
+ *
+ * iteration by iteration, until the later terms are no longer small next to
+ * the earlier ones for points a given radius from the reference.
+ */
+GLvoid DeepZoom::calculateSeries(GLdouble radius)
+{
+  GLdouble aReal = 0.0, aImaginary = 0.0;
+  GLdouble bReal = 0.0, bImaginary = 0.0;
+  GLdouble cReal = 0.0, cImaginary = 0.0;
+
+  seriesCoefficients = std::vector<GLdouble>(6, 0.0);
+  skipCount = 0;
+
+  for (GLuint n = 0; n + 1 < orbitReals.size(); n++) {
+    GLdouble twoZReal = 2.0 * orbitReals[n];
+    GLdouble twoZImaginary = 2.0 * orbitImaginaries[n];
+
+    GLdouble newAReal = twoZReal * aReal - twoZImaginary * aImaginary + 1.0;
+    GLdouble newAImaginary = twoZReal * aImaginary + twoZImaginary * aReal;
+    GLdouble newBReal = twoZReal * bReal - twoZImaginary * bImaginary +
+                        aReal * aReal - aImaginary * aImaginary;
+    GLdouble newBImaginary = twoZReal * bImaginary + twoZImaginary * bReal +
+                             2.0 * aReal * aImaginary;
+    GLdouble newCReal = twoZReal * cReal - twoZImaginary * cImaginary +
+                        2.0 * (aReal * bReal - aImaginary * bImaginary);
+    GLdouble newCImaginary = twoZReal * cImaginary + twoZImaginary * cReal +
+                             2.0 * (aReal * bImaginary + aImaginary * bReal);
+
+    GLdouble a = hypot(newAReal, newAImaginary);
+    GLdouble b = hypot(newBReal, newBImaginary);
+    GLdouble c = hypot(newCReal, newCImaginary);
+
+    if (!std::isfinite(a * radius) || !std::isfinite(b * radius) ||
+        !std::isfinite(c * radius) ||
+        b * radius > DEEP_ZOOM_SERIES_TOLERANCE * a ||
+        c * radius > DEEP_ZOOM_SERIES_TOLERANCE * b) {
+      break;
+    }
+
+    aReal = newAReal;
+    aImaginary = newAImaginary;
+    bReal = newBReal;
+    bImaginary = newBImaginary;
+    cReal = newCReal;
+    cImaginary = newCImaginary;
+
+    GLdouble coefficients[6] = {aReal, aImaginary, bReal, bImaginary,
+                                cReal, cImaginary};
+    seriesCoefficients.insert(seriesCoefficients.end(), coefficients,
+                              coefficients + 6);
+    skipCount = n + 1;
+  }
+}
+
+/**
+ * Check the series approximation against perturbations iterated in full at
+ * the corners and edges of the square, and halve the number of skipped
+ * iterations until they agree.
+ */
+GLvoid DeepZoom::checkSeries(GLdouble radius)
+{
+  const GLdouble probes[8][2] = {
+    {-1.0, -1.0}, {1.0, -1.0}, {-1.0, 1.0}, {1.0, 1.0},
+    {-1.0, 0.0}, {1.0, 0.0}, {0.0, -1.0}, {0.0, 1.0}
+  };
+
+  for (GLuint i = 0; i < 8 && skipCount > 0; i++) {
+    GLdouble cReal = probes[i][0] * radius;
+    GLdouble cImaginary = probes[i][1] * radius;
+    GLdouble dReal = 0.0, dImaginary = 0.0;
+    std::vector<GLdouble> dReals(1, 0.0), dImaginaries(1, 0.0);
+
+    for (GLuint n = 0; n < skipCount; n++) {
+      GLdouble aReal = 2.0 * orbitReals[n] + dReal;
+      GLdouble aImaginary = 2.0 * orbitImaginaries[n] + dImaginary;
+      GLdouble newReal = aReal * dReal - aImaginary * dImaginary + cReal;
+
+      dImaginary = aReal * dImaginary + aImaginary * dReal + cImaginary;
+      dReal = newReal;
+      dReals.push_back(dReal);
+      dImaginaries.push_back(dImaginary);
+    }
+
+    // Later probes start from the skip count the earlier ones settled on.
+    while (skipCount > 0) {
+      const GLdouble* s = &seriesCoefficients[skipCount * 6];
+      GLdouble tReal = s[4] * cReal - s[5] * cImaginary + s[2];
+      GLdouble tImaginary = s[4] * cImaginary + s[5] * cReal + s[3];
+      GLdouble uReal = tReal * cReal - tImaginary * cImaginary + s[0];
+      GLdouble uImaginary = tReal * cImaginary + tImaginary * cReal + s[1];
+      GLdouble seriesReal = uReal * cReal - uImaginary * cImaginary;
+      GLdouble seriesImaginary = uReal * cImaginary + uImaginary * cReal;
+      GLdouble error = hypot(seriesReal - dReals[skipCount],
+                             seriesImaginary - dImaginaries[skipCount]);
+
+      if (error <= DEEP_ZOOM_PROBE_TOLERANCE *
+                   hypot(dReals[skipCount], dImaginaries[skipCount])) {
+        break;
+      }
+
+      skipCount /= 2;
+    }
+  }
+}
+
+/**
+ * Calculate the smooth iteration counts of a list of points, or of every
+ * point if there's no list, from the reference orbit at a given offset from
+ * the centre. The points are handed out to the threads a block at a time,
+ * and the glitched ones are added to the list of glitches.
+ */
+GLvoid DeepZoom::calculatePoints(const GLuint* indices, GLuint pointCount,
+                                 GLdouble offsetReal,
+                                 GLdouble offsetImaginary,
+                                 std::vector<GLfloat>& counts)
+{
+  std::vector<std::vector<GLuint>> threadGlitches(getThreadCount());
+  std::atomic<GLuint> nextBlock(0);
+
+  GLuint blockCount = (pointCount + DEEP_ZOOM_BLOCK_SIZE - 1) /
+                      DEEP_ZOOM_BLOCK_SIZE;
+
+  runOnThreads([&](GLuint thread) {
+    GLuint block;
+
+    while ((block = nextBlock++) < blockCount) {
+      GLuint end = std::min((block + 1) * DEEP_ZOOM_BLOCK_SIZE, pointCount);
+
+      for (GLuint j = block * DEEP_ZOOM_BLOCK_SIZE; j < end; j++) {
+        GLuint index = indices ? indices[j] : j;
+        GLdouble deltaReal = ((GLdouble)(index % size) - size / 2.0) *
+                             step - offsetReal;
+        GLdouble deltaImaginary = ((GLdouble)(index / size) - size / 2.0) *
+                                  step - offsetImaginary;
+        GLuint isGlitched;
+
+        counts[index] = iterate(deltaReal, deltaImaginary, isGlitched);
+
+        if (isGlitched) {
+          threadGlitches[thread].push_back(index);
+        }
+      }
+    }
+  });
+
+  for (std::vector<GLuint>& blockGlitches : threadGlitches) {
+    glitches.insert(glitches.end(), blockGlitches.begin(),
+                    blockGlitches.end());
+  }
+}
+
+/**
+ * Iterate a point's perturbation from the reference orbit, starting from the
+ * series approximation, and return its smooth iteration count, or -1 if it
+ * hasn't escaped after the last iteration.
+ *
+ * A point whose value gets much closer to the origin than the reference's
+ * (Pauldelbrot's criterion), or which outlives the reference orbit, is
+ * glitched and needs another reference.
+ */
+GLfloat DeepZoom::iterate(GLdouble deltaReal, GLdouble deltaImaginary,
+                          GLuint& isGlitched)
+{
+  const GLdouble* s = &seriesCoefficients[skipCount * 6];
+  GLdouble tReal = s[4] * deltaReal - s[5] * deltaImaginary + s[2];
+  GLdouble tImaginary = s[4] * deltaImaginary + s[5] * deltaReal + s[3];
+  GLdouble uReal = tReal * deltaReal - tImaginary * deltaImaginary + s[0];
+  GLdouble uImaginary = tReal * deltaImaginary + tImaginary * deltaReal + s[1];
+  GLdouble dReal = uReal * deltaReal - uImaginary * deltaImaginary;
+  GLdouble dImaginary = uReal * deltaImaginary + uImaginary * deltaReal;
+  GLuint orbitLength = orbitReals.size();
+
+  isGlitched = false;
+
+  for (GLuint n = skipCount; n < orbitLength; n++) {
+    GLdouble zReal = orbitReals[n] + dReal;
+    GLdouble zImaginary = orbitImaginaries[n] + dImaginary;
+    GLdouble modulus2 = zReal * zReal + zImaginary * zImaginary;
+
+    if (modulus2 > ESCAPE_BAILOUT) {
+      return std::max(n + 1.0 - log2(0.5 * log(modulus2)), 0.0);
+    }
+
+    if (n == iterationCount) {
+      return -1.0f;
+    }
+
+    if (modulus2 < DEEP_ZOOM_GLITCH_TOLERANCE *
+                   (orbitReals[n] * orbitReals[n] +
+                    orbitImaginaries[n] * orbitImaginaries[n])) {
+      break;
+    }
+
+    GLdouble aReal = 2.0 * orbitReals[n] + dReal;
+    GLdouble aImaginary = 2.0 * orbitImaginaries[n] + dImaginary;
+    GLdouble newReal = aReal * dReal - aImaginary * dImaginary + deltaReal;
+
+    dImaginary = aReal * dImaginary + aImaginary * dReal + deltaImaginary;
+    dReal = newReal;
+  }
+
+  isGlitched = true;
+
+  return 0.0f;
+}
@@ -0,0 +1,70 @@
+/**
+ * [Program description]
+ */
+
+#ifndef DEEP_ZOOM_HEADER
+#define DEEP_ZOOM_HEADER
+
+// Largest width of a point below which doubles can't place the points of the
+// Mandelbrot set apart, so the plane is calculated by perturbation instead.
+#define DEEP_ZOOM_STEP 1e-12
+
+// Squared ratio of a point's distance from the origin to its reference's,
+// below which its perturbation has lost its precision (a glitch).
+#define DEEP_ZOOM_GLITCH_TOLERANCE 1e-6
+
+// Number of points handed to a thread at a time.
+#define DEEP_ZOOM_BLOCK_SIZE 256
+
+// Largest number of extra reference orbits calculated for glitched points.
+#define DEEP_ZOOM_REFERENCE_LIMIT 64
+
+// Ratio of each term of the series approximation to the one before it, above
+// which the series is stopped.
+#define DEEP_ZOOM_SERIES_TOLERANCE 1e-3
+
+// Largest relative error of the series approximation at the probe points.
+#define DEEP_ZOOM_PROBE_TOLERANCE 1e-6
+
+class DeepZoom
+{
+  public:
+    /**
+     * iterationCount - largest number of iterations of each point
+     * size - number of points along each side of the plane
+     * step - distance between neighbouring points
+     *
+     * orbitReals - real parts of the reference orbit, rounded to doubles
+     * orbitImaginaries - imaginary parts of the reference orbit
+     * seriesCoefficients - coefficients A, B and C of the series approximation
+     *                      after each iteration, as real and imaginary parts
+     * skipCount - number of iterations skipped by the series approximation
+     * glitches - indices of the points whose perturbations are glitched
+     * referenceCount - number of reference orbits calculated
+     */
+    GLuint iterationCount;
+    GLuint size;
+    GLdouble step;
+
+    std::vector<GLdouble> orbitReals;
+    std::vector<GLdouble> orbitImaginaries;
+    std::vector<GLdouble> seriesCoefficients;
+    GLuint skipCount;
+    std::vector<GLuint> glitches;
+    GLuint referenceCount;
+
+    DeepZoom(GLuint desiredIterationCount);
+    GLvoid calculate(const std::string& centreReal,
+                     const std::string& centreImaginary, GLdouble width,
+                     GLuint desiredSize, std::vector<GLfloat>& counts);
+    GLvoid calculateOrbit(const BigFloat& real, const BigFloat& imaginary);
+    GLvoid calculateSeries(GLdouble radius);
+    GLvoid checkSeries(GLdouble radius);
+    GLvoid calculatePoints(const GLuint* indices, GLuint pointCount,
+                           GLdouble offsetReal, GLdouble offsetImaginary,
+                           std::vector<GLfloat>& counts);
+    GLfloat iterate(GLdouble deltaReal, GLdouble deltaImaginary,
+                    GLuint& isGlitched);
+};
+
+#endif
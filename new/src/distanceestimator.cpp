@@ -0,0 +1,288 @@
+/**
+ * [Program description]
+ */
+
+#include "distanceestimator.hpp"
+
+/**
+ * Constructor to create the distance estimator of the profile's 3D fractal.
+ */
+DistanceEstimator::DistanceEstimator(std::map<std::string, GLfloat>& env)
+{
+  type = (Type)std::min((GLuint)env["rayMarchType"],
+                        (GLuint)QUATERNION_JULIA);
+  iterationCount = std::max(env["rayMarchIterationCount"], 1.0f);
+  mandelboxScale = env["mandelboxScale"];
+  juliaConstant = glm::vec4(env["juliaReal"], env["juliaImaginary"],
+                            env["juliaJ"], env["juliaK"]);
+
+  switch (type) {
+    case MANDELBULB:
+      boundingRadius = 1.25f;
+      break;
+    case MANDELBOX:
+      // The box is bounded by a cube, whose size depends on the scale.
+      boundingRadius = (mandelboxScale > 1.0f) ?
+                       2.0f * (mandelboxScale + 1.0f) /
+                       (mandelboxScale - 1.0f) : 2.0f;
+      boundingRadius *= sqrtf(3.0f);
+      break;
+    case QUATERNION_JULIA:
+      boundingRadius = 0.5f + sqrtf(0.25f + glm::length(juliaConstant));
+      break;
+  }
+}
+
+/**
+ * Get the name of a type of 3D fractal.
+ */
+const GLchar* DistanceEstimator::getName(GLuint type)
+{
+  const GLchar* names[] = {"Mandelbulb", "Mandelbox", "quaternion Julia set"};
+
+  return names[std::min(type, (GLuint)QUATERNION_JULIA)];
+}
+
+/**
+ * Estimate the distance from each of a list of points to the fractal, a
+ * packet of points at a time. The distance is negative inside the fractal.
+ * The last packet is padded with copies of its last point.
+ */
+GLvoid DistanceEstimator::getDistances(const GLfloat* xs, const GLfloat* ys,
+                                       const GLfloat* zs, GLfloat* distances,
+                                       GLuint count)
+{
+  for (GLuint start = 0; start < count; start += DISTANCE_PACKET_SIZE) {
+    GLuint packetSize = std::min(count - start, (GLuint)DISTANCE_PACKET_SIZE);
+    GLfloat packetXs[DISTANCE_PACKET_SIZE], packetYs[DISTANCE_PACKET_SIZE];
+    GLfloat packetZs[DISTANCE_PACKET_SIZE];
+    GLfloat packetDistances[DISTANCE_PACKET_SIZE];
+
+    for (GLuint i = 0; i < DISTANCE_PACKET_SIZE; i++) {
+      GLuint j = start + std::min(i, packetSize - 1);
+
+      packetXs[i] = xs[j];
+      packetYs[i] = ys[j];
+      packetZs[i] = zs[j];
+    }
+
+    switch (type) {
+      case MANDELBULB:
+        getMandelbulbDistances(packetXs, packetYs, packetZs, packetDistances);
+        break;
+      case MANDELBOX:
+        getMandelboxDistances(packetXs, packetYs, packetZs, packetDistances);
+        break;
+      case QUATERNION_JULIA:
+        getJuliaDistances(packetXs, packetYs, packetZs, packetDistances);
+        break;
+    }
+
+    std::copy(packetDistances, packetDistances + packetSize,
+              distances + start);
+  }
+}
+
+/**
+ * Estimate the distance from a single point to the fractal.
+ */
+GLfloat DistanceEstimator::getDistance(glm::vec3 point)
+{
+  GLfloat distance;
+
+  getDistances(&point.x, &point.y, &point.z, &distance, 1);
+
+  return distance;
+}
+
+/**
+ * Estimate the distances from a packet of points to the power 8 Mandelbulb.
+ *
+ * Raising a point to the eighth power multiplies its polar angle and azimuth
+ * by eight. Rather than calling trigonometric functions, the sines and
+ * cosines of the angles are taken from the point's coordinates and doubled
+ * three times, so each iteration is plain arithmetic which the compiler
+ * vectorises across the packet.
+ */
+GLvoid DistanceEstimator::getMandelbulbDistances(const GLfloat* xs,
+                                                 const GLfloat* ys,
+                                                 const GLfloat* zs,
+                                                 GLfloat* distances)
+{
+  GLfloat x[DISTANCE_PACKET_SIZE], y[DISTANCE_PACKET_SIZE];
+  GLfloat z[DISTANCE_PACKET_SIZE], dr[DISTANCE_PACKET_SIZE];
+  GLint isActive[DISTANCE_PACKET_SIZE];
+
+  for (GLuint i = 0; i < DISTANCE_PACKET_SIZE; i++) {
+    x[i] = xs[i];
+    y[i] = ys[i];
+    z[i] = zs[i];
+    dr[i] = 1.0f;
+    isActive[i] = true;
+  }
+
+  for (GLuint n = 0; n < iterationCount; n++) {
+    GLint activeCount = 0;
+
+    for (GLuint i = 0; i < DISTANCE_PACKET_SIZE; i++) {
+      GLfloat rho2 = x[i] * x[i] + y[i] * y[i];
+      GLfloat radius2 = rho2 + z[i] * z[i];
+      GLfloat radius = sqrtf(radius2);
+      GLfloat rho = sqrtf(rho2);
+      GLint isIterating = isActive[i] & (radius <= MANDELBULB_BAILOUT);
+
+      GLfloat inverseRadius = (radius > 0.0f) ? 1.0f / radius : 0.0f;
+      GLfloat inverseRho = (rho > 0.0f) ? 1.0f / rho : 0.0f;
+      GLfloat sinTheta = rho * inverseRadius;
+      GLfloat cosTheta = (radius > 0.0f) ? z[i] * inverseRadius : 1.0f;
+      GLfloat sinPhi = y[i] * inverseRho;
+      GLfloat cosPhi = (rho > 0.0f) ? x[i] * inverseRho : 1.0f;
+
+      for (GLuint j = 0; j < 3; j++) {
+        GLfloat newSinTheta = 2.0f * sinTheta * cosTheta;
+        GLfloat newSinPhi = 2.0f * sinPhi * cosPhi;
+
+        cosTheta = cosTheta * cosTheta - sinTheta * sinTheta;
+        cosPhi = cosPhi * cosPhi - sinPhi * sinPhi;
+        sinTheta = newSinTheta;
+        sinPhi = newSinPhi;
+      }
+
+      GLfloat radius4 = radius2 * radius2;
+      GLfloat radius7 = radius4 * radius2 * radius;
+      GLfloat radius8 = radius4 * radius4;
+
+      x[i] = isIterating ? radius8 * sinTheta * cosPhi + xs[i] : x[i];
+      y[i] = isIterating ? radius8 * sinTheta * sinPhi + ys[i] : y[i];
+      z[i] = isIterating ? radius8 * cosTheta + zs[i] : z[i];
+      dr[i] = isIterating ? 8.0f * radius7 * dr[i] + 1.0f : dr[i];
+      isActive[i] = isIterating;
+      activeCount += isIterating;
+    }
+
+    if (activeCount == 0) {
+      break;
+    }
+  }
+
+  for (GLuint i = 0; i < DISTANCE_PACKET_SIZE; i++) {
+    GLfloat radius = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+
+    distances[i] = 0.5f * logf(radius) * radius / dr[i];
+  }
+}
+
+/**
+ * Estimate the distances from a packet of points to the Mandelbox. Each
+ * iteration folds the point into a box and a sphere, then scales it, with
+ * selects instead of branches so the packet is vectorised.
+ */
+GLvoid DistanceEstimator::getMandelboxDistances(const GLfloat* xs,
+                                                const GLfloat* ys,
+                                                const GLfloat* zs,
+                                                GLfloat* distances)
+{
+  GLfloat x[DISTANCE_PACKET_SIZE], y[DISTANCE_PACKET_SIZE];
+  GLfloat z[DISTANCE_PACKET_SIZE], dr[DISTANCE_PACKET_SIZE];
+  GLint isActive[DISTANCE_PACKET_SIZE];
+  GLfloat scale = mandelboxScale;
+  GLfloat absoluteScale = fabsf(scale);
+
+  for (GLuint i = 0; i < DISTANCE_PACKET_SIZE; i++) {
+    x[i] = xs[i];
+    y[i] = ys[i];
+    z[i] = zs[i];
+    dr[i] = 1.0f;
+    isActive[i] = true;
+  }
+
+  for (GLuint n = 0; n < iterationCount; n++) {
+    GLint activeCount = 0;
+
+    for (GLuint i = 0; i < DISTANCE_PACKET_SIZE; i++) {
+      GLint isIterating = isActive[i] &
+                          (x[i] * x[i] + y[i] * y[i] + z[i] * z[i] <=
+                           MANDELBOX_BAILOUT);
+      GLfloat foldedX = 2.0f * std::min(std::max(x[i], -1.0f), 1.0f) - x[i];
+      GLfloat foldedY = 2.0f * std::min(std::max(y[i], -1.0f), 1.0f) - y[i];
+      GLfloat foldedZ = 2.0f * std::min(std::max(z[i], -1.0f), 1.0f) - z[i];
+      GLfloat radius2 = foldedX * foldedX + foldedY * foldedY +
+                        foldedZ * foldedZ;
+      GLfloat factor = (radius2 < MANDELBOX_MIN_RADIUS2) ?
+                       MANDELBOX_FIXED_RADIUS2 / MANDELBOX_MIN_RADIUS2 :
+                       (radius2 < MANDELBOX_FIXED_RADIUS2) ?
+                       MANDELBOX_FIXED_RADIUS2 / radius2 : 1.0f;
+
+      x[i] = isIterating ? scale * factor * foldedX + xs[i] : x[i];
+      y[i] = isIterating ? scale * factor * foldedY + ys[i] : y[i];
+      z[i] = isIterating ? scale * factor * foldedZ + zs[i] : z[i];
+      dr[i] = isIterating ? absoluteScale * factor * dr[i] + 1.0f : dr[i];
+      isActive[i] = isIterating;
+      activeCount += isIterating;
+    }
+
+    if (activeCount == 0) {
+      break;
+    }
+  }
+
+  for (GLuint i = 0; i < DISTANCE_PACKET_SIZE; i++) {
+    distances[i] = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]) / dr[i];
+  }
+}
+
+/**
+ * Estimate the distances from a packet of points to the 3D slice of a
+ * quaternion Julia set, through the points with no fourth component.
+ */
+GLvoid DistanceEstimator::getJuliaDistances(const GLfloat* xs,
+                                            const GLfloat* ys,
+                                            const GLfloat* zs,
+                                            GLfloat* distances)
+{
+  GLfloat a[DISTANCE_PACKET_SIZE], b[DISTANCE_PACKET_SIZE];
+  GLfloat c[DISTANCE_PACKET_SIZE], d[DISTANCE_PACKET_SIZE];
+  GLfloat derivative2[DISTANCE_PACKET_SIZE];
+  GLint isActive[DISTANCE_PACKET_SIZE];
+
+  for (GLuint i = 0; i < DISTANCE_PACKET_SIZE; i++) {
+    a[i] = xs[i];
+    b[i] = ys[i];
+    c[i] = zs[i];
+    d[i] = 0.0f;
+    derivative2[i] = 1.0f;
+    isActive[i] = true;
+  }
+
+  for (GLuint n = 0; n < iterationCount; n++) {
+    GLint activeCount = 0;
+
+    for (GLuint i = 0; i < DISTANCE_PACKET_SIZE; i++) {
+      GLfloat modulus2 = a[i] * a[i] + b[i] * b[i] + c[i] * c[i] +
+                         d[i] * d[i];
+      GLint isIterating = isActive[i] &
+                          (modulus2 <= QUATERNION_JULIA_BAILOUT);
+      GLfloat newA = a[i] * a[i] - b[i] * b[i] - c[i] * c[i] - d[i] * d[i] +
+                     juliaConstant.x;
+
+      derivative2[i] = isIterating ? 4.0f * modulus2 * derivative2[i] :
+                                     derivative2[i];
+      b[i] = isIterating ? 2.0f * a[i] * b[i] + juliaConstant.y : b[i];
+      c[i] = isIterating ? 2.0f * a[i] * c[i] + juliaConstant.z : c[i];
+      d[i] = isIterating ? 2.0f * a[i] * d[i] + juliaConstant.w : d[i];
+      a[i] = isIterating ? newA : a[i];
+      isActive[i] = isIterating;
+      activeCount += isIterating;
+    }
+
+    if (activeCount == 0) {
+      break;
+    }
+  }
+
+  for (GLuint i = 0; i < DISTANCE_PACKET_SIZE; i++) {
+    GLfloat modulus2 = a[i] * a[i] + b[i] * b[i] + c[i] * c[i] + d[i] * d[i];
+
+    distances[i] = 0.25f * sqrtf(modulus2 / derivative2[i]) * logf(modulus2);
+  }
+}
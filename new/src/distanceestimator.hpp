@@ -0,0 +1,61 @@
+/**
+ * [Program description]
+ */
+
+#ifndef DISTANCE_ESTIMATOR_HEADER
+#define DISTANCE_ESTIMATOR_HEADER
+
+// Number of points whose distances are estimated together, which the compiler
+// can vectorise.
+#define DISTANCE_PACKET_SIZE 8
+
+// Distance from the origin at which a Mandelbulb point has escaped.
+#define MANDELBULB_BAILOUT 2.0f
+
+// Squared radii within which the Mandelbox's sphere fold scales points up.
+#define MANDELBOX_MIN_RADIUS2 0.25f
+#define MANDELBOX_FIXED_RADIUS2 1.0f
+
+// Squared distance from the origin at which a Mandelbox point has escaped.
+#define MANDELBOX_BAILOUT 1024.0f
+
+// Squared distance from the origin at which a Julia set point has escaped.
+#define QUATERNION_JULIA_BAILOUT 16.0f
+
+class DistanceEstimator
+{
+  public:
+    typedef enum {
+      MANDELBULB,
+      MANDELBOX,
+      QUATERNION_JULIA
+    } Type;
+
+    /**
+     * type - fractal whose distance is estimated
+     * iterationCount - number of iterations of each point
+     * mandelboxScale - factor the Mandelbox is scaled by each iteration
+     * juliaConstant - constant of the quaternion Julia set
+     * boundingRadius - radius of a sphere around the origin containing the
+     *                  fractal
+     */
+    Type type;
+    GLuint iterationCount;
+    GLfloat mandelboxScale;
+    glm::vec4 juliaConstant;
+    GLfloat boundingRadius;
+
+    DistanceEstimator(std::map<std::string, GLfloat>& env);
+    static const GLchar* getName(GLuint type);
+    GLvoid getDistances(const GLfloat* xs, const GLfloat* ys,
+                        const GLfloat* zs, GLfloat* distances, GLuint count);
+    GLfloat getDistance(glm::vec3 point);
+    GLvoid getMandelbulbDistances(const GLfloat* xs, const GLfloat* ys,
+                                  const GLfloat* zs, GLfloat* distances);
+    GLvoid getMandelboxDistances(const GLfloat* xs, const GLfloat* ys,
+                                 const GLfloat* zs, GLfloat* distances);
+    GLvoid getJuliaDistances(const GLfloat* xs, const GLfloat* ys,
+                             const GLfloat* zs, GLfloat* distances);
+};
+
+#endif
@@ -0,0 +1,236 @@
+/**
+ * [Program description]
+ */
+
+#include "escapetimegenerator.hpp"
+
+/**
+ * Constructor to create a generator of the Mandelbrot set, or of a Julia
+ * set, from the profile's values.
+ */
+EscapeTimeGenerator::EscapeTimeGenerator(std::map<std::string, GLfloat>& env,
+                                         GLuint desiredIsJulia)
+{
+  isJulia = desiredIsJulia;
+  isPeriodic = false;
+  yRange = env["fractalYRange"];
+  iterationCount = std::max(env["escapeIterationCount"], 1.0f);
+  centreReal = env["escapeCentreReal"];
+  centreImaginary = env["escapeCentreImaginary"];
+  width = env["escapeWidth"];
+  juliaReal = env["juliaReal"];
+  juliaImaginary = env["juliaImaginary"];
+  baseColour = glm::vec3(env["fractalColourRed"], env["fractalColourGreen"],
+                         env["fractalColourBlue"]);
+  isDeepZoomed = false;
+
+  GLchar text[32];
+
+  snprintf(text, sizeof(text), "%.17g", centreReal);
+  centreRealText = text;
+  snprintf(text, sizeof(text), "%.17g", centreImaginary);
+  centreImaginaryText = text;
+}
+
+/**
+ * Set the view of the plane, with the centre given as decimal text so that
+ * deep zooms can be centred more precisely than a double allows.
+ */
+GLvoid EscapeTimeGenerator::setView(const std::string& real,
+                                    const std::string& imaginary,
+                                    GLdouble desiredWidth)
+{
+  centreRealText = real;
+  centreImaginaryText = imaginary;
+  centreReal = atof(real.c_str());
+  centreImaginary = atof(imaginary.c_str());
+  width = desiredWidth;
+}
+
+/**
+ * Generate the heights from the smooth iteration count of each point, and
+ * colour the points by it. Points which escape quickly are low, and points
+ * inside the set form a plateau at the top of the Y range.
+ *
+ * The number of iterations varies hugely across the plane, so the rows are
+ * handed out to the threads one at a time as they finish. Once the points of
+ * the Mandelbrot set are too close together for doubles, their counts are
+ * calculated by perturbation first instead.
+ */
+GLvoid EscapeTimeGenerator::generate(HeightPlane& plane)
+{
+  counts = std::vector<GLfloat>(plane.size * plane.size);
+  isDeepZoomed = !isJulia && width / plane.size < DEEP_ZOOM_STEP;
+
+  if (isDeepZoomed) {
+    DeepZoom deepZoom(iterationCount);
+
+    deepZoom.calculate(centreRealText, centreImaginaryText, width, plane.size,
+                       counts);
+    printf("deep zoom: %u reference orbits, %u iterations skipped, "
+           "%u glitched points\n", deepZoom.referenceCount,
+           deepZoom.skipCount, (GLuint)deepZoom.glitches.size());
+  }
+
+  PointGenerator<EscapeTimeGenerator>::generate(plane);
+
+  colours = std::vector<glm::vec3>(counts.size());
+
+  for (GLuint i = 0; i < counts.size(); i++) {
+    colours[i] = getColour(counts[i]);
+  }
+}
+
+/**
+ * Calculate one row of heights, a batch of points at a time, unless the
+ * counts were already calculated by perturbation. Rows run along the real
+ * axis, and the plane is centred on the chosen point.
+ */
+GLvoid EscapeTimeGenerator::generateRow(GLuint x, GLuint size, GLfloat* row)
+{
+  GLdouble step = width / size;
+  GLdouble imaginary = centreImaginary + ((GLdouble)x - size / 2.0) * step;
+  GLfloat maximumHeight = log1pf(iterationCount);
+  GLfloat* rowCounts = &counts[x * size];
+
+  for (GLuint z = 0; z < size && !isDeepZoomed; z += ESCAPE_BATCH_SIZE) {
+    GLdouble reals[ESCAPE_BATCH_SIZE];
+    GLfloat smoothCounts[ESCAPE_BATCH_SIZE];
+    GLuint batchSize = std::min(size - z, (GLuint)ESCAPE_BATCH_SIZE);
+
+    for (GLuint i = 0; i < ESCAPE_BATCH_SIZE; i++) {
+      reals[i] = centreReal + ((GLdouble)(z + i) - size / 2.0) * step;
+    }
+
+    iterateBatch(reals, imaginary, smoothCounts);
+    std::copy(smoothCounts, smoothCounts + batchSize, rowCounts + z);
+  }
+
+  for (GLuint z = 0; z < size; z++) {
+    row[z] = (rowCounts[z] < 0.0f) ? yRange :
+             yRange * log1pf(rowCounts[z]) / maximumHeight;
+  }
+}
+
+/**
+ * Iterate a batch of points along a row together until every point has
+ * escaped or is known to be inside the set, and return their smooth iteration
+ * counts, or -1 for points inside the set.
+ *
+ * Each iteration updates every point of the batch with the same plain
+ * arithmetic, keeping the points which have stopped as they are, so the loop
+ * is vectorised by the compiler. Points in the Mandelbrot set's main cardioid
+ * or period-2 bulb stop before they start. Other points inside the set are
+ * found by checking for an orbit which returns to a value saved at the last
+ * power of two iterations (Brent's cycle detection).
+ */
+GLvoid EscapeTimeGenerator::iterateBatch(const GLdouble* reals,
+                                         GLdouble imaginary,
+                                         GLfloat* smoothCounts)
+{
+  GLdouble zReals[ESCAPE_BATCH_SIZE], zImaginaries[ESCAPE_BATCH_SIZE];
+  GLdouble cReals[ESCAPE_BATCH_SIZE], cImaginaries[ESCAPE_BATCH_SIZE];
+  GLdouble savedReals[ESCAPE_BATCH_SIZE], savedImaginaries[ESCAPE_BATCH_SIZE];
+  GLint iterations[ESCAPE_BATCH_SIZE];
+  GLint isActive[ESCAPE_BATCH_SIZE];
+  GLint isInside[ESCAPE_BATCH_SIZE];
+
+  for (GLuint i = 0; i < ESCAPE_BATCH_SIZE; i++) {
+    zReals[i] = isJulia ? reals[i] : 0.0;
+    zImaginaries[i] = isJulia ? imaginary : 0.0;
+    cReals[i] = isJulia ? juliaReal : reals[i];
+    cImaginaries[i] = isJulia ? juliaImaginary : imaginary;
+    savedReals[i] = zReals[i];
+    savedImaginaries[i] = zImaginaries[i];
+    iterations[i] = 0;
+    isInside[i] = !isJulia && isInMainBulbs(reals[i], imaginary);
+    isActive[i] = !isInside[i];
+  }
+
+  GLuint nextSave = 2;
+
+  for (GLuint n = 0; n < iterationCount; n++) {
+    GLint activeCount = 0;
+
+    for (GLuint i = 0; i < ESCAPE_BATCH_SIZE; i++) {
+      GLdouble real2 = zReals[i] * zReals[i];
+      GLdouble imaginary2 = zImaginaries[i] * zImaginaries[i];
+      GLint isIterating = isActive[i] & (real2 + imaginary2 <= ESCAPE_BAILOUT);
+      GLdouble newReal = real2 - imaginary2 + cReals[i];
+      GLdouble newImaginary = 2.0 * zReals[i] * zImaginaries[i] +
+                              cImaginaries[i];
+
+      zReals[i] = isIterating ? newReal : zReals[i];
+      zImaginaries[i] = isIterating ? newImaginary : zImaginaries[i];
+      iterations[i] += isIterating;
+      isActive[i] = isIterating;
+      activeCount += isIterating;
+    }
+
+    if (activeCount == 0) {
+      break;
+    }
+
+    for (GLuint i = 0; i < ESCAPE_BATCH_SIZE; i++) {
+      GLint isRepeated = isActive[i] &
+                         (fabs(zReals[i] - savedReals[i]) <
+                          ESCAPE_PERIOD_TOLERANCE) &
+                         (fabs(zImaginaries[i] - savedImaginaries[i]) <
+                          ESCAPE_PERIOD_TOLERANCE);
+
+      isInside[i] |= isRepeated;
+      isActive[i] &= !isRepeated;
+    }
+
+    if (n + 1 == nextSave) {
+      std::copy(zReals, zReals + ESCAPE_BATCH_SIZE, savedReals);
+      std::copy(zImaginaries, zImaginaries + ESCAPE_BATCH_SIZE,
+                savedImaginaries);
+      nextSave *= 2;
+    }
+  }
+
+  for (GLuint i = 0; i < ESCAPE_BATCH_SIZE; i++) {
+    GLdouble modulus2 = zReals[i] * zReals[i] +
+                        zImaginaries[i] * zImaginaries[i];
+
+    // Points still iterating after the last iteration count as inside.
+    if (isInside[i] || modulus2 <= ESCAPE_BAILOUT) {
+      smoothCounts[i] = -1.0f;
+    } else {
+      smoothCounts[i] = std::max(iterations[i] + 1.0 -
+                                 log2(0.5 * log(modulus2)), 0.0);
+    }
+  }
+}
+
+/**
+ * Check whether a point is inside the Mandelbrot set's main cardioid or its
+ * period-2 bulb, which together cover most of the set's area.
+ */
+GLuint EscapeTimeGenerator::isInMainBulbs(GLdouble real, GLdouble imaginary)
+{
+  GLdouble imaginary2 = imaginary * imaginary;
+  GLdouble offset = real - 0.25;
+  GLdouble q = offset * offset + imaginary2;
+
+  return q * (q + offset) <= 0.25 * imaginary2 ||
+         (real + 1.0) * (real + 1.0) + imaginary2 <= 0.0625;
+}
+
+/**
+ * Get the colour of a point from its smooth iteration count, cycling through
+ * a smooth palette outside the set.
+ */
+glm::vec3 EscapeTimeGenerator::getColour(GLfloat smoothCount)
+{
+  if (smoothCount < 0.0f) {
+    return baseColour;
+  }
+
+  GLfloat t = 0.05f * smoothCount;
+
+  return glm::vec3(0.5f + 0.5f * cosf(2.0f * M_PI * t),
+                   0.5f + 0.5f * cosf(2.0f * M_PI * (t + 0.15f)),
+                   0.5f + 0.5f * cosf(2.0f * M_PI * (t + 0.3f)));
+}
@@ -0,0 +1,65 @@
+/**
+ * [Program description]
+ */
+
+#ifndef ESCAPE_TIME_GENERATOR_HEADER
+#define ESCAPE_TIME_GENERATOR_HEADER
+
+// Number of points iterated together, which the compiler can vectorise.
+#define ESCAPE_BATCH_SIZE 8
+
+// Squared distance from the origin at which a point has escaped. A large
+// radius makes the smooth iteration count more accurate.
+#define ESCAPE_BAILOUT 65536.0
+
+// Largest distance between two values of an orbit to treat them as the same.
+#define ESCAPE_PERIOD_TOLERANCE 1e-13
+
+class EscapeTimeGenerator : public PointGenerator<EscapeTimeGenerator>
+{
+  public:
+    /**
+     * isJulia - whether to generate the Julia set instead of the Mandelbrot set
+     * yRange - Y value of points inside the set
+     * iterationCount - largest number of iterations of each point
+     * centreReal - real part of the point at the centre of the plane
+     * centreImaginary - imaginary part of the point at the centre of the plane
+     * width - width of the plane in the complex plane
+     * juliaReal - real part of the constant of the Julia set
+     * juliaImaginary - imaginary part of the constant of the Julia set
+     * baseColour - colour of points inside the set
+     * centreRealText - real part of the centre as decimal text, which keeps
+     *                  the precision of deep zooms
+     * centreImaginaryText - imaginary part of the centre as decimal text
+     *
+     * counts - smooth iteration count of each point (negative inside the set)
+     * isDeepZoomed - whether the counts were calculated by perturbation
+     */
+    GLuint isJulia;
+    GLfloat yRange;
+    GLuint iterationCount;
+    GLdouble centreReal;
+    GLdouble centreImaginary;
+    GLdouble width;
+    GLdouble juliaReal;
+    GLdouble juliaImaginary;
+    glm::vec3 baseColour;
+    std::string centreRealText;
+    std::string centreImaginaryText;
+
+    std::vector<GLfloat> counts;
+    GLuint isDeepZoomed;
+
+    EscapeTimeGenerator(std::map<std::string, GLfloat>& env,
+                        GLuint desiredIsJulia);
+    GLvoid setView(const std::string& real, const std::string& imaginary,
+                   GLdouble desiredWidth);
+    GLvoid generate(HeightPlane& plane);
+    GLvoid generateRow(GLuint x, GLuint size, GLfloat* row);
+    GLvoid iterateBatch(const GLdouble* reals, GLdouble imaginary,
+                        GLfloat* smoothCounts);
+    static GLuint isInMainBulbs(GLdouble real, GLdouble imaginary);
+    glm::vec3 getColour(GLfloat smoothCount);
+};
+
+#endif
@@ -0,0 +1,375 @@
+/**
+ * [Program description]
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "exporter.hpp"
+
+/**
+ * Constructor to create an idle exporter.
+ */
+Exporter::Exporter()
+{
+  isBusy = false;
+  file = -1;
+  buffer = std::vector<GLchar>(EXPORT_BUFFER_SIZE);
+  bufferedSize = 0;
+  writtenSize = 0;
+}
+
+/**
+ * Start writing the fractal in each of the given formats, one after the
+ * other, on a background thread. The files are named after the given base
+ * name, with an extension for each format. The fractal must not be changed
+ * until the exports are finished. Returns false if an export is already
+ * being written.
+ */
+GLuint Exporter::start(Fractal& fractal, std::string basename,
+                       std::vector<Format> formats)
+{
+  if (isBusy) {
+    return false;
+  }
+
+  // Collect the thread of the previous export, which has already finished.
+  wait();
+
+  isBusy = true;
+  thread = std::thread([this, &fractal, basename, formats]() {
+    const GLchar* extensions[] = {".raw", ".pgm", ".ply", ".obj"};
+
+    for (GLuint i = 0; i < formats.size(); i++) {
+      exportFractal(fractal, basename + extensions[formats[i]], formats[i]);
+    }
+
+    isBusy = false;
+  });
+
+  return true;
+}
+
+/**
+ * Wait for the current export to be finished.
+ */
+GLvoid Exporter::wait()
+{
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+/**
+ * Write the fractal to a file in the given format. The data is generated in
+ * order and passed to the file through a fixed size buffer, so the whole file
+ * is never held in memory.
+ */
+GLvoid Exporter::exportFractal(Fractal& fractal, std::string path,
+                               Format format)
+{
+  using namespace std::chrono;
+
+  steady_clock::time_point start = steady_clock::now();
+
+  file = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  bufferedSize = 0;
+  writtenSize = 0;
+
+  if (file < 0) {
+    fprintf(stderr, "unable to export fractal: %s\n", path.c_str());
+    return;
+  }
+
+  switch (format) {
+    case RAW16:
+      writeHeightmap(fractal, false);
+      break;
+    case PGM:
+      writeText("P5\n");
+      writeNumber(fractal.size);
+      writeText(" ");
+      writeNumber(fractal.size);
+      writeText("\n65535\n");
+      writeHeightmap(fractal, true);
+      break;
+    case PLY:
+      writePly(fractal);
+      break;
+    case OBJ:
+      writeObj(fractal);
+      break;
+  }
+
+  flush();
+  close(file);
+  file = -1;
+
+  steady_clock::time_point end = steady_clock::now();
+
+  printf("exported %s (%.1f MB in %.0f ms)\n", path.c_str(),
+         writtenSize / 1048576.0,
+         duration<GLdouble, std::milli>(end - start).count());
+}
+
+/**
+ * Write the heights of the fractal as rows of 16-bit values, stretched to
+ * cover the whole 16-bit range. RAW files are little-endian and PGM files
+ * are big-endian.
+ */
+GLvoid Exporter::writeHeightmap(Fractal& fractal, GLuint isBigEndian)
+{
+  GLuint size = fractal.size;
+  GLfloat minimum = fractal.getYPosition(0, 0);
+  GLfloat maximum = minimum;
+
+  for (GLuint x = 0; x < size; x++) {
+    for (GLuint z = 0; z < size; z++) {
+      minimum = std::min(minimum, fractal.getYPosition(x, z));
+      maximum = std::max(maximum, fractal.getYPosition(x, z));
+    }
+  }
+
+  GLfloat scale = (maximum > minimum) ? 65535.0f / (maximum - minimum) : 0.0f;
+
+  for (GLuint x = 0; x < size; x++) {
+    for (GLuint z = 0; z < size; z++) {
+      GLuint value = lround((fractal.getYPosition(x, z) - minimum) * scale);
+      GLubyte bytes[2] = {(GLubyte)(value & 0xFF), (GLubyte)(value >> 8)};
+
+      if (isBigEndian) {
+        std::swap(bytes[0], bytes[1]);
+      }
+
+      writeData(bytes, sizeof(bytes));
+    }
+  }
+}
+
+/**
+ * Write the mesh of the fractal as a binary PLY file, in the same layout as
+ * the vertex data. Each vertex has its position, normal and colour.
+ */
+GLvoid Exporter::writePly(Fractal& fractal)
+{
+  GLuint size = fractal.size;
+  GLuint meshSize = fractal.meshSize;
+  GLuint one = 1;
+  GLuint isLittleEndian = *(GLubyte*)&one;
+
+  writeText("ply\nformat ");
+  writeText(isLittleEndian ? "binary_little_endian" : "binary_big_endian");
+  writeText(" 1.0\nelement vertex ");
+  writeNumber(fractal.vertexCount);
+  writeText("\nproperty float x\nproperty float y\nproperty float z\n"
+            "property float nx\nproperty float ny\nproperty float nz\n"
+            "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+            "element face ");
+  writeNumber((GLuint)fractal.lodIndexCounts[0] / 3);
+  writeText("\nproperty list uchar uint vertex_indices\nend_header\n");
+
+  for (GLuint i = 0; i < meshSize; i++) {
+    for (GLuint j = 0; j < meshSize; j++) {
+      GLuint x = i % size;
+      GLuint z = j % size;
+      GLfloat vertex[6] = {(GLfloat)i / size, fractal.getYPosition(x, z),
+                           (GLfloat)j / size, fractal.normals[x][z].x,
+                           fractal.normals[x][z].y, fractal.normals[x][z].z};
+      GLubyte colour[3];
+
+      for (GLuint k = 0; k < 3; k++) {
+        colour[k] = lround(glm::clamp(fractal.colours[x][z][k], 0.0f, 1.0f) *
+                           255.0f);
+      }
+
+      writeData(vertex, sizeof(vertex));
+      writeData(colour, sizeof(colour));
+    }
+  }
+
+  std::vector<GLuint> meshVertices = getMeshVertices(fractal);
+  const GLuint* indices = fractal.indexData + fractal.lodIndexOffsets[0];
+
+  for (GLint i = 0; i < fractal.lodIndexCounts[0]; i += 3) {
+    GLubyte count = 3;
+    GLuint triangle[3] = {meshVertices[indices[i]],
+                          meshVertices[indices[i + 1]],
+                          meshVertices[indices[i + 2]]};
+
+    writeData(&count, sizeof(count));
+    writeData(triangle, sizeof(triangle));
+  }
+}
+
+/**
+ * Write the mesh of the fractal as an OBJ file. Vertex colours are written
+ * after the positions, which most tools accept.
+ */
+GLvoid Exporter::writeObj(Fractal& fractal)
+{
+  GLuint size = fractal.size;
+  GLuint meshSize = fractal.meshSize;
+
+  for (GLuint i = 0; i < meshSize; i++) {
+    for (GLuint j = 0; j < meshSize; j++) {
+      GLuint x = i % size;
+      GLuint z = j % size;
+
+      writeText("v ");
+      writeNumber((GLfloat)i / size);
+      writeText(" ");
+      writeNumber(fractal.getYPosition(x, z));
+      writeText(" ");
+      writeNumber((GLfloat)j / size);
+
+      for (GLuint k = 0; k < 3; k++) {
+        writeText(" ");
+        writeNumber(fractal.colours[x][z][k]);
+      }
+
+      writeText("\nvn ");
+      writeNumber(fractal.normals[x][z].x);
+      writeText(" ");
+      writeNumber(fractal.normals[x][z].y);
+      writeText(" ");
+      writeNumber(fractal.normals[x][z].z);
+      writeText("\n");
+    }
+  }
+
+  std::vector<GLuint> meshVertices = getMeshVertices(fractal);
+  const GLuint* indices = fractal.indexData + fractal.lodIndexOffsets[0];
+
+  // OBJ indices start at one, and each vertex has the normal of its index.
+  for (GLint i = 0; i < fractal.lodIndexCounts[0]; i += 3) {
+    writeText("f");
+
+    for (GLuint k = 0; k < 3; k++) {
+      GLuint vertex = meshVertices[indices[i + k]] + 1;
+
+      writeText(" ");
+      writeNumber(vertex);
+      writeText("//");
+      writeNumber(vertex);
+    }
+
+    writeText("\n");
+  }
+}
+
+/**
+ * Find the position of each vertex of the vertex data within the mesh, which
+ * is the order the vertices are exported in. The triangles are exported from
+ * the full resolution index data, so simplified fractals export as simplified
+ * meshes.
+ */
+std::vector<GLuint> Exporter::getMeshVertices(Fractal& fractal)
+{
+  std::vector<GLuint> meshVertices(fractal.vertexCount);
+
+  for (GLuint i = 0; i < fractal.vertexCount; i++) {
+    meshVertices[fractal.vertexOrder[i]] = i;
+  }
+
+  return meshVertices;
+}
+
+/**
+ * Add data to the buffer, writing the buffer to the file whenever it fills.
+ */
+GLvoid Exporter::writeData(const GLvoid* data, size_t size)
+{
+  const GLchar* bytes = (const GLchar*)data;
+
+  while (size > 0) {
+    size_t length = std::min(size, buffer.size() - bufferedSize);
+
+    memcpy(buffer.data() + bufferedSize, bytes, length);
+    bufferedSize += length;
+    bytes += length;
+    size -= length;
+
+    if (bufferedSize == buffer.size()) {
+      flush();
+    }
+  }
+}
+
+/**
+ * Add text to the buffer.
+ */
+GLvoid Exporter::writeText(const GLchar* text)
+{
+  writeData(text, strlen(text));
+}
+
+/**
+ * Add a whole number to the buffer as text.
+ */
+GLvoid Exporter::writeNumber(GLuint value)
+{
+  GLchar digits[10];
+  GLuint count = 0;
+
+  do {
+    digits[sizeof(digits) - ++count] = '0' + value % 10;
+    value /= 10;
+  } while (value > 0);
+
+  writeData(digits + sizeof(digits) - count, count);
+}
+
+/**
+ * Add a real number to the buffer as text, with six decimal places. This is
+ * much faster than formatting it with printf, which would otherwise take
+ * most of the time of a text export.
+ */
+GLvoid Exporter::writeNumber(GLfloat value)
+{
+  GLint64 scaled = llround((GLdouble)value * 1000000.0);
+  GLchar fraction[7] = "000000";
+
+  if (scaled < 0) {
+    writeText("-");
+    scaled = -scaled;
+  }
+
+  writeNumber((GLuint)(scaled / 1000000));
+  writeText(".");
+
+  for (GLint i = 5, remainder = scaled % 1000000; i >= 0; i--) {
+    fraction[i] = '0' + remainder % 10;
+    remainder /= 10;
+  }
+
+  writeData(fraction, 6);
+}
+
+/**
+ * Write the buffered data to the file.
+ */
+GLvoid Exporter::flush()
+{
+  size_t offset = 0;
+
+  while (offset < bufferedSize) {
+    ssize_t length = write(file, buffer.data() + offset,
+                           bufferedSize - offset);
+
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      fprintf(stderr, "unable to write export: %s\n", strerror(errno));
+      break;
+    }
+
+    offset += length;
+  }
+
+  writtenSize += offset;
+  bufferedSize = 0;
+}
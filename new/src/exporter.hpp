@@ -0,0 +1,51 @@
+/**
+ * [Program description]
+ */
+
+#ifndef EXPORTER_HEADER
+#define EXPORTER_HEADER
+
+#define EXPORT_BUFFER_SIZE (1 << 20)
+
+class Exporter
+{
+  public:
+    typedef enum {
+      RAW16,
+      PGM,
+      PLY,
+      OBJ
+    } Format;
+
+    /**
+     * thread - background thread which writes the exports
+     * isBusy - whether the background thread is still writing
+     * file - descriptor of the file being written
+     * buffer - data waiting to be written to the file
+     * bufferedSize - number of bytes waiting in the buffer
+     * writtenSize - number of bytes written to the file so far
+     */
+    std::thread thread;
+    std::atomic<GLuint> isBusy;
+    GLint file;
+    std::vector<GLchar> buffer;
+    size_t bufferedSize;
+    size_t writtenSize;
+
+    Exporter();
+    GLuint start(Fractal& fractal, std::string basename,
+                 std::vector<Format> formats);
+    GLvoid wait();
+    GLvoid exportFractal(Fractal& fractal, std::string path, Format format);
+    GLvoid writeHeightmap(Fractal& fractal, GLuint isBigEndian);
+    GLvoid writePly(Fractal& fractal);
+    GLvoid writeObj(Fractal& fractal);
+    std::vector<GLuint> getMeshVertices(Fractal& fractal);
+    GLvoid writeData(const GLvoid* data, size_t size);
+    GLvoid writeText(const GLchar* text);
+    GLvoid writeNumber(GLuint value);
+    GLvoid writeNumber(GLfloat value);
+    GLvoid flush();
+};
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * [Program description]
+ */
+
+#include "fouriertransform.hpp"
+
+/**
+ * Constructor to create a fast Fourier transform (FFT) of a given size, with
+ * its bit reversal and twiddle factors calculated up front.
+ *
+ * The twiddle factors of each stage are stored next to each other, starting
+ * at the stage's half length minus one, so every butterfly loop reads them in
+ * order.
+ */
+FourierTransform::FourierTransform(GLuint desiredSize)
+{
+  size = desiredSize;
+  reversedIndices = std::vector<GLuint>(size);
+  twiddleReals = std::vector<GLfloat>(std::max(size, 1u) - 1);
+  twiddleImaginaries = std::vector<GLfloat>(std::max(size, 1u) - 1);
+
+  GLuint bitCount = 0;
+
+  while ((1u << bitCount) < size) {
+    bitCount++;
+  }
+
+  for (GLuint i = 0; i < size; i++) {
+    GLuint reversed = 0;
+
+    for (GLuint bit = 0; bit < bitCount; bit++) {
+      reversed |= ((i >> bit) & 1) << (bitCount - 1 - bit);
+    }
+
+    reversedIndices[i] = reversed;
+  }
+
+  for (GLuint half = 1; half < size; half *= 2) {
+    for (GLuint j = 0; j < half; j++) {
+      GLdouble angle = -M_PI * j / half;
+
+      twiddleReals[half - 1 + j] = cos(angle);
+      twiddleImaginaries[half - 1 + j] = sin(angle);
+    }
+  }
+}
+
+/**
+ * Transform a sequence of complex values in place, with the iterative radix-2
+ * Cooley-Tukey algorithm. The values are stored as separate arrays of real and
+ * imaginary parts, so the butterflies of each group are a loop of plain
+ * arithmetic over consecutive values, which the compiler vectorises. The
+ * inverse transform isn't scaled.
+ */
+GLvoid FourierTransform::transform(GLfloat* reals, GLfloat* imaginaries,
+                                   GLuint isInverse)
+{
+  GLfloat sign = isInverse ? -1.0f : 1.0f;
+
+  for (GLuint i = 0; i < size; i++) {
+    GLuint j = reversedIndices[i];
+
+    if (i < j) {
+      std::swap(reals[i], reals[j]);
+      std::swap(imaginaries[i], imaginaries[j]);
+    }
+  }
+
+  for (GLuint half = 1; half < size; half *= 2) {
+    const GLfloat* cosines = &twiddleReals[half - 1];
+    const GLfloat* sines = &twiddleImaginaries[half - 1];
+
+    for (GLuint start = 0; start < size; start += half * 2) {
+      GLfloat* aReals = reals + start;
+      GLfloat* aImaginaries = imaginaries + start;
+      GLfloat* bReals = aReals + half;
+      GLfloat* bImaginaries = aImaginaries + half;
+
+      for (GLuint j = 0; j < half; j++) {
+        GLfloat wReal = cosines[j];
+        GLfloat wImaginary = sign * sines[j];
+        GLfloat tReal = wReal * bReals[j] - wImaginary * bImaginaries[j];
+        GLfloat tImaginary = wReal * bImaginaries[j] + wImaginary * bReals[j];
+
+        bReals[j] = aReals[j] - tReal;
+        bImaginaries[j] = aImaginaries[j] - tImaginary;
+        aReals[j] += tReal;
+        aImaginaries[j] += tImaginary;
+      }
+    }
+  }
+}
+
+/**
+ * Transform each row of a square of values, with the rows shared between
+ * threads.
+ */
+GLvoid FourierTransform::transformRows(std::vector<GLfloat>& reals,
+                                       std::vector<GLfloat>& imaginaries,
+                                       GLuint isInverse)
+{
+  runInParallel(size, [&](GLuint row) {
+    transform(&reals[row * size], &imaginaries[row * size], isInverse);
+  });
+}
+
+/**
+ * Transform a square of values in two dimensions. The rows are transformed,
+ * then the square is transposed so that the columns can be transformed as
+ * rows too, and transposed back.
+ */
+GLvoid FourierTransform::transform2D(std::vector<GLfloat>& reals,
+                                     std::vector<GLfloat>& imaginaries,
+                                     GLuint isInverse)
+{
+  transformRows(reals, imaginaries, isInverse);
+  transpose(reals);
+  transpose(imaginaries);
+  transformRows(reals, imaginaries, isInverse);
+  transpose(reals);
+  transpose(imaginaries);
+}
+
+/**
+ * Transpose a square of values in place, a pair of tiles at a time so that
+ * both tiles stay in the cache.
+ */
+GLvoid FourierTransform::transpose(std::vector<GLfloat>& values)
+{
+  for (GLuint tileX = 0; tileX < size; tileX += TRANSPOSE_TILE_SIZE) {
+    for (GLuint tileY = tileX; tileY < size; tileY += TRANSPOSE_TILE_SIZE) {
+      GLuint endX = std::min(tileX + TRANSPOSE_TILE_SIZE, size);
+      GLuint endY = std::min(tileY + TRANSPOSE_TILE_SIZE, size);
+
+      for (GLuint x = tileX; x < endX; x++) {
+        for (GLuint y = (tileX == tileY) ? x + 1 : tileY; y < endY; y++) {
+          std::swap(values[x * size + y], values[y * size + x]);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,34 @@
+/**
+ * [Program description]
+ */
+
+#ifndef FOURIER_TRANSFORM_HEADER
+#define FOURIER_TRANSFORM_HEADER
+
+// Width/height of the tiles squares are transposed in.
+#define TRANSPOSE_TILE_SIZE 32
+
+class FourierTransform
+{
+  public:
+    /**
+     * size - number of values transformed (must be a power of two)
+     * reversedIndices - position of each value after the bit reversal
+     * twiddleReals - real parts of the twiddle factors of every stage
+     * twiddleImaginaries - imaginary parts of the twiddle factors
+     */
+    GLuint size;
+    std::vector<GLuint> reversedIndices;
+    std::vector<GLfloat> twiddleReals;
+    std::vector<GLfloat> twiddleImaginaries;
+
+    FourierTransform(GLuint desiredSize);
+    GLvoid transform(GLfloat* reals, GLfloat* imaginaries, GLuint isInverse);
+    GLvoid transformRows(std::vector<GLfloat>& reals,
+                         std::vector<GLfloat>& imaginaries, GLuint isInverse);
+    GLvoid transform2D(std::vector<GLfloat>& reals,
+                       std::vector<GLfloat>& imaginaries, GLuint isInverse);
+    GLvoid transpose(std::vector<GLfloat>& values);
+};
+
+#endif
@@ -9,29 +9,118 @@
  * Constructor to initialise the fractal with the given properties.
  */
 Fractal::Fractal(GLuint desiredDepth, GLfloat desiredYRange,
-                 GLfloat desiredYDeviance, glm::vec3 desiredBaseColour)
+                 GLfloat desiredYDeviance, glm::vec3 desiredBaseColour,
+                 GLuint desiredChunkSize, GLuint desiredLodCount,
+                 HeightPlane::Layout desiredStorageLayout,
+                 GLuint desiredIsQuantised)
 {
   depth = desiredDepth;
   size = 2 << (depth - 1);
   yRange = desiredYRange;
   yDeviance = desiredYDeviance;
   baseColour = desiredBaseColour;
+  storageLayout = desiredStorageLayout;
+  isQuantised = desiredIsQuantised;
+  generator = std::make_shared<DiamondSquareGenerator>(yRange, yDeviance);
 
-  indexCount = (size - 1) * (size - 1) * (2 * DIMENSIONS);
-  vertexCount = size * size;
+  // The fractal is periodic, so the first row and column of vertices are
+  // repeated at the far edges to let copies of the mesh tile seamlessly.
+  meshSize = size + 1;
+  indexCount = size * size * (2 * DIMENSIONS);
+  vertexCount = meshSize * meshSize;
   attributeCount = 3;
+  vertexStride = isQuantised ? sizeof(PackedVertex) :
+                               DIMENSIONS * attributeCount * sizeof(GLfloat);
 
-  positions = std::vector<std::vector<glm::vec3>>(size,
-                          std::vector<glm::vec3>(size));
+  // Split the quads of the fractal into square chunks which can be culled
+  // individually. A chunk size of zero keeps the whole fractal in one chunk.
+  GLuint quadCount = size;
+  chunkSize = (desiredChunkSize == 0 || desiredChunkSize > quadCount) ?
+              quadCount : desiredChunkSize;
+  chunkCount = (chunkSize == 0) ? 0 : (quadCount + chunkSize - 1) / chunkSize;
+
+  chunkMinHeights   = std::vector<GLfloat>(chunkCount * chunkCount);
+  chunkMaxHeights   = std::vector<GLfloat>(chunkCount * chunkCount);
+  chunkIndexOffsets = std::vector<GLuint>(chunkCount * chunkCount);
+  chunkIndexCounts  = std::vector<GLsizei>(chunkCount * chunkCount);
+  chunkLineOffsets  = std::vector<GLuint>(chunkCount * chunkCount);
+  chunkLineCounts   = std::vector<GLsizei>(chunkCount * chunkCount);
+
+  // Each level of detail halves the resolution of the previous level. These
+  // index sets are stored after the full resolution indices, followed by the
+  // line indices of every level used to draw the wireframe.
+  lodCount = std::max(std::min(desiredLodCount, depth + 1), 1u);
+  lodIndexOffsets = std::vector<GLuint>(lodCount);
+  lodIndexCounts  = std::vector<GLsizei>(lodCount);
+  lodLineOffsets  = std::vector<GLuint>(lodCount);
+  lodLineCounts   = std::vector<GLsizei>(lodCount);
+  updateLodRanges();
+
+  heights = HeightPlane(size, storageLayout, isQuantised);
   normals   = std::vector<std::vector<glm::vec3>>(size,
                           std::vector<glm::vec3>(size));
   colours   = std::vector<std::vector<glm::vec3>>(size,
                           std::vector<glm::vec3>(size));
 
-  GLuint vertexDataSize = vertexCount * DIMENSIONS;
-  indexData  = new GLuint[indexCount];
-  vertexData = new GLfloat[vertexDataSize * attributeCount];
-  normalVertexData = new GLfloat[vertexDataSize * 2];
+  // Quantised fractals use the packed vertex format instead.
+  indexData  = new GLuint[totalIndexCount];
+  vertexData = isQuantised ? nullptr :
+               new GLfloat[vertexCount * DIMENSIONS * attributeCount];
+  packedVertexData = isQuantised ? new PackedVertex[vertexCount] : nullptr;
+
+  // Each visualised normal is a line between two vertices.
+  normalVertexCount = size * size * 2;
+  normalVertexData = new GLfloat[normalVertexCount * DIMENSIONS *
+                                 attributeCount];
+}
+
+/**
+ * Update the range of each detail level's indices within the full resolution
+ * index data, along with the total number of indices. The quads along the
+ * sides of the lower detail levels are fans which keep every vertex of the
+ * sides (see addBorderQuadIndices), so they have more indices than the rest.
+ */
+GLvoid Fractal::updateLodRanges()
+{
+  totalIndexCount = 0;
+
+  for (GLuint lod = 0; lod < lodCount; lod++) {
+    GLuint lodSize = size >> lod;
+    GLuint stride = 1 << lod;
+    GLuint borderSize = (lodSize == 1) ? 1 : 4 * lodSize - 4;
+
+    // Two triangles per quad, and a fan around each quad along the sides,
+    // with two more triangles for every vertex added along the sides.
+    lodIndexOffsets[lod] = totalIndexCount;
+    lodIndexCounts[lod] = lodSize * lodSize * 2;
+
+    if (lod > 0) {
+      lodIndexCounts[lod] += 2 * borderSize + 4 * lodSize * (stride - 1);
+    }
+
+    lodIndexCounts[lod] *= DIMENSIONS;
+    totalIndexCount += lodIndexCounts[lod];
+  }
+
+  for (GLuint lod = 0; lod < lodCount; lod++) {
+    GLuint lodSize = size >> lod;
+    GLuint stride = 1 << lod;
+    GLuint borderSize = (lodSize == 1) ? 1 : 4 * lodSize - 4;
+
+    // Three edges per quad, plus the edges closing the far sides. The fans
+    // along the sides have a spoke to each vertex of their outlines in place
+    // of their diagonals, and their edges along the sides are split at every
+    // vertex.
+    lodLineOffsets[lod] = totalIndexCount;
+    lodLineCounts[lod] = 3 * lodSize * lodSize + 2 * lodSize;
+
+    if (lod > 0) {
+      lodLineCounts[lod] += 3 * borderSize + 8 * lodSize * (stride - 1);
+    }
+
+    lodLineCounts[lod] *= 2;
+    totalIndexCount += lodLineCounts[lod];
+  }
 }
 
 /**
@@ -39,7 +128,7 @@ Fractal::Fractal(GLuint desiredDepth, GLfloat desiredYRange,
  */
 GLvoid Fractal::setYPosition(GLuint x, GLuint z, GLfloat value)
 {
-  positions[x % size][z % size].y = value;
+  heights.set(x, z, value);
 }
 
 /**
@@ -47,77 +136,60 @@ GLvoid Fractal::setYPosition(GLuint x, GLuint z, GLfloat value)
  */
 GLfloat Fractal::getYPosition(GLuint x, GLuint z)
 {
-  return positions[x % size][z % size].y;
+  return heights.get(x, z);
 }
 
 /**
- * Recursively update the points in the fractal using the midpoint displacement
- * algorithm.
+ * Generate the fractal with its generator. The heights are generated in the
+ * chosen storage layout and then converted into rows, which suit the rest of
+ * the pipeline.
  */
 GLvoid Fractal::generate()
 {
-  GLuint tempSize = size;
-  GLfloat tempYRange = yRange;
-
-  // Generate the Y values of each vertex.
-  while (tempSize > 1) {
-    GLuint halfStep = tempSize / 2;
-
-    for (GLuint y = halfStep; y < size + halfStep; y += tempSize) {
-      for (GLuint x = halfStep; x < size + halfStep; x += tempSize) {
-        GLuint hs = tempSize / 2;
-        GLfloat a = getYPosition(x - hs, y - hs);
-        GLfloat b = getYPosition(x + hs, y - hs);
-        GLfloat c = getYPosition(x - hs, y + hs);
-        GLfloat d = getYPosition(x + hs, y + hs);
-        setYPosition(x, y, average({a, b, c, d}) +
-             randomNumber(-tempYRange, tempYRange));
-      }
-    }
+  heights.reset(storageLayout);
+  generator->generate(heights);
 
-    for (GLuint y = 0; y < size; y += tempSize) {
-      for (GLuint x = 0; x < size; x += tempSize) {
-        GLuint hs = tempSize / 2;
-        GLfloat newX = x + halfStep;
-        GLfloat a = getYPosition(newX - hs, y);
-        GLfloat b = getYPosition(newX + hs, y);
-        GLfloat c = getYPosition(newX, y - hs);
-        GLfloat d = getYPosition(newX, y + hs);
-        setYPosition(newX, y, average({a, b, c, d}) +
-             randomNumber(-tempYRange, tempYRange));
-   
-        GLfloat newY = y + halfStep;
-        a = getYPosition(x - hs, newY);
-        b = getYPosition(x + hs, newY);
-        c = getYPosition(x, newY - hs);
-        d = getYPosition(x, newY + hs);
-        setYPosition(x, newY, average({a, b, c, d}) +
-             randomNumber(-tempYRange, tempYRange));
-      }
-    }
-
-    tempSize /= 2;
-    tempYRange *= yDeviance;
-  }
+  heights.convertToLayout(HeightPlane::LINEAR);
 
-  updatePositions();
   updateNormals();
   updateColours();
+  updateChunkBounds();
   updateVertexData();
 }
 
 /**
- * Update the position of each vertex.
+ * Use the heights of the given plane, which must be the size of the fractal,
+ * instead of generating them. Quantised fractals take the range of the plane.
  */
-GLvoid Fractal::updatePositions()
+GLvoid Fractal::setHeights(HeightPlane& plane)
 {
-  for (GLuint i = 0; i < size; i++) {
-    for (GLuint j = 0; j < size; j++) {
-      positions[i][j].x = (GLfloat)(i % (GLuint)size) / (GLfloat)size;
-      // The Y values are already set within generate().
-      positions[i][j].z = (GLfloat)j / (GLfloat)size;
+  heights.reset(HeightPlane::LINEAR);
+  generator->colours.clear();
+
+  if (isQuantised) {
+    GLfloat minimum = plane.get(0, 0);
+    GLfloat maximum = minimum;
+
+    for (GLuint x = 0; x < size; x++) {
+      for (GLuint z = 0; z < size; z++) {
+        minimum = std::min(minimum, plane.get(x, z));
+        maximum = std::max(maximum, plane.get(x, z));
+      }
+    }
+
+    heights.setRange(minimum, maximum);
+  }
+
+  for (GLuint x = 0; x < size; x++) {
+    for (GLuint z = 0; z < size; z++) {
+      heights.set(x, z, plane.get(x, z));
     }
   }
+
+  updateNormals();
+  updateColours();
+  updateChunkBounds();
+  updateVertexData();
 }
 
 /**
@@ -125,86 +197,689 @@ GLvoid Fractal::updatePositions()
  */
 GLvoid Fractal::updateNormals()
 {
-  glm::vec3 p1, p2, p3, v1, v2;
+  glm::vec3 v1, v2;
+  GLfloat step = 1.0f / (GLfloat)size;
 
+  // Neighbours wrap around the edges, so the normals match across copies.
   for (GLuint i = 0; i < size; i++) {
     for (GLuint j = 0; j < size; j++) {
-      p1 = positions[i][j];
-      p2 = positions[i][(j + 1) % size];
-      p3 = positions[(i + 1) % size][j];
-
-      // Account for edge cases.
-      v1 = (i + 1 == size) ? p1 - p2 : p2 - p1;
-      v2 = (j + 1 == size) ? p1 - p3 : p3 - p1;
-      
+      GLfloat y = getYPosition(i, j);
+
+      v1 = glm::vec3(0.0f, getYPosition(i, j + 1) - y, step);
+      v2 = glm::vec3(step, getYPosition(i + 1, j) - y, 0.0f);
+
       normals[i][j] = normalize(cross(v1, v2));
     }
   }
 }
 
 /**
- * Update the colour of each vertex.
+ * Update the colour of each vertex, using the generator's colours when it
+ * has them.
  */
 GLvoid Fractal::updateColours()
 {
+  GLuint isGeneratorColoured = generator->colours.size() == size * size;
+
   for (GLuint i = 0; i < size; i++) {
     for (GLuint j = 0; j < size; j++) {
-      colours[i][j].r = baseColour.r;
-      colours[i][j].g = baseColour.g;
-      colours[i][j].b = baseColour.b;
+      colours[i][j] = isGeneratorColoured ? generator->colours[i * size + j] :
+                                            baseColour;
     }
   }
 }
 
 /**
- * Generate the vertex positional data.
+ * Update the minimum and maximum Y values of each chunk. These bounds must be
+ * kept in sync with the heights so that chunks are culled correctly.
+ */
+GLvoid Fractal::updateChunkBounds()
+{
+  for (GLuint cx = 0; cx < chunkCount; cx++) {
+    for (GLuint cz = 0; cz < chunkCount; cz++) {
+      GLuint chunk = cx * chunkCount + cz;
+      GLuint lastX = std::min((cx + 1) * chunkSize, size);
+      GLuint lastZ = std::min((cz + 1) * chunkSize, size);
+      GLfloat minimum = getYPosition(cx * chunkSize, cz * chunkSize);
+      GLfloat maximum = minimum;
+
+      // A chunk includes the vertices along its far edges.
+      for (GLuint i = cx * chunkSize; i <= lastX; i++) {
+        for (GLuint j = cz * chunkSize; j <= lastZ; j++) {
+          minimum = std::min(minimum, getYPosition(i, j));
+          maximum = std::max(maximum, getYPosition(i, j));
+        }
+      }
+
+      chunkMinHeights[chunk] = minimum;
+      chunkMaxHeights[chunk] = maximum;
+    }
+  }
+}
+
+/**
+ * Get the minimum corner of a chunk's bounding box.
+ */
+glm::vec3 Fractal::getChunkMinimum(GLuint chunk)
+{
+  GLuint cx = chunk / chunkCount;
+  GLuint cz = chunk % chunkCount;
+
+  return glm::vec3((GLfloat)(cx * chunkSize) / (GLfloat)size,
+                   chunkMinHeights[chunk],
+                   (GLfloat)(cz * chunkSize) / (GLfloat)size);
+}
+
+/**
+ * Get the maximum corner of a chunk's bounding box.
+ */
+glm::vec3 Fractal::getChunkMaximum(GLuint chunk)
+{
+  GLuint cx = chunk / chunkCount;
+  GLuint cz = chunk % chunkCount;
+
+  return glm::vec3((GLfloat)std::min((cx + 1) * chunkSize, size) /
+                   (GLfloat)size,
+                   chunkMaxHeights[chunk],
+                   (GLfloat)std::min((cz + 1) * chunkSize, size) /
+                   (GLfloat)size);
+}
+
+/**
+ * Generate the vertex positional data. The vertices along the far edges are
+ * copies of the first row and column, offset by one full period. Vertices are
+ * stored in the order given by vertexOrder.
  */
 GLvoid Fractal::generateVertexData()
+{
+  if (isQuantised) {
+    generatePackedVertexData();
+    return;
+  }
+
+  for (GLuint i = 0; i < meshSize; i++) {
+    for (GLuint j = 0; j < meshSize; j++) {
+      GLuint offset = getVertexIndex(i, j) * DIMENSIONS * attributeCount;
+      GLuint x = i % size;
+      GLuint z = j % size;
+
+      vertexData[offset++] = (GLfloat)i / (GLfloat)size;
+      vertexData[offset++] = getYPosition(x, z);
+      vertexData[offset++] = (GLfloat)j / (GLfloat)size;
+
+      vertexData[offset++] = normals[x][z].x;
+      vertexData[offset++] = normals[x][z].y;
+      vertexData[offset++] = normals[x][z].z;
+
+      vertexData[offset++] = colours[x][z].r;
+      vertexData[offset++] = colours[x][z].g;
+      vertexData[offset++] = colours[x][z].b;
+    }
+  }
+}
+
+/**
+ * Generate the packed vertex data of a quantised fractal. Each vertex stores
+ * its grid coordinates and quantised height as integers, which the vertex
+ * shader scales back into position, along with a 10-bit normal and an 8-bit
+ * colour. This takes 16 bytes per vertex rather than 36.
+ */
+GLvoid Fractal::generatePackedVertexData()
+{
+  for (GLuint i = 0; i < meshSize; i++) {
+    for (GLuint j = 0; j < meshSize; j++) {
+      PackedVertex& vertex = packedVertexData[getVertexIndex(i, j)];
+      GLuint x = i % size;
+      GLuint z = j % size;
+      GLuint normal = 0;
+
+      vertex.position[0] = i;
+      vertex.position[1] = heights.quantisedHeights[heights.getIndex(x, z)];
+      vertex.position[2] = j;
+      vertex.padding = 0;
+
+      for (GLuint k = 0; k < DIMENSIONS; k++) {
+        GLint component = lround(glm::clamp(normals[x][z][k], -1.0f, 1.0f) *
+                                 511.0f);
+
+        normal |= (component & 0x3FF) << (10 * k);
+      }
+
+      vertex.normal = normal;
+
+      for (GLuint k = 0; k < DIMENSIONS; k++) {
+        vertex.colour[k] = lround(glm::clamp(colours[x][z][k], 0.0f, 1.0f) *
+                                  255.0f);
+      }
+
+      vertex.colour[3] = 255;
+    }
+  }
+}
+
+/**
+ * Get the scale applied to the vertex positions by the vertex shader.
+ */
+glm::vec3 Fractal::getPositionScale()
+{
+  if (isQuantised) {
+    return glm::vec3(1.0f / size, heights.heightScale, 1.0f / size);
+  }
+
+  return glm::vec3(1.0f);
+}
+
+/**
+ * Get the offset applied to the vertex positions by the vertex shader.
+ */
+glm::vec3 Fractal::getPositionOffset()
+{
+  if (isQuantised) {
+    return glm::vec3(0.0f, heights.heightOffset, 0.0f);
+  }
+
+  return glm::vec3(0.0f);
+}
+
+/**
+ * Generate the vertex data of the lines used to visualise the normals, with
+ * one line per vertex of the fractal. Each line starts at its vertex and its
+ * end is offset along the normal by the shader, so the normal length can be
+ * changed without regenerating the data. Both ends are given the inverse of
+ * the vertex's colour.
+ */
+GLvoid Fractal::generateNormalVertexData()
 {
   GLuint offset = 0;
 
   for (GLuint i = 0; i < size; i++) {
     for (GLuint j = 0; j < size; j++) {
-      vertexData[offset++] = positions[i][j].x;
-      vertexData[offset++] = positions[i][j].y;
-      vertexData[offset++] = positions[i][j].z;
+      for (GLuint end = 0; end < 2; end++) {
+        normalVertexData[offset++] = (GLfloat)i / (GLfloat)size;
+        normalVertexData[offset++] = getYPosition(i, j);
+        normalVertexData[offset++] = (GLfloat)j / (GLfloat)size;
+
+        normalVertexData[offset++] = normals[i][j].x * end;
+        normalVertexData[offset++] = normals[i][j].y * end;
+        normalVertexData[offset++] = normals[i][j].z * end;
+
+        normalVertexData[offset++] = 1.0f - colours[i][j].r;
+        normalVertexData[offset++] = 1.0f - colours[i][j].g;
+        normalVertexData[offset++] = 1.0f - colours[i][j].b;
+      }
+    }
+  }
+}
+
+/**
+ * Add the indices of the two triangles of a quad, starting at the given vertex
+ * and spanning a given number of vertices. Returns the new offset.
+ */
+GLuint Fractal::addQuadIndices(GLuint offset, GLuint x, GLuint z,
+                               GLuint stride)
+{
+  GLuint corner = getVertexIndex(x, z);
+  GLuint right = getVertexIndex(x, z + stride);
+  GLuint below = getVertexIndex(x + stride, z);
+  GLuint opposite = getVertexIndex(x + stride, z + stride);
+
+  indexData[offset++] = corner;
+  indexData[offset++] = right;
+  indexData[offset++] = below;
+
+  indexData[offset++] = below;
+  indexData[offset++] = right;
+  indexData[offset++] = opposite;
+
+  return offset;
+}
+
+/**
+ * Add the indices of the edges of a quad, starting at the given vertex and
+ * spanning a given number of vertices. Each quad owns its near edges and its
+ * diagonal, so the far edges are only added along the far sides of the mesh.
+ * Returns the new offset.
+ */
+GLuint Fractal::addQuadLineIndices(GLuint offset, GLuint x, GLuint z,
+                                   GLuint stride)
+{
+  GLuint corner = getVertexIndex(x, z);
+  GLuint right = getVertexIndex(x, z + stride);
+  GLuint below = getVertexIndex(x + stride, z);
+  GLuint opposite = getVertexIndex(x + stride, z + stride);
+
+  indexData[offset++] = corner;
+  indexData[offset++] = right;
+
+  indexData[offset++] = corner;
+  indexData[offset++] = below;
+
+  indexData[offset++] = right;
+  indexData[offset++] = below;
+
+  if (x + stride == size) {
+    indexData[offset++] = below;
+    indexData[offset++] = opposite;
+  }
+
+  if (z + stride == size) {
+    indexData[offset++] = right;
+    indexData[offset++] = opposite;
+  }
+
+  return offset;
+}
+
+/**
+ * Get the vertices around the outline of a quad, starting at the given vertex
+ * and spanning a given number of vertices, in the winding order of its
+ * triangles. The outline includes every vertex along the sides of the mesh,
+ * but only the corners elsewhere. Each vertex is given along with the edge of
+ * the quad which starts at it, where edges 0 and 3 are the near edges.
+ */
+GLvoid Fractal::getQuadOutline(GLuint x, GLuint z, GLuint stride,
+                               std::vector<GLuint>& outline,
+                               std::vector<GLuint>& edges)
+{
+  GLint cornerXs[4] = {0, 0, 1, 1};
+  GLint cornerZs[4] = {0, 1, 1, 0};
+  GLint stepXs[4] = {0, 1, 0, -1};
+  GLint stepZs[4] = {1, 0, -1, 0};
+  GLuint isSide[4] = {x == 0, z + stride == size, x + stride == size, z == 0};
+
+  outline.clear();
+  edges.clear();
+
+  for (GLuint edge = 0; edge < 4; edge++) {
+    GLuint step = isSide[edge] ? 1 : stride;
+
+    for (GLuint i = 0; i < stride; i += step) {
+      outline.push_back(getVertexIndex(x + cornerXs[edge] * stride +
+                                       stepXs[edge] * i,
+                                       z + cornerZs[edge] * stride +
+                                       stepZs[edge] * i));
+      edges.push_back(edge);
+    }
+  }
+}
+
+/**
+ * Add the indices of a quad along the sides of a lower detail level, as a fan
+ * of triangles around its middle vertex. The fan meets every vertex along the
+ * sides of the mesh, so copies of the fractal at any detail level meet
+ * without cracks. Returns the new offset.
+ */
+GLuint Fractal::addBorderQuadIndices(GLuint offset, GLuint x, GLuint z,
+                                     GLuint stride)
+{
+  std::vector<GLuint> outline, edges;
+  GLuint middle = getVertexIndex(x + stride / 2, z + stride / 2);
+
+  getQuadOutline(x, z, stride, outline, edges);
+
+  for (GLuint i = 0; i < outline.size(); i++) {
+    indexData[offset++] = middle;
+    indexData[offset++] = outline[i];
+    indexData[offset++] = outline[(i + 1) % outline.size()];
+  }
+
+  return offset;
+}
+
+/**
+ * Add the indices of the edges of a quad along the sides of a lower detail
+ * level. The quad owns the spokes of its fan and its near edges, and its far
+ * edges only along the far sides of the mesh. Returns the new offset.
+ */
+GLuint Fractal::addBorderQuadLineIndices(GLuint offset, GLuint x, GLuint z,
+                                         GLuint stride)
+{
+  std::vector<GLuint> outline, edges;
+  GLuint middle = getVertexIndex(x + stride / 2, z + stride / 2);
+  GLuint isOwned[4] = {true, z + stride == size, x + stride == size, true};
 
-      vertexData[offset++] = normals[i][j].x;
-      vertexData[offset++] = normals[i][j].y;
-      vertexData[offset++] = normals[i][j].z;
+  getQuadOutline(x, z, stride, outline, edges);
 
-      vertexData[offset++] = colours[i][j].r;
-      vertexData[offset++] = colours[i][j].g;
-      vertexData[offset++] = colours[i][j].b;
+  for (GLuint i = 0; i < outline.size(); i++) {
+    indexData[offset++] = middle;
+    indexData[offset++] = outline[i];
+
+    if (isOwned[edges[i]]) {
+      indexData[offset++] = outline[i];
+      indexData[offset++] = outline[(i + 1) % outline.size()];
     }
   }
+
+  return offset;
 }
 
 /**
- * Generate the vertex index data.
+ * Generate the vertex index data. The full resolution indices are grouped by
+ * chunk so that each chunk can be drawn as a single contiguous range, and are
+ * followed by the index sets of each lower level of detail.
  */
 GLvoid Fractal::generateIndexData()
 {
-  GLuint offset = 0, increment = 0;
+  GLuint offset = 0;
 
-  for (GLuint i = 0; i < size; i++) {
-    for (GLuint j = 0; j < size - 1; j++) {
-      if (increment != 0 && (increment + 1) % size == 0) {
-        increment++;
-        continue;
+  for (GLuint cx = 0; cx < chunkCount; cx++) {
+    for (GLuint cz = 0; cz < chunkCount; cz++) {
+      GLuint chunk = cx * chunkCount + cz;
+      GLuint lastX = std::min((cx + 1) * chunkSize, size);
+      GLuint lastZ = std::min((cz + 1) * chunkSize, size);
+
+      chunkIndexOffsets[chunk] = offset;
+
+      for (GLuint i = cx * chunkSize; i < lastX; i++) {
+        for (GLuint j = cz * chunkSize; j < lastZ; j++) {
+          offset = addQuadIndices(offset, i, j, 1);
+        }
+      }
+
+      chunkIndexCounts[chunk] = offset - chunkIndexOffsets[chunk];
+    }
+  }
+
+  for (GLuint lod = 1; lod < lodCount; lod++) {
+    GLuint stride = 1 << lod;
+
+    for (GLuint i = 0; i < size; i += stride) {
+      for (GLuint j = 0; j < size; j += stride) {
+        if (i == 0 || j == 0 || i + stride == size || j + stride == size) {
+          offset = addBorderQuadIndices(offset, i, j, stride);
+        } else {
+          offset = addQuadIndices(offset, i, j, stride);
+        }
+      }
+    }
+  }
+
+  // The wireframe's line indices are grouped in the same way.
+  for (GLuint cx = 0; cx < chunkCount; cx++) {
+    for (GLuint cz = 0; cz < chunkCount; cz++) {
+      GLuint chunk = cx * chunkCount + cz;
+      GLuint lastX = std::min((cx + 1) * chunkSize, size);
+      GLuint lastZ = std::min((cz + 1) * chunkSize, size);
+
+      chunkLineOffsets[chunk] = offset;
+
+      for (GLuint i = cx * chunkSize; i < lastX; i++) {
+        for (GLuint j = cz * chunkSize; j < lastZ; j++) {
+          offset = addQuadLineIndices(offset, i, j, 1);
+        }
+      }
+
+      chunkLineCounts[chunk] = offset - chunkLineOffsets[chunk];
+    }
+  }
+
+  for (GLuint lod = 1; lod < lodCount; lod++) {
+    GLuint stride = 1 << lod;
+
+    for (GLuint i = 0; i < size; i += stride) {
+      for (GLuint j = 0; j < size; j += stride) {
+        if (i == 0 || j == 0 || i + stride == size || j + stride == size) {
+          offset = addBorderQuadLineIndices(offset, i, j, stride);
+        } else {
+          offset = addQuadLineIndices(offset, i, j, stride);
+        }
       }
+    }
+  }
+}
+
+/**
+ * Generate the order in which the vertices are stored in vertexData. The
+ * vertices of each chunk are stored together, and within a chunk they follow
+ * a Z-order curve so that neighbouring vertices tend to share cache lines.
+ */
+GLvoid Fractal::generateVertexOrder()
+{
+  std::vector<std::pair<GLuint64, GLuint>> keys(vertexCount);
+  GLuint lastChunk = std::max(chunkCount, 1u) - 1;
+
+  for (GLuint i = 0; i < meshSize; i++) {
+    for (GLuint j = 0; j < meshSize; j++) {
+      // The vertices along the far edges belong to the last chunk.
+      GLuint cx = std::min(i / std::max(chunkSize, 1u), lastChunk);
+      GLuint cz = std::min(j / std::max(chunkSize, 1u), lastChunk);
+      GLuint64 chunk = cx * chunkCount + cz;
+      GLuint code = mortonEncode(i - cx * chunkSize, j - cz * chunkSize);
+
+      keys[i * meshSize + j] = std::make_pair((chunk << 32) | code,
+                                              i * meshSize + j);
+    }
+  }
+
+  std::sort(keys.begin(), keys.end());
+  vertexOrder = std::vector<GLuint>(vertexCount);
+
+  for (GLuint i = 0; i < vertexCount; i++) {
+    vertexOrder[keys[i].second] = i;
+  }
+}
+
+/**
+ * Get the position of a vertex of the mesh within vertexData.
+ */
+GLuint Fractal::getVertexIndex(GLuint x, GLuint z)
+{
+  return vertexOrder[x * meshSize + z];
+}
+
+/**
+ * Update the vertex order and index data. Both only depend on the size of the
+ * mesh, so they are generated and optimised for the vertex cache once per
+ * size and then reused whenever a fractal of the same size is created.
+ */
+GLvoid Fractal::updateMeshLayout()
+{
+  static std::map<std::vector<GLuint>, MeshLayout> layouts;
+  std::vector<GLuint> key = {size, chunkSize, lodCount};
+
+  if (layouts.find(key) == layouts.end()) {
+    MeshOptimiser optimiser(VERTEX_CACHE_SIZE);
+    MeshLayout layout;
+
+    // The ranges may have been changed by simplification or the cache.
+    updateLodRanges();
+    generateVertexOrder();
+    generateIndexData();
+
+    GLfloat originalAcmr = optimiser.calculateAcmr(indexData, indexCount,
+                                                   vertexCount);
+
+    // Reorder the triangles within each chunk and detail level, keeping each
+    // range intact so they can still be culled and drawn individually.
+    for (GLuint chunk = 0; chunk < chunkCount * chunkCount; chunk++) {
+      optimiser.optimiseTriangles(indexData + chunkIndexOffsets[chunk],
+                                  chunkIndexCounts[chunk]);
+    }
+
+    for (GLuint lod = 1; lod < lodCount; lod++) {
+      optimiser.optimiseTriangles(indexData + lodIndexOffsets[lod],
+                                  lodIndexCounts[lod]);
+    }
+
+    printf("vertex cache: ACMR %.3f -> %.3f (size %d, cache size %d)\n",
+           originalAcmr, optimiser.calculateAcmr(indexData, indexCount,
+                                                 vertexCount),
+           size, VERTEX_CACHE_SIZE);
+
+    layout.vertexOrder = vertexOrder;
+    layout.indexData = std::vector<GLuint>(indexData,
+                                           indexData + totalIndexCount);
+    layout.chunkIndexOffsets = chunkIndexOffsets;
+    layout.chunkIndexCounts = chunkIndexCounts;
+    layout.chunkLineOffsets = chunkLineOffsets;
+    layout.chunkLineCounts = chunkLineCounts;
+    layout.lodIndexOffsets = lodIndexOffsets;
+    layout.lodIndexCounts = lodIndexCounts;
+    layout.lodLineOffsets = lodLineOffsets;
+    layout.lodLineCounts = lodLineCounts;
+    layouts[key] = layout;
+
+    return;
+  }
+
+  MeshLayout& layout = layouts[key];
 
-      indexData[offset++] = increment;
-      indexData[offset++] = increment + 1;
-      indexData[offset++] = increment + size;
+  vertexOrder = layout.vertexOrder;
+  std::copy(layout.indexData.begin(), layout.indexData.end(), indexData);
+  totalIndexCount = layout.indexData.size();
+  chunkIndexOffsets = layout.chunkIndexOffsets;
+  chunkIndexCounts = layout.chunkIndexCounts;
+  chunkLineOffsets = layout.chunkLineOffsets;
+  chunkLineCounts = layout.chunkLineCounts;
+  lodIndexOffsets = layout.lodIndexOffsets;
+  lodIndexCounts = layout.lodIndexCounts;
+  lodLineOffsets = layout.lodLineOffsets;
+  lodLineCounts = layout.lodLineCounts;
+}
+
+/**
+ * Replace the full resolution triangles of each chunk with as few triangles
+ * as possible while keeping every height within the given tolerance, and
+ * update the wireframe to match. The chunks are simplified in parallel, and
+ * their edges are kept at full resolution so they still meet without cracks.
+ * The lower detail levels used by the copies of the fractal are unchanged.
+ */
+GLvoid Fractal::simplify(GLfloat tolerance)
+{
+  GLuint totalChunkCount = chunkCount * chunkCount;
+  std::vector<std::vector<GLuint>> chunkTriangles(totalChunkCount);
+  std::vector<std::vector<GLuint>> chunkLines(totalChunkCount);
+  TerrainSimplifier simplifier(std::max(chunkSize, 2u));
+
+  // Start again from the full resolution mesh.
+  updateMeshLayout();
+
+  runInParallel(totalChunkCount, [&](GLuint chunk) {
+    simplifyChunk(chunk, tolerance, simplifier, chunkTriangles[chunk],
+                  chunkLines[chunk]);
+  });
+
+  // Pack the simplified chunks and the unchanged detail levels together,
+  // keeping the order of the index data.
+  std::vector<GLuint> newIndexData;
+  newIndexData.reserve(totalIndexCount);
+
+  for (GLuint chunk = 0; chunk < totalChunkCount; chunk++) {
+    chunkIndexOffsets[chunk] = newIndexData.size();
+    chunkIndexCounts[chunk] = chunkTriangles[chunk].size();
+    newIndexData.insert(newIndexData.end(), chunkTriangles[chunk].begin(),
+                        chunkTriangles[chunk].end());
+  }
+
+  lodIndexCounts[0] = newIndexData.size();
+
+  for (GLuint lod = 1; lod < lodCount; lod++) {
+    GLuint offset = lodIndexOffsets[lod];
+
+    lodIndexOffsets[lod] = newIndexData.size();
+    newIndexData.insert(newIndexData.end(), indexData + offset,
+                        indexData + offset + lodIndexCounts[lod]);
+  }
+
+  lodLineOffsets[0] = newIndexData.size();
+
+  for (GLuint chunk = 0; chunk < totalChunkCount; chunk++) {
+    chunkLineOffsets[chunk] = newIndexData.size();
+    chunkLineCounts[chunk] = chunkLines[chunk].size();
+    newIndexData.insert(newIndexData.end(), chunkLines[chunk].begin(),
+                        chunkLines[chunk].end());
+  }
+
+  lodLineCounts[0] = newIndexData.size() - lodLineOffsets[0];
+
+  for (GLuint lod = 1; lod < lodCount; lod++) {
+    GLuint offset = lodLineOffsets[lod];
+
+    lodLineOffsets[lod] = newIndexData.size();
+    newIndexData.insert(newIndexData.end(), indexData + offset,
+                        indexData + offset + lodLineCounts[lod]);
+  }
+
+  std::copy(newIndexData.begin(), newIndexData.end(), indexData);
+  totalIndexCount = newIndexData.size();
+
+  printf("simplification: %d -> %d triangles (%.1f%% fewer, %d threads)\n",
+         indexCount / 3, lodIndexCounts[0] / 3,
+         100.0f * (1.0f - (GLfloat)lodIndexCounts[0] / indexCount),
+         getThreadCount());
+}
+
+/**
+ * Simplify the triangles of one chunk, along with the lines of its wireframe.
+ * Chunks which are not a power of two in size can't be simplified, so their
+ * triangles and lines are kept as they are.
+ */
+GLvoid Fractal::simplifyChunk(GLuint chunk, GLfloat tolerance,
+                              TerrainSimplifier& simplifier,
+                              std::vector<GLuint>& triangles,
+                              std::vector<GLuint>& lines)
+{
+  GLuint x0 = (chunk / chunkCount) * chunkSize;
+  GLuint z0 = (chunk % chunkCount) * chunkSize;
+  GLuint gridSize = simplifier.gridSize;
+
+  if (simplifier.tileSize != chunkSize || (chunkSize & (chunkSize - 1)) != 0 ||
+      x0 + chunkSize > size || z0 + chunkSize > size) {
+    GLuint* first = indexData + chunkIndexOffsets[chunk];
+    GLuint* firstLine = indexData + chunkLineOffsets[chunk];
+
+    triangles.assign(first, first + chunkIndexCounts[chunk]);
+    lines.assign(firstLine, firstLine + chunkLineCounts[chunk]);
+    return;
+  }
+
+  std::vector<GLfloat> tileHeights(gridSize * gridSize);
+
+  for (GLuint x = 0; x < gridSize; x++) {
+    for (GLuint z = 0; z < gridSize; z++) {
+      tileHeights[x * gridSize + z] = getYPosition(x0 + x, z0 + z);
+    }
+  }
+
+  std::vector<GLuint> tileTriangles = simplifier.simplifyTile(tileHeights,
+                                                              tolerance);
+  std::vector<std::pair<GLuint, GLuint>> edges;
+
+  for (GLuint i = 0; i < tileTriangles.size(); i += 3) {
+    GLint x[3], z[3];
+    GLuint vertices[3];
 
-      indexData[offset++] = increment + size;
-      indexData[offset++] = increment + 1;
-      indexData[offset++] = increment + size + 1;
+    for (GLuint k = 0; k < 3; k++) {
+      x[k] = tileTriangles[i + k] / gridSize;
+      z[k] = tileTriangles[i + k] % gridSize;
+      vertices[k] = getVertexIndex(x0 + x[k], z0 + z[k]);
+    }
 
-      increment++;
+    // Wind the triangle the same way as the full resolution triangles.
+    if ((x[1] - x[0]) * (z[2] - z[0]) - (z[1] - z[0]) * (x[2] - x[0]) > 0) {
+      std::swap(vertices[1], vertices[2]);
     }
+
+    for (GLuint k = 0; k < 3; k++) {
+      GLuint next = vertices[(k + 1) % 3];
+
+      triangles.push_back(vertices[k]);
+      edges.push_back(std::make_pair(std::min(vertices[k], next),
+                                     std::max(vertices[k], next)));
+    }
+  }
+
+  // Each edge is shared by two triangles, but only needs to be drawn once.
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  for (GLuint i = 0; i < edges.size(); i++) {
+    lines.push_back(edges[i].first);
+    lines.push_back(edges[i].second);
   }
+
+  MeshOptimiser optimiser(VERTEX_CACHE_SIZE);
+  optimiser.optimiseTriangles(triangles.data(), triangles.size());
 }
 
 /**
@@ -212,9 +887,12 @@ GLvoid Fractal::generateIndexData()
  */
 GLvoid Fractal::updateVertexData()
 {
+  if (vertexOrder.empty()) {
+    updateMeshLayout();
+  }
+
   generateVertexData();
-  // generateNormalVertexData();
-  generateIndexData();
+  generateNormalVertexData();
 }
 
 /**
@@ -223,33 +901,79 @@ GLvoid Fractal::updateVertexData()
 GLvoid Fractal::smoothPositions(std::vector<std::vector<GLfloat>> kernel)
 {
   GLuint kernelSize = kernel.size();
-// printf("hi %d\n", size * size);
-  GLfloat accumulator;
-  GLfloat newYValues[size][size];
 
-  for (GLuint i = 0; i < size; i++) {
-    for (GLuint j = 0; j < size; j++) {
-      accumulator = 0.0f;
+  if (isQuantised) {
+    smoothQuantisedPositions(kernel);
+  } else {
+    GLfloat accumulator;
+    std::vector<GLfloat> newYValues(size * size);
 
-      for (GLuint k = 0; k < kernelSize; k++) {
-        for (GLuint l = 0; l < kernelSize; l++) {
-          accumulator += getYPosition(i + (k - (kernelSize / 2)),
-                              j + (l - (kernelSize / 2))) *
-                         kernel[k][l];
+    for (GLuint i = 0; i < size; i++) {
+      for (GLuint j = 0; j < size; j++) {
+        accumulator = 0.0f;
+
+        for (GLuint k = 0; k < kernelSize; k++) {
+          for (GLuint l = 0; l < kernelSize; l++) {
+            accumulator += getYPosition(i + (k - (kernelSize / 2)),
+                                j + (l - (kernelSize / 2))) *
+                           kernel[k][l];
+          }
         }
+        newYValues[i * size + j] = accumulator;
       }
-      newYValues[i][j] = accumulator;
     }
+
+    heights.heights.swap(newYValues);
   }
 
+  // Ensure the vertex normals and chunk bounds reflect the new positions.
+  updateNormals();
+  updateChunkBounds();
+}
+
+/**
+ * Perform a convolution on the quantised heights using fixed-point weights.
+ * The weights are scaled to sum to 65536, so the weighted sum of any heights
+ * fits in 32 bits and the result can be rounded back with a shift.
+ */
+GLvoid Fractal::smoothQuantisedPositions(
+    std::vector<std::vector<GLfloat>> kernel)
+{
+  GLuint kernelSize = kernel.size();
+  GLint halfSize = kernelSize / 2;
+  std::vector<GLuint> weights(kernelSize * kernelSize);
+  std::vector<GLushort> newYValues(size * size);
+  const GLushort* oldYValues = heights.quantisedHeights.data();
+  GLuint weightSum = 0;
+
+  for (GLuint k = 0; k < kernelSize; k++) {
+    for (GLuint l = 0; l < kernelSize; l++) {
+      weights[k * kernelSize + l] = lround(kernel[k][l] * 65536.0f);
+      weightSum += weights[k * kernelSize + l];
+    }
+  }
+
+  // Put any rounding error into the centre weight.
+  weights[halfSize * kernelSize + halfSize] += 65536 - weightSum;
+
   for (GLuint i = 0; i < size; i++) {
     for (GLuint j = 0; j < size; j++) {
-      setYPosition(i, j, newYValues[i][j]);
+      GLuint accumulator = 32768;
+
+      for (GLuint k = 0; k < kernelSize; k++) {
+        GLuint row = ((i + k - halfSize) & (size - 1)) * size;
+
+        for (GLuint l = 0; l < kernelSize; l++) {
+          accumulator += weights[k * kernelSize + l] *
+                         oldYValues[row + ((j + l - halfSize) & (size - 1))];
+        }
+      }
+
+      newYValues[i * size + j] = accumulator >> 16;
     }
   }
 
-  // Ensure the vertex normals reflect the new positions.
-  updateNormals();
+  heights.quantisedHeights.swap(newYValues);
 }
 
 /**
@@ -5,65 +5,164 @@
 #ifndef FRACTAL_HEADER
 #define FRACTAL_HEADER
 
+#define VERTEX_CACHE_SIZE 16
+
 class Fractal
 {
   public:
     static const GLuint DIMENSIONS = 3;
 
+    typedef struct {
+      std::vector<GLuint> vertexOrder;
+      std::vector<GLuint> indexData;
+      std::vector<GLuint> chunkIndexOffsets;
+      std::vector<GLsizei> chunkIndexCounts;
+      std::vector<GLuint> chunkLineOffsets;
+      std::vector<GLsizei> chunkLineCounts;
+      std::vector<GLuint> lodIndexOffsets;
+      std::vector<GLsizei> lodIndexCounts;
+      std::vector<GLuint> lodLineOffsets;
+      std::vector<GLsizei> lodLineCounts;
+    } MeshLayout;
+
+    typedef struct {
+      GLushort position[3];
+      GLushort padding;
+      GLuint normal;
+      GLubyte colour[4];
+    } PackedVertex;
+
     /**
      * depth - number of iterations in the diamond-square algorithm
      * size - width/height of the fractal
+     * meshSize - width/height of the fractal's mesh (in vertices)
      * yRange - Y value range per iteration
      * yRangeIncrement - Y value increment
      * yDeviance - (+/-) Y value deviance per iteration
      * yDevianceIncrement - Y deviance increment
      * baseColour - base colour of the fractal
+     * storageLayout - layout of the heights while they are generated
+     * isQuantised - whether heights and vertices use 16-bit quantised values
+     * generator - generator of the fractal's heights
+     * chunkSize - width/height of a terrain chunk (in quads)
+     * chunkCount - number of chunks along each side of the fractal
      *
      * indexCount - number of indices for drawing the fractal
+     * totalIndexCount - number of indices including the lower detail levels
      * vertexCount - number of vertices
      * attributeCount - number of vertex attributes
+     * vertexStride - number of bytes per vertex
+     * normalVertexCount - number of vertices used to visualise the normals
      *
-     * positions - array representing positions of vertices
+     * heights - Y value of each vertex
      * normals - array representing normals of vertices
      * colours - array representing final colours of vertices
      *
+     * vertexOrder - position of each mesh vertex within vertexData
      * indexData - index array representing triplets of vertices
      * vertexData - combined data as [positions, normals, colours]
-     * normalVertexData - similar to vertexData but for normals
+     * packedVertexData - similar to vertexData but for quantised fractals
+     * normalVertexData - line vertices as [positions, normals, colours]
+     *
+     * chunkMinHeights - minimum Y value of each chunk
+     * chunkMaxHeights - maximum Y value of each chunk
+     * chunkIndexOffsets - offset of each chunk's indices within indexData
+     * chunkIndexCounts - number of indices belonging to each chunk
+     * chunkLineOffsets - offset of each chunk's line indices within indexData
+     * chunkLineCounts - number of line indices belonging to each chunk
+     *
+     * lodCount - number of levels of detail (including full resolution)
+     * lodIndexOffsets - offset of each detail level's indices within indexData
+     * lodIndexCounts - number of indices belonging to each detail level
+     * lodLineOffsets - offset of each detail level's line indices
+     * lodLineCounts - number of line indices belonging to each detail level
      */
     GLuint depth;
     GLuint size;
+    GLuint meshSize;
     GLfloat yRange;
     GLfloat yRangeIncrement;
     GLfloat yDeviance;
     GLfloat yDevianceIncrement;
     glm::vec3 baseColour;
+    HeightPlane::Layout storageLayout;
+    GLuint isQuantised;
+    std::shared_ptr<Generator> generator;
+    GLuint chunkSize;
+    GLuint chunkCount;
 
     GLuint indexCount;
+    GLuint totalIndexCount;
     GLuint vertexCount;
     GLuint attributeCount;
+    GLuint vertexStride;
+    GLuint normalVertexCount;
 
-    std::vector<std::vector<glm::vec3>> positions;
+    HeightPlane heights;
     std::vector<std::vector<glm::vec3>> normals;
     std::vector<std::vector<glm::vec3>> colours;
 
+    std::vector<GLuint> vertexOrder;
     GLuint* indexData;
     GLfloat* vertexData;
+    PackedVertex* packedVertexData;
     GLfloat* normalVertexData;
 
+    std::vector<GLfloat> chunkMinHeights;
+    std::vector<GLfloat> chunkMaxHeights;
+    std::vector<GLuint> chunkIndexOffsets;
+    std::vector<GLsizei> chunkIndexCounts;
+    std::vector<GLuint> chunkLineOffsets;
+    std::vector<GLsizei> chunkLineCounts;
+
+    GLuint lodCount;
+    std::vector<GLuint> lodIndexOffsets;
+    std::vector<GLsizei> lodIndexCounts;
+    std::vector<GLuint> lodLineOffsets;
+    std::vector<GLsizei> lodLineCounts;
+
     Fractal(GLuint desiredDepth, GLfloat desiredYRange,
-            GLfloat desiredYDeviance, glm::vec3 desiredBaseColour);
+            GLfloat desiredYDeviance, glm::vec3 desiredBaseColour,
+            GLuint desiredChunkSize, GLuint desiredLodCount,
+            HeightPlane::Layout desiredStorageLayout,
+            GLuint desiredIsQuantised);
+    GLvoid updateLodRanges();
     GLvoid  setYPosition(GLuint x, GLuint z, GLfloat value);
     GLfloat getYPosition(GLuint x, GLuint z);
     GLvoid generate();
+    GLvoid setHeights(HeightPlane& plane);
+    GLvoid generateVertexOrder();
+    GLuint getVertexIndex(GLuint x, GLuint z);
+    GLvoid updateMeshLayout();
+    GLvoid simplify(GLfloat tolerance);
+    GLvoid simplifyChunk(GLuint chunk, GLfloat tolerance,
+                         TerrainSimplifier& simplifier,
+                         std::vector<GLuint>& triangles,
+                         std::vector<GLuint>& lines);
+    GLuint addQuadIndices(GLuint offset, GLuint x, GLuint z, GLuint stride);
+    GLuint addQuadLineIndices(GLuint offset, GLuint x, GLuint z,
+                              GLuint stride);
+    GLvoid getQuadOutline(GLuint x, GLuint z, GLuint stride,
+                          std::vector<GLuint>& outline,
+                          std::vector<GLuint>& edges);
+    GLuint addBorderQuadIndices(GLuint offset, GLuint x, GLuint z,
+                                GLuint stride);
+    GLuint addBorderQuadLineIndices(GLuint offset, GLuint x, GLuint z,
+                                    GLuint stride);
     GLvoid generateIndexData();
     GLvoid generateVertexData();
+    GLvoid generatePackedVertexData();
+    glm::vec3 getPositionScale();
+    glm::vec3 getPositionOffset();
     GLvoid generateNormalVertexData();
     GLvoid updateVertexData();
-    GLvoid updatePositions();
     GLvoid updateNormals();
     GLvoid updateColours();
+    GLvoid updateChunkBounds();
+    glm::vec3 getChunkMinimum(GLuint chunk);
+    glm::vec3 getChunkMaximum(GLuint chunk);
     GLvoid smoothPositions(std::vector<std::vector<GLfloat>> kernel);
+    GLvoid smoothQuantisedPositions(std::vector<std::vector<GLfloat>> kernel);
     GLvoid smoothNormals(std::vector<std::vector<GLfloat>> kernel);
     GLvoid smoothColours(std::vector<std::vector<GLfloat>> kernel);
     std::vector<std::vector<GLfloat>> createGaussianKernel(GLuint size,
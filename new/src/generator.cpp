@@ -0,0 +1,276 @@
+/**
+ * [Program description]
+ */
+
+#include "generator.hpp"
+#include "noisegenerator.hpp"
+#include "spectralgenerator.hpp"
+#include "escapetimegenerator.hpp"
+#include "chaosgamegenerator.hpp"
+
+/**
+ * Create a generator of the given type from the profile's values.
+ */
+template <typename T>
+Generator* createGenerator(std::map<std::string, GLfloat>& env)
+{
+  return new T(env);
+}
+
+/**
+ * Create a diamond-square generator from the profile's values.
+ */
+template <>
+Generator* createGenerator<DiamondSquareGenerator>(
+           std::map<std::string, GLfloat>& env)
+{
+  return new DiamondSquareGenerator(env["fractalYRange"],
+                                    env["fractalYDeviance"]);
+}
+
+/**
+ * Create a Mandelbrot or Julia set generator from the profile's values.
+ */
+template <GLuint isJulia>
+Generator* createEscapeTimeGenerator(std::map<std::string, GLfloat>& env)
+{
+  return new EscapeTimeGenerator(env, isJulia);
+}
+
+/**
+ * Constructor to create a generator whose heights wrap around at the edges of
+ * the plane. Generators which don't wrap clear isPeriodic.
+ */
+Generator::Generator()
+{
+  isPeriodic = true;
+}
+
+// New types of generator are added to the end of this table, in the order of
+// the Type enum, which is the value of the profile's fractalType.
+const Generator::Entry Generator::registry[] = {
+  {"diamond-square", createGenerator<DiamondSquareGenerator>},
+  {"noise", createGenerator<NoiseGenerator>},
+  {"spectral", createGenerator<SpectralGenerator>},
+  {"Mandelbrot", createEscapeTimeGenerator<false>},
+  {"Julia", createEscapeTimeGenerator<true>},
+  {"chaos game", createGenerator<ChaosGameGenerator>}
+};
+
+const GLuint Generator::typeCount = sizeof(registry) / sizeof(registry[0]);
+
+/**
+ * Create the generator chosen by the profile's fractalType.
+ */
+std::shared_ptr<Generator> Generator::create(
+                           std::map<std::string, GLfloat>& env)
+{
+  GLuint type = env["fractalType"];
+
+  if (type >= typeCount) {
+    fprintf(stderr, "unknown fractal type: %d\n", type);
+
+    exit(EXIT_FAILURE);
+  }
+
+  return std::shared_ptr<Generator>(registry[type].create(env));
+}
+
+/**
+ * Get the name of a type of generator.
+ */
+const GLchar* Generator::getName(GLuint type)
+{
+  return type < typeCount ? registry[type].name : "unknown";
+}
+
+/**
+ * Generate the heights of the plane, with the rows shared between threads.
+ * The heights are calculated as floats, and quantised planes take their range
+ * once they are all known.
+ */
+template <typename Kernel>
+GLvoid PointGenerator<Kernel>::generate(HeightPlane& plane)
+{
+  GLuint size = plane.size;
+  std::vector<GLfloat> values(size * size);
+  Kernel* kernel = static_cast<Kernel*>(this);
+
+  runInParallel(size, [&](GLuint x) {
+    kernel->generateRow(x, size, &values[x * size]);
+  });
+
+  if (plane.isQuantised) {
+    auto range = std::minmax_element(values.begin(), values.end());
+    plane.setRange(*range.first, *range.second);
+  }
+
+  for (GLuint x = 0; x < size; x++) {
+    for (GLuint z = 0; z < size; z++) {
+      plane.set(x, z, values[x * size + z]);
+    }
+  }
+}
+
+/**
+ * Calculate one row of heights. Kernels which can calculate several points at
+ * once replace this with their own version.
+ */
+template <typename Kernel>
+GLvoid PointGenerator<Kernel>::generateRow(GLuint x, GLuint size,
+                                           GLfloat* row)
+{
+  Kernel* kernel = static_cast<Kernel*>(this);
+
+  for (GLuint z = 0; z < size; z++) {
+    row[z] = kernel->getHeight(x, z);
+  }
+}
+
+/**
+ * Cells of a plane which stores floating point heights.
+ */
+class FloatCells
+{
+  public:
+    GLfloat* heights;
+    GLfloat range;
+
+    FloatCells(HeightPlane& plane)
+    {
+      heights = plane.heights.data();
+      range = 0.0f;
+    }
+
+    GLvoid setRange(GLfloat yRange)
+    {
+      range = yRange;
+    }
+
+    GLvoid displace(GLuint target, GLuint a, GLuint b, GLuint c, GLuint d)
+    {
+      heights[target] = average({heights[a], heights[b], heights[c],
+                                 heights[d]}) +
+                        randomNumber(-range, range);
+    }
+};
+
+/**
+ * Cells of a plane which stores quantised heights, which are displaced with
+ * fixed-point arithmetic.
+ */
+class QuantisedCells
+{
+  public:
+    GLushort* heights;
+    GLfloat heightScale;
+    GLfloat range;
+
+    QuantisedCells(HeightPlane& plane)
+    {
+      heights = plane.quantisedHeights.data();
+      heightScale = plane.heightScale;
+      range = 0.0f;
+    }
+
+    GLvoid setRange(GLfloat yRange)
+    {
+      range = yRange / heightScale;
+    }
+
+    GLvoid displace(GLuint target, GLuint a, GLuint b, GLuint c, GLuint d)
+    {
+      GLint sum = heights[a] + heights[b] + heights[c] + heights[d];
+      GLint value = ((sum + 2) >> 2) + lround(randomNumber(-range, range));
+
+      heights[target] = std::min(std::max(value, 0), QUANTISED_HEIGHT_MAX);
+    }
+};
+
+/**
+ * Constructor to create a diamond-square generator with the given Y range,
+ * which is scaled by the deviance after each iteration.
+ */
+DiamondSquareGenerator::DiamondSquareGenerator(GLfloat desiredYRange,
+                                               GLfloat desiredYDeviance)
+{
+  yRange = desiredYRange;
+  yDeviance = desiredYDeviance;
+}
+
+/**
+ * Generate the heights with the diamond-square algorithm. The range of a
+ * quantised plane is set to the largest range the algorithm can produce, so
+ * no height is clamped.
+ */
+GLvoid DiamondSquareGenerator::generate(HeightPlane& plane)
+{
+  if (!plane.isQuantised) {
+    displace(plane, FloatCells(plane));
+    return;
+  }
+
+  GLfloat tempYRange = yRange;
+  GLfloat bound = 0.0f;
+
+  // Each iteration can move a point by at most its Y range.
+  for (GLuint i = plane.size; i > 1; i /= 2) {
+    bound += tempYRange;
+    tempYRange *= yDeviance;
+  }
+
+  plane.setRange(-bound, bound);
+  plane.reset(plane.layout);
+
+  displace(plane, QuantisedCells(plane));
+}
+
+/**
+ * Update the points in a height plane using the midpoint displacement
+ * algorithm. The cells do the arithmetic for the plane's storage, and are
+ * compiled into the loops for each kind of storage.
+ */
+template <typename Cells>
+GLvoid DiamondSquareGenerator::displace(HeightPlane& plane, Cells cells)
+{
+  GLuint size = plane.size;
+  GLuint tempSize = size;
+  GLfloat tempYRange = yRange;
+
+  while (tempSize > 1) {
+    GLuint hs = tempSize / 2;
+
+    cells.setRange(tempYRange);
+
+    for (GLuint y = hs; y < size + hs; y += tempSize) {
+      for (GLuint x = hs; x < size + hs; x += tempSize) {
+        cells.displace(plane.getIndex(x, y),
+                       plane.getIndex(x - hs, y - hs),
+                       plane.getIndex(x + hs, y - hs),
+                       plane.getIndex(x - hs, y + hs),
+                       plane.getIndex(x + hs, y + hs));
+      }
+    }
+
+    for (GLuint y = 0; y < size; y += tempSize) {
+      for (GLuint x = 0; x < size; x += tempSize) {
+        GLuint newX = x + hs;
+        cells.displace(plane.getIndex(newX, y),
+                       plane.getIndex(newX - hs, y),
+                       plane.getIndex(newX + hs, y),
+                       plane.getIndex(newX, y - hs),
+                       plane.getIndex(newX, y + hs));
+
+        GLuint newY = y + hs;
+        cells.displace(plane.getIndex(x, newY),
+                       plane.getIndex(x - hs, newY),
+                       plane.getIndex(x + hs, newY),
+                       plane.getIndex(x, newY - hs),
+                       plane.getIndex(x, newY + hs));
+      }
+    }
+
+    tempSize /= 2;
+    tempYRange *= yDeviance;
+  }
+}
@@ -0,0 +1,79 @@
+/**
+ * [Program description]
+ */
+
+#ifndef GENERATOR_HEADER
+#define GENERATOR_HEADER
+
+class Generator
+{
+  public:
+    typedef enum {
+      DIAMOND_SQUARE,
+      NOISE,
+      SPECTRAL,
+      MANDELBROT,
+      JULIA,
+      CHAOS_GAME
+    } Type;
+
+    typedef Generator* (*Factory)(std::map<std::string, GLfloat>& env);
+
+    typedef struct {
+      const GLchar* name;
+      Factory create;
+    } Entry;
+
+    /**
+     * registry - name and factory of each type of generator, by type
+     * typeCount - number of types of generator
+     *
+     * colours - colour of each point as [x * size + z], which is left empty
+     *           by generators which don't colour their points
+     * isPeriodic - whether the heights wrap around at the edges of the plane,
+     *              so copies of the fractal can be placed side by side
+     */
+    static const Entry registry[];
+    static const GLuint typeCount;
+
+    std::vector<glm::vec3> colours;
+    GLuint isPeriodic;
+
+    Generator();
+    virtual ~Generator() {}
+    virtual GLvoid generate(HeightPlane& plane) = 0;
+    static std::shared_ptr<Generator> create(
+                                      std::map<std::string, GLfloat>& env);
+    static const GLchar* getName(GLuint type);
+};
+
+/**
+ * Base of generators which calculate each point of the plane independently.
+ * The kernel is given as the derived class, so its height function is called
+ * directly and can be inlined into the loop over the plane.
+ */
+template <typename Kernel>
+class PointGenerator : public Generator
+{
+  public:
+    GLvoid generate(HeightPlane& plane);
+    GLvoid generateRow(GLuint x, GLuint size, GLfloat* row);
+};
+
+class DiamondSquareGenerator : public Generator
+{
+  public:
+    /**
+     * yRange - Y value range of the first iteration
+     * yDeviance - factor the Y value range is scaled by each iteration
+     */
+    GLfloat yRange;
+    GLfloat yDeviance;
+
+    DiamondSquareGenerator(GLfloat desiredYRange, GLfloat desiredYDeviance);
+    GLvoid generate(HeightPlane& plane);
+    template <typename Cells>
+    GLvoid displace(HeightPlane& plane, Cells cells);
+};
+
+#endif
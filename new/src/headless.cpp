@@ -0,0 +1,155 @@
+/**
+ * [Program description]
+ */
+
+#include "headless.hpp"
+
+/**
+ * Constructor to create an empty headless context.
+ */
+HeadlessContext::HeadlessContext()
+{
+  width = 0;
+  height = 0;
+#ifndef __APPLE__
+  display = EGL_NO_DISPLAY;
+  context = EGL_NO_CONTEXT;
+#endif
+  framebuffer = 0;
+  colourBuffer = 0;
+  depthBuffer = 0;
+}
+
+/**
+ * Create an OpenGL context without a window and make it current, along with a
+ * framebuffer of the given size to render into.
+ *
+ * The context is created through EGL with no surface at all. Mesa's
+ * surfaceless platform is used when it is available, which needs neither a
+ * display server nor a GPU when rendering with llvmpipe.
+ */
+GLvoid HeadlessContext::create(GLuint desiredWidth, GLuint desiredHeight)
+{
+  width = desiredWidth;
+  height = desiredHeight;
+
+#ifdef __APPLE__
+  fprintf(stderr, "headless rendering is not supported on macOS\n");
+
+  exit(EXIT_FAILURE);
+#else
+  const GLchar* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+    (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+    eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+  if (extensions != nullptr && getPlatformDisplay != nullptr &&
+      strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                 EGL_DEFAULT_DISPLAY, nullptr);
+  } else {
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+    fprintf(stderr, "failed to initialise an EGL display\n");
+
+    exit(EXIT_FAILURE);
+  }
+
+  const EGLint configAttributes[] = {
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_NONE
+  };
+  const EGLint contextAttributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 3,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE
+  };
+  EGLConfig config;
+  EGLint configCount = 0;
+
+  eglBindAPI(EGL_OPENGL_API);
+  eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+
+  if (configCount == 0) {
+    fprintf(stderr, "failed to find an EGL config for OpenGL\n");
+
+    exit(EXIT_FAILURE);
+  }
+
+  context = eglCreateContext(display, config, EGL_NO_CONTEXT,
+                             contextAttributes);
+
+  if (context == EGL_NO_CONTEXT ||
+      !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+    fprintf(stderr, "failed to create an OpenGL 3.3 context with EGL\n");
+
+    exit(EXIT_FAILURE);
+  }
+#endif
+}
+
+/**
+ * Create the framebuffer which is rendered into in place of a window, once
+ * the OpenGL functions have been loaded.
+ */
+GLvoid HeadlessContext::createFramebuffer()
+{
+  glGenRenderbuffers(1, &colourBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, colourBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+  glGenRenderbuffers(1, &depthBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, colourBuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, depthBuffer);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    fprintf(stderr, "failed to create the headless framebuffer\n");
+
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * Save the current content of the framebuffer as a binary PPM image.
+ */
+GLvoid HeadlessContext::saveFrame(std::string filename)
+{
+  std::vector<GLubyte> pixels(width * height * 3);
+  std::ofstream file(filename.c_str(), std::ios::binary);
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+  file << "P6\n" << width << " " << height << "\n255\n";
+
+  // OpenGL stores the bottom row first, but images start at the top.
+  for (GLint y = height - 1; y >= 0; y--) {
+    file.write((const GLchar*)pixels.data() + y * width * 3, width * 3);
+  }
+}
+
+/**
+ * Delete the framebuffer and release the context.
+ */
+GLvoid HeadlessContext::destroy()
+{
+  glDeleteFramebuffers(1, &framebuffer);
+  glDeleteRenderbuffers(1, &colourBuffer);
+  glDeleteRenderbuffers(1, &depthBuffer);
+
+#ifndef __APPLE__
+  eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglDestroyContext(display, context);
+  eglTerminate(display);
+#endif
+}
@@ -0,0 +1,42 @@
+/**
+ * [Program description]
+ */
+
+#ifndef HEADLESS_HEADER
+#define HEADLESS_HEADER
+
+#ifndef __APPLE__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+class HeadlessContext
+{
+  public:
+    /**
+     * width - width of the framebuffer (in pixels)
+     * height - height of the framebuffer (in pixels)
+     * display - EGL display the context belongs to
+     * context - EGL context used for rendering
+     * framebuffer - framebuffer object which is rendered into
+     * colourBuffer - colour renderbuffer attached to the framebuffer
+     * depthBuffer - depth renderbuffer attached to the framebuffer
+     */
+    GLuint width;
+    GLuint height;
+#ifndef __APPLE__
+    EGLDisplay display;
+    EGLContext context;
+#endif
+    GLuint framebuffer;
+    GLuint colourBuffer;
+    GLuint depthBuffer;
+
+    HeadlessContext();
+    GLvoid create(GLuint desiredWidth, GLuint desiredHeight);
+    GLvoid createFramebuffer();
+    GLvoid saveFrame(std::string filename);
+    GLvoid destroy();
+};
+
+#endif
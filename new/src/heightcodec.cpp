@@ -0,0 +1,322 @@
+/**
+ * [Program description]
+ */
+
+#include "heightcodec.hpp"
+
+/**
+ * Write a height plane to a .dsq file.
+ *
+ * The heights are quantised to steps of twice the given precision, so no
+ * decoded height differs from the original by more than the precision. The
+ * quantised plane is then visited level by level in the order that the
+ * diamond-square algorithm generates it, and each point is stored as its
+ * residual against the same midpoint average the algorithm uses, predicted
+ * from points which have already been stored. These residuals shrink with
+ * the algorithm's Y range at each level, so most of the finest levels are
+ * close to zero and take only a bit or two once Rice coded.
+ *
+ * Each level is coded separately after a table of their sizes, coarsest
+ * first, so a preview only has to read the start of the file.
+ */
+GLvoid HeightCodec::encode(HeightPlane& plane, GLfloat precision,
+                           const GLchar* filename)
+{
+  GLuint size = plane.size;
+  GLfloat minimum = plane.get(0, 0);
+  GLfloat step = std::max(2.0f * precision, 1e-9f);
+
+  for (GLuint x = 0; x < size; x++) {
+    for (GLuint z = 0; z < size; z++) {
+      minimum = std::min(minimum, plane.get(x, z));
+    }
+  }
+
+  std::vector<GLint> values(size * size);
+
+  for (GLuint x = 0; x < size; x++) {
+    for (GLuint z = 0; z < size; z++) {
+      values[x * size + z] = lround((plane.get(x, z) - minimum) / step);
+    }
+  }
+
+  Header header;
+  memcpy(header.magic, "DSQ1", 4);
+  header.size = size;
+  header.levelCount = getLevelCount(size);
+  header.minimum = minimum;
+  header.step = step;
+  header.origin = values[0];
+
+  std::vector<Level> levels(header.levelCount);
+  std::vector<std::vector<GLubyte>> streams(header.levelCount);
+
+  for (GLuint level = 0; level < header.levelCount; level++) {
+    std::vector<GLuint> residuals;
+
+    // Store the residuals as unsigned values, interleaving the positive and
+    // negative residuals so that small residuals of either sign stay small.
+    walkLevel(values, size, level, [&residuals](GLint& value,
+                                                GLint prediction) {
+      GLint residual = value - prediction;
+
+      residuals.push_back(residual >= 0 ? 2 * residual : -2 * residual - 1);
+    });
+
+    size_t bitCount = 0;
+    levels[level].riceParameter = chooseRiceParameter(residuals);
+
+    for (GLuint i = 0; i < residuals.size(); i++) {
+      writeRiceCode(streams[level], bitCount, residuals[i],
+                    levels[level].riceParameter);
+    }
+
+    levels[level].byteCount = streams[level].size();
+  }
+
+  std::ofstream file(filename, std::ios::binary);
+
+  if (!file) {
+    fprintf(stderr, "failed to open file: %s\n", filename);
+
+    exit(EXIT_FAILURE);
+  }
+
+  file.write((const GLchar*)&header, sizeof(header));
+  file.write((const GLchar*)levels.data(), levels.size() * sizeof(Level));
+
+  for (GLuint level = 0; level < header.levelCount; level++) {
+    file.write((const GLchar*)streams[level].data(), streams[level].size());
+  }
+
+  file.close();
+}
+
+/**
+ * Read a height plane from a .dsq file. Only the given number of the coarsest
+ * levels are read, giving a plane of 2^levelCount points along each side
+ * which samples the full plane at regular intervals. Asking for more levels
+ * than the file has reads the whole plane.
+ */
+HeightPlane HeightCodec::decode(const GLchar* filename, GLuint levelCount)
+{
+  std::ifstream file(filename, std::ios::binary);
+  Header header;
+
+  file.read((GLchar*)&header, sizeof(header));
+
+  if (!file || memcmp(header.magic, "DSQ1", 4) != 0 ||
+      header.size == 0 || (header.size & (header.size - 1)) != 0 ||
+      header.levelCount != getLevelCount(header.size)) {
+    fprintf(stderr, "failed to read terrain: %s\n", filename);
+
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<Level> levels(header.levelCount);
+  file.read((GLchar*)levels.data(), levels.size() * sizeof(Level));
+
+  levelCount = std::min(levelCount, header.levelCount);
+
+  GLuint size = 1 << levelCount;
+  std::vector<GLint> values(size * size);
+  values[0] = header.origin;
+
+  // The coarse levels of the full plane have the same structure as a smaller
+  // plane, so they are decoded directly into the smaller plane.
+  for (GLuint level = 0; level < levelCount; level++) {
+    std::vector<GLubyte> stream(levels[level].byteCount);
+    GLuint parameter = levels[level].riceParameter;
+    size_t bitCount = 0;
+
+    file.read((GLchar*)stream.data(), stream.size());
+
+    if (!file) {
+      fprintf(stderr, "failed to read terrain: %s\n", filename);
+
+      exit(EXIT_FAILURE);
+    }
+
+    walkLevel(values, size, level, [&](GLint& value, GLint prediction) {
+      GLuint residual = readRiceCode(stream, bitCount, parameter);
+
+      value = prediction + ((residual & 1) ? -(GLint)(residual >> 1) - 1 :
+                                             (GLint)(residual >> 1));
+    });
+  }
+
+  file.close();
+
+  HeightPlane plane(size);
+
+  for (GLuint x = 0; x < size; x++) {
+    for (GLuint z = 0; z < size; z++) {
+      plane.set(x, z, header.minimum + values[x * size + z] * header.step);
+    }
+  }
+
+  return plane;
+}
+
+/**
+ * Get the number of levels the diamond-square algorithm takes to fill a plane
+ * of the given size.
+ */
+GLuint HeightCodec::getLevelCount(GLuint size)
+{
+  GLuint levelCount = 0;
+
+  while ((1u << levelCount) < size) {
+    levelCount++;
+  }
+
+  return levelCount;
+}
+
+/**
+ * Visit the points filled in by one level of the diamond-square algorithm, in
+ * the order the algorithm fills them, along with the midpoint average of
+ * their neighbours. The visitor sets the value of each point, and points are
+ * only predicted from points of earlier levels or the diamond step.
+ */
+template <typename T>
+GLvoid HeightCodec::walkLevel(std::vector<GLint>& values, GLuint size,
+                              GLuint level, T visit)
+{
+  GLuint tempSize = size >> level;
+  GLuint hs = tempSize / 2;
+  GLuint mask = size - 1;
+
+  auto at = [&](GLuint x, GLuint z) -> GLint& {
+    return values[(x & mask) * size + (z & mask)];
+  };
+
+  for (GLuint x = hs; x < size; x += tempSize) {
+    for (GLuint z = hs; z < size; z += tempSize) {
+      GLint sum = at(x - hs, z - hs) + at(x + hs, z - hs) +
+                  at(x - hs, z + hs) + at(x + hs, z + hs);
+
+      visit(at(x, z), (sum + 2) >> 2);
+    }
+  }
+
+  for (GLuint x = 0; x < size; x += tempSize) {
+    for (GLuint z = 0; z < size; z += tempSize) {
+      GLuint newX = x + hs;
+      GLint sum = at(newX - hs, z) + at(newX + hs, z) +
+                  at(newX, z - hs) + at(newX, z + hs);
+
+      visit(at(newX, z), (sum + 2) >> 2);
+
+      GLuint newZ = z + hs;
+      sum = at(x - hs, newZ) + at(x + hs, newZ) +
+            at(x, newZ - hs) + at(x, newZ + hs);
+
+      visit(at(x, newZ), (sum + 2) >> 2);
+    }
+  }
+}
+
+/**
+ * Find the Rice parameter which codes the given values in the fewest bits.
+ */
+GLuint HeightCodec::chooseRiceParameter(std::vector<GLuint>& values)
+{
+  GLuint bestParameter = 0;
+  GLuint64 bestBitCount = ~0ull;
+
+  for (GLuint parameter = 0; parameter < 24; parameter++) {
+    GLuint64 bitCount = 0;
+
+    for (GLuint i = 0; i < values.size(); i++) {
+      GLuint quotient = values[i] >> parameter;
+
+      bitCount += (quotient < RICE_ESCAPE_QUOTIENT) ?
+                  quotient + 1 + parameter : RICE_ESCAPE_QUOTIENT + 32;
+    }
+
+    if (bitCount < bestBitCount) {
+      bestBitCount = bitCount;
+      bestParameter = parameter;
+    }
+  }
+
+  return bestParameter;
+}
+
+/**
+ * Append the lowest bits of a value to a stream, most significant first.
+ */
+GLvoid HeightCodec::writeBits(std::vector<GLubyte>& bytes, size_t& bitCount,
+                              GLuint value, GLuint length)
+{
+  for (GLint i = length - 1; i >= 0; i--) {
+    if (bitCount % 8 == 0) {
+      bytes.push_back(0);
+    }
+
+    bytes.back() |= ((value >> i) & 1) << (7 - bitCount % 8);
+    bitCount++;
+  }
+}
+
+/**
+ * Read a value of the given number of bits from a stream. Reading past the end
+ * of the stream gives zero bits.
+ */
+GLuint HeightCodec::readBits(std::vector<GLubyte>& bytes, size_t& bitCount,
+                             GLuint length)
+{
+  GLuint value = 0;
+
+  for (GLuint i = 0; i < length; i++) {
+    GLuint bit = (bitCount / 8 < bytes.size()) ?
+                 (bytes[bitCount / 8] >> (7 - bitCount % 8)) & 1 : 0;
+
+    value = (value << 1) | bit;
+    bitCount++;
+  }
+
+  return value;
+}
+
+/**
+ * Append a Rice code to a stream: the value divided by 2^parameter in unary,
+ * followed by the remainder in binary. Values with a very large quotient are
+ * escaped and written in full instead.
+ */
+GLvoid HeightCodec::writeRiceCode(std::vector<GLubyte>& bytes,
+                                  size_t& bitCount, GLuint value,
+                                  GLuint parameter)
+{
+  GLuint quotient = value >> parameter;
+
+  if (quotient >= RICE_ESCAPE_QUOTIENT) {
+    writeBits(bytes, bitCount, ~0u, RICE_ESCAPE_QUOTIENT);
+    writeBits(bytes, bitCount, value, 32);
+    return;
+  }
+
+  writeBits(bytes, bitCount, ~0u, quotient);
+  writeBits(bytes, bitCount, 0, 1);
+  writeBits(bytes, bitCount, value, parameter);
+}
+
+/**
+ * Read a Rice code from a stream.
+ */
+GLuint HeightCodec::readRiceCode(std::vector<GLubyte>& bytes, size_t& bitCount,
+                                 GLuint parameter)
+{
+  GLuint quotient = 0;
+
+  while (quotient < RICE_ESCAPE_QUOTIENT && readBits(bytes, bitCount, 1)) {
+    quotient++;
+  }
+
+  if (quotient == RICE_ESCAPE_QUOTIENT) {
+    return readBits(bytes, bitCount, 32);
+  }
+
+  return (quotient << parameter) | readBits(bytes, bitCount, parameter);
+}
@@ -0,0 +1,46 @@
+/**
+ * [Program description]
+ */
+
+#ifndef HEIGHT_CODEC_HEADER
+#define HEIGHT_CODEC_HEADER
+
+// Rice codes with a quotient this large are escaped and stored in full.
+#define RICE_ESCAPE_QUOTIENT 32
+
+class HeightCodec
+{
+  public:
+    typedef struct {
+      GLchar magic[4];
+      GLuint size;
+      GLuint levelCount;
+      GLfloat minimum;
+      GLfloat step;
+      GLint origin;
+    } Header;
+
+    typedef struct {
+      GLuint byteCount;
+      GLuint riceParameter;
+    } Level;
+
+    static GLvoid encode(HeightPlane& plane, GLfloat precision,
+                         const GLchar* filename);
+    static HeightPlane decode(const GLchar* filename, GLuint levelCount);
+    static GLuint getLevelCount(GLuint size);
+    template <typename T>
+    static GLvoid walkLevel(std::vector<GLint>& values, GLuint size,
+                            GLuint level, T visit);
+    static GLuint chooseRiceParameter(std::vector<GLuint>& values);
+    static GLvoid writeBits(std::vector<GLubyte>& bytes, size_t& bitCount,
+                            GLuint value, GLuint length);
+    static GLuint readBits(std::vector<GLubyte>& bytes, size_t& bitCount,
+                           GLuint length);
+    static GLvoid writeRiceCode(std::vector<GLubyte>& bytes, size_t& bitCount,
+                                GLuint value, GLuint parameter);
+    static GLuint readRiceCode(std::vector<GLubyte>& bytes, size_t& bitCount,
+                               GLuint parameter);
+};
+
+#endif
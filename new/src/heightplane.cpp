@@ -0,0 +1,159 @@
+/**
+ * [Program description]
+ */
+
+#include "heightplane.hpp"
+
+/**
+ * Constructor to create a flat plane of a given size and storage layout.
+ * Quantised planes cover the range [-1, 1] until another range is set.
+ */
+HeightPlane::HeightPlane(GLuint desiredSize, Layout desiredLayout,
+                         GLuint desiredIsQuantised)
+{
+  size = desiredSize;
+  layout = desiredLayout;
+  isQuantised = desiredIsQuantised;
+
+  if (isQuantised) {
+    quantisedHeights = std::vector<GLushort>(size * size);
+  } else {
+    heights = std::vector<GLfloat>(size * size, 0.0f);
+  }
+
+  setRange(-1.0f, 1.0f);
+}
+
+/**
+ * Get the position of a point within the heights array. Coordinates wrap
+ * around the edges of the plane.
+ *
+ * In the Morton layout, points which are close together on the plane are
+ * close together in memory at every scale, so the distant neighbours read at
+ * the coarse levels of the diamond-square algorithm share cache lines and
+ * pages far more often than with rows.
+ */
+GLuint HeightPlane::getIndex(GLuint x, GLuint z)
+{
+  x &= size - 1;
+  z &= size - 1;
+
+  if (layout == MORTON) {
+    return mortonEncode(x, z);
+  }
+
+  return x * size + z;
+}
+
+/**
+ * Get the Y value at a given point.
+ */
+GLfloat HeightPlane::get(GLuint x, GLuint z)
+{
+  if (isQuantised) {
+    return dequantise(quantisedHeights[getIndex(x, z)]);
+  }
+
+  return heights[getIndex(x, z)];
+}
+
+/**
+ * Set the Y value at a given point.
+ */
+GLvoid HeightPlane::set(GLuint x, GLuint z, GLfloat value)
+{
+  if (isQuantised) {
+    quantisedHeights[getIndex(x, z)] = quantise(value);
+  } else {
+    heights[getIndex(x, z)] = value;
+  }
+}
+
+/**
+ * Set the range of Y values which can be represented by a quantised plane.
+ * This should be done before any heights are stored.
+ */
+GLvoid HeightPlane::setRange(GLfloat minimum, GLfloat maximum)
+{
+  if (maximum <= minimum) {
+    maximum = minimum + 1.0f;
+  }
+
+  heightOffset = minimum;
+  heightScale = (maximum - minimum) / (GLfloat)QUANTISED_HEIGHT_MAX;
+}
+
+/**
+ * Convert a Y value to the nearest quantised value within range.
+ */
+GLint HeightPlane::quantise(GLfloat value)
+{
+  GLint quantised = lround((value - heightOffset) / heightScale);
+
+  return std::min(std::max(quantised, 0), QUANTISED_HEIGHT_MAX);
+}
+
+/**
+ * Convert a quantised value to a Y value.
+ */
+GLfloat HeightPlane::dequantise(GLint value)
+{
+  return heightOffset + value * heightScale;
+}
+
+/**
+ * Flatten the plane and change its layout.
+ */
+GLvoid HeightPlane::reset(Layout desiredLayout)
+{
+  layout = desiredLayout;
+
+  if (isQuantised) {
+    std::fill(quantisedHeights.begin(), quantisedHeights.end(), quantise(0.0f));
+  } else {
+    std::fill(heights.begin(), heights.end(), 0.0f);
+  }
+}
+
+/**
+ * Reorder an array of values between the linear and Morton layouts.
+ */
+template <typename T>
+GLvoid reorderHeights(std::vector<T>& values, GLuint size,
+                      HeightPlane::Layout desiredLayout)
+{
+  std::vector<T> newValues(values.size());
+
+  for (GLuint x = 0; x < size; x++) {
+    for (GLuint z = 0; z < size; z++) {
+      GLuint linearIndex = x * size + z;
+      GLuint mortonIndex = mortonEncode(x, z);
+
+      if (desiredLayout == HeightPlane::LINEAR) {
+        newValues[linearIndex] = values[mortonIndex];
+      } else {
+        newValues[mortonIndex] = values[linearIndex];
+      }
+    }
+  }
+
+  values.swap(newValues);
+}
+
+/**
+ * Reorder the heights into a different layout.
+ */
+GLvoid HeightPlane::convertToLayout(Layout desiredLayout)
+{
+  if (desiredLayout == layout) {
+    return;
+  }
+
+  if (isQuantised) {
+    reorderHeights(quantisedHeights, size, desiredLayout);
+  } else {
+    reorderHeights(heights, size, desiredLayout);
+  }
+
+  layout = desiredLayout;
+}
@@ -0,0 +1,49 @@
+/**
+ * [Program description]
+ */
+
+#ifndef HEIGHT_PLANE_HEADER
+#define HEIGHT_PLANE_HEADER
+
+#define QUANTISED_HEIGHT_MAX 65535
+
+class HeightPlane
+{
+  public:
+    typedef enum {
+      LINEAR,
+      MORTON
+    } Layout;
+
+    /**
+     * size - width/height of the plane (must be a power of two)
+     * layout - order in which the heights are stored
+     * isQuantised - whether heights are stored as 16-bit fixed-point values
+     * heightScale - Y value represented by one quantised step
+     * heightOffset - Y value represented by a quantised value of zero
+     *
+     * heights - Y value of each point of the plane
+     * quantisedHeights - quantised Y value of each point of the plane
+     */
+    GLuint size;
+    Layout layout;
+    GLuint isQuantised;
+    GLfloat heightScale;
+    GLfloat heightOffset;
+
+    std::vector<GLfloat> heights;
+    std::vector<GLushort> quantisedHeights;
+
+    HeightPlane(GLuint desiredSize = 0, Layout desiredLayout = LINEAR,
+                GLuint desiredIsQuantised = false);
+    GLuint getIndex(GLuint x, GLuint z);
+    GLfloat get(GLuint x, GLuint z);
+    GLvoid set(GLuint x, GLuint z, GLfloat value);
+    GLvoid setRange(GLfloat minimum, GLfloat maximum);
+    GLint quantise(GLfloat value);
+    GLfloat dequantise(GLint value);
+    GLvoid reset(Layout desiredLayout);
+    GLvoid convertToLayout(Layout desiredLayout);
+};
+
+#endif
@@ -5,11 +5,21 @@
 #ifndef HELPER_HEADER
 #define HELPER_HEADER
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <math.h>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string.h>
 #include <fstream>
+#include <functional>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 /**
@@ -36,6 +46,30 @@ GLfloat average(std::initializer_list<GLfloat> values)
   return sum / (GLfloat)count;
 }
 
+/**
+ * Spread the lower 16 bits of a value so that there is a zero bit between
+ * each of them.
+ */
+GLuint spreadBits(GLuint value)
+{
+  value &= 0x0000FFFF;
+  value = (value | (value << 8)) & 0x00FF00FF;
+  value = (value | (value << 4)) & 0x0F0F0F0F;
+  value = (value | (value << 2)) & 0x33333333;
+  value = (value | (value << 1)) & 0x55555555;
+
+  return value;
+}
+
+/**
+ * Interleave the bits of two coordinates to find their position along a
+ * Z-order (Morton) curve.
+ */
+GLuint mortonEncode(GLuint x, GLuint z)
+{
+  return (spreadBits(x) << 1) | spreadBits(z);
+}
+
 /**
  * Read the whole content of a given file into a char array.
  */
@@ -125,4 +159,47 @@ std::map<std::string, GLfloat> readProfile(const GLchar* filename)
   return environmentVariables;
 }
 
+/**
+ * Get the number of threads to share work between, one for each core.
+ */
+GLuint getThreadCount()
+{
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+/**
+ * Run the work on every thread at once, given the number of each thread, and
+ * wait for all of them to finish.
+ */
+GLvoid runOnThreads(std::function<GLvoid(GLuint)> work)
+{
+  std::vector<std::thread> threads;
+  GLuint threadCount = getThreadCount();
+
+  for (GLuint i = 0; i < threadCount; i++) {
+    threads.push_back(std::thread(work, i));
+  }
+
+  for (GLuint i = 0; i < threadCount; i++) {
+    threads[i].join();
+  }
+}
+
+/**
+ * Run the work once for each item, given the number of the item, with the
+ * items handed out to the threads one at a time as they become free.
+ */
+GLvoid runInParallel(GLuint count, std::function<GLvoid(GLuint)> work)
+{
+  std::atomic<GLuint> nextItem(0);
+
+  runOnThreads([&](GLuint thread) {
+    GLuint item;
+
+    while ((item = nextItem++) < count) {
+      work(item);
+    }
+  });
+}
+
 #endif
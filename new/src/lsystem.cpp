@@ -0,0 +1,315 @@
+/**
+ * [Program description]
+ */
+
+#include <array>
+#include <float.h>
+#include <limits.h>
+
+#include "lsystem.hpp"
+
+/**
+ * Constructor to create one of the preset curves from the profile's values.
+ * The number of iterations is lowered until the curve fits within the
+ * profile's limit on its vertices, which is at most INT_MAX, as the line
+ * strips' first vertices are stored as GLints.
+ */
+LSystem::LSystem(std::map<std::string, GLfloat>& env)
+{
+  type = (Type)std::min((GLuint)env["lSystemType"], (GLuint)MOORE_CURVE_3D);
+  iterationCount = env["lSystemIterationCount"];
+  vertexLimit = std::min(std::max((GLdouble)env["lSystemVertexLimit"], 2.0),
+                         (GLdouble)INT_MAX);
+
+  // The Moore curves are four (or eight) Hilbert curves joined into a loop,
+  // and the 3D Koch curve turns the bumps of each level at right angles to
+  // the bumps of the level before.
+  switch (type) {
+    case KOCH_SNOWFLAKE:
+      setRules("F--F--F", {{'F', "F+F--F+F"}}, 60.0, 1.0 / 3.0);
+      break;
+    case DRAGON_CURVE:
+      setRules("FX", {{'X', "X+YF+"}, {'Y', "-FX-Y"}}, 90.0, sqrt(0.5));
+      break;
+    case MOORE_CURVE:
+      setRules("LFL+F+LFL+F", {{'L', "-RF+LFL+FR-"}, {'R', "+LF-RFR-FL+"}},
+               90.0, 0.5);
+      break;
+    case KOCH_CURVE_3D:
+      setRules("F+F+F+F", {{'F', "/F+F-F-F+F\\"}}, 90.0, 1.0 / 3.0);
+      break;
+    case MOORE_CURVE_3D:
+      setRules("A+F^A+F/A&F/A+F/A+F^A+F/A&F/A+F",
+               {{'A', "B-F+CFC+F-D&F^D-F+&&CFC+F+B//"},
+                {'B', "A&F^CFB^F^D^^-F-D^|F^B|FC^F^A//"},
+                {'C', "|D^|F^B-F+C^F^A&&FA&F^C+F+B^F^D//"},
+                {'D', "|CFB-F+B|FA&F^A&&FB-F+B|FC//"}}, 90.0, 0.5);
+      break;
+  }
+
+  while (iterationCount > 0 && countVertices(iterationCount) > vertexLimit) {
+    iterationCount--;
+  }
+
+  restart();
+}
+
+/**
+ * Get the name of a preset curve.
+ */
+const GLchar* LSystem::getName(GLuint type)
+{
+  const GLchar* names[] = {"Koch snowflake", "dragon curve", "Moore curve",
+                           "Koch curve in 3D", "Moore curve in 3D"};
+
+  return names[std::min(type, (GLuint)MOORE_CURVE_3D)];
+}
+
+/**
+ * Set the axiom and the rules it is rewritten with. F and G draw a step, f
+ * moves a step without drawing, + and - turn left and right, & and ^ pitch
+ * down and up, \ and / roll left and right, | turns around, and [ and ] save
+ * and restore the turtle. Each step is the given scale of the length of the
+ * steps of the iteration before.
+ */
+GLvoid LSystem::setRules(const std::string& desiredAxiom,
+                         const std::map<GLchar, std::string>& desiredRules,
+                         GLdouble angle, GLdouble desiredLengthScale)
+{
+  axiom = desiredAxiom;
+  lengthScale = desiredLengthScale;
+  rules.assign(L_SYSTEM_SYMBOL_COUNT, std::string());
+  commands.assign(L_SYSTEM_SYMBOL_COUNT, NONE);
+  rotations.resize(L_SYSTEM_SYMBOL_COUNT);
+
+  for (auto& rule : desiredRules) {
+    rules[(GLubyte)rule.first] = rule.second;
+  }
+
+  commands['F'] = DRAW;
+  commands['G'] = DRAW;
+  commands['f'] = MOVE;
+  commands['['] = PUSH;
+  commands[']'] = POP;
+
+  // The turtle's up, left and heading directions are its orientation's
+  // columns 2, 1 and 0.
+  setRotation('+', 2, angle);
+  setRotation('-', 2, -angle);
+  setRotation('&', 1, angle);
+  setRotation('^', 1, -angle);
+  setRotation('\\', 0, angle);
+  setRotation('/', 0, -angle);
+  setRotation('|', 2, 180.0);
+}
+
+/**
+ * Make the symbol turn the turtle by the angle, in degrees, about one of its
+ * directions. Rotations by multiples of 90 degrees are kept exact, so the
+ * turtle does not drift from the grid of a curve such as the Moore curve.
+ */
+GLvoid LSystem::setRotation(GLchar symbol, GLuint axis, GLdouble angle)
+{
+  std::array<GLdouble, 9>& rotation = rotations[(GLubyte)symbol];
+  GLdouble cosine = cos(angle * M_PI / 180.0);
+  GLdouble sine = sin(angle * M_PI / 180.0);
+  GLuint i = (axis + 1) % 3, j = (axis + 2) % 3;
+
+  if (fabs(cosine - round(cosine)) < 1e-12) {
+    cosine = round(cosine);
+  }
+  if (fabs(sine - round(sine)) < 1e-12) {
+    sine = round(sine);
+  }
+
+  rotation.fill(0.0);
+  rotation[axis * 3 + axis] = 1.0;
+  rotation[i * 3 + i] = cosine;
+  rotation[j * 3 + j] = cosine;
+  rotation[j * 3 + i] = sine;
+  rotation[i * 3 + j] = -sine;
+  commands[(GLubyte)symbol] = TURN;
+}
+
+/**
+ * Count the most vertices the curve can have after the given number of
+ * iterations, without rewriting it. Each line strip has one more vertex than
+ * it has steps, and a new strip can only start after a move or a restore.
+ */
+GLdouble LSystem::countVertices(GLuint iterations)
+{
+  std::vector<GLdouble> steps(L_SYSTEM_SYMBOL_COUNT, 0.0);
+  std::vector<GLdouble> breaks(L_SYSTEM_SYMBOL_COUNT, 0.0);
+  GLdouble stepCount = 0.0, breakCount = 0.0;
+
+  for (GLuint symbol = 0; symbol < L_SYSTEM_SYMBOL_COUNT; symbol++) {
+    steps[symbol] = (commands[symbol] == DRAW);
+    breaks[symbol] = (commands[symbol] == MOVE || commands[symbol] == POP);
+  }
+
+  // Count the steps and breaks each symbol becomes, one iteration at a time.
+  for (GLuint i = 0; i < iterations; i++) {
+    std::vector<GLdouble> nextSteps = steps, nextBreaks = breaks;
+
+    for (GLuint symbol = 0; symbol < L_SYSTEM_SYMBOL_COUNT; symbol++) {
+      if (rules[symbol].empty()) {
+        continue;
+      }
+
+      nextSteps[symbol] = 0.0;
+      nextBreaks[symbol] = 0.0;
+
+      for (GLchar next : rules[symbol]) {
+        nextSteps[symbol] += steps[(GLubyte)next];
+        nextBreaks[symbol] += breaks[(GLubyte)next];
+      }
+    }
+
+    steps.swap(nextSteps);
+    breaks.swap(nextBreaks);
+  }
+
+  for (GLchar symbol : axiom) {
+    stepCount += steps[(GLubyte)symbol];
+    breakCount += breaks[(GLubyte)symbol];
+  }
+
+  return stepCount + breakCount + 1.0;
+}
+
+/**
+ * Start the walk of the curve again from the axiom, with the turtle at the
+ * origin heading along the X axis, with up along the Z axis.
+ */
+GLvoid LSystem::restart()
+{
+  Turtle origin = {{0.0, 0.0, 0.0},
+                   {1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0}};
+
+  frames.clear();
+  frames.reserve(iterationCount + 1);
+  frames.push_back({axiom.c_str(), iterationCount});
+  turtle = origin;
+  turtles.clear();
+  stepLength = pow(lengthScale, iterationCount);
+  isStripOpen = false;
+  vertexCount = 0;
+  stripFirsts.clear();
+  stripCounts.clear();
+  minimum = glm::vec3(FLT_MAX);
+  maximum = glm::vec3(-FLT_MAX);
+}
+
+/**
+ * Walk the curve's rewrites from where the last call stopped and write the
+ * positions of up to the given number of vertices. The rewrites are walked
+ * depth first with a stack of the rules being walked, one for each level of
+ * rewriting, so the rewritten symbols are never stored. Return the number of
+ * vertices written.
+ */
+GLuint LSystem::generate(GLfloat* vertices, GLuint capacity)
+{
+  GLuint written = 0;
+
+  while (!frames.empty()) {
+    Frame& frame = frames.back();
+    GLubyte symbol = *frame.symbols;
+
+    if (symbol == '\0') {
+      frames.pop_back();
+      continue;
+    }
+
+    frame.symbols++;
+
+    if (frame.depth > 0 && !rules[symbol].empty()) {
+      frames.push_back({rules[symbol].c_str(), frame.depth - 1});
+      continue;
+    }
+
+    switch (commands[symbol]) {
+      case NONE:
+        break;
+      case DRAW:
+      case MOVE:
+        // Stop before a step with no room for its vertices, so the next call
+        // takes the step instead.
+        if (commands[symbol] == DRAW && written + 2 - isStripOpen > capacity) {
+          frame.symbols--;
+
+          return written;
+        }
+
+        // Start a line strip from the turtle's position before its first
+        // step.
+        if (commands[symbol] == DRAW && !isStripOpen) {
+          stripFirsts.push_back(vertexCount);
+          stripCounts.push_back(0);
+          addVertex(&vertices[L_SYSTEM_VERTEX_SIZE * written++]);
+          isStripOpen = true;
+        }
+
+        for (GLuint i = 0; i < 3; i++) {
+          turtle.position[i] += turtle.orientation[i * 3] * stepLength;
+        }
+
+        if (commands[symbol] == DRAW) {
+          addVertex(&vertices[L_SYSTEM_VERTEX_SIZE * written++]);
+        } else {
+          isStripOpen = false;
+        }
+        break;
+      case TURN: {
+        const GLdouble* rotation = rotations[symbol].data();
+        GLdouble orientation[9];
+
+        for (GLuint i = 0; i < 3; i++) {
+          for (GLuint j = 0; j < 3; j++) {
+            orientation[i * 3 + j] =
+              turtle.orientation[i * 3] * rotation[j] +
+              turtle.orientation[i * 3 + 1] * rotation[3 + j] +
+              turtle.orientation[i * 3 + 2] * rotation[6 + j];
+          }
+        }
+
+        std::copy(orientation, orientation + 9, turtle.orientation);
+        break;
+      }
+      case PUSH:
+        turtles.push_back(turtle);
+        break;
+      case POP:
+        if (!turtles.empty()) {
+          turtle = turtles.back();
+          turtles.pop_back();
+        }
+        isStripOpen = false;
+        break;
+    }
+  }
+
+  return written;
+}
+
+/**
+ * Write the turtle's position as the next vertex of the last line strip.
+ */
+GLvoid LSystem::addVertex(GLfloat* vertex)
+{
+  for (GLuint i = 0; i < 3; i++) {
+    vertex[i] = turtle.position[i];
+    minimum[i] = std::min(minimum[i], vertex[i]);
+    maximum[i] = std::max(maximum[i], vertex[i]);
+  }
+
+  stripCounts.back()++;
+  vertexCount++;
+}
+
+/**
+ * Check whether every vertex of the curve has been generated.
+ */
+GLuint LSystem::isFinished()
+{
+  return frames.empty();
+}
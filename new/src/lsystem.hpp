@@ -0,0 +1,105 @@
+/**
+ * [Program description]
+ */
+
+#ifndef L_SYSTEM_HEADER
+#define L_SYSTEM_HEADER
+
+// Number of floats per vertex of a curve. Only the positions are stored, as
+// the whole curve has the same normal and colour.
+#define L_SYSTEM_VERTEX_SIZE 3
+
+// Number of symbols an L-system can use, one for each byte.
+#define L_SYSTEM_SYMBOL_COUNT 256
+
+class LSystem
+{
+  public:
+    typedef enum {
+      KOCH_SNOWFLAKE,
+      DRAGON_CURVE,
+      MOORE_CURVE,
+      KOCH_CURVE_3D,
+      MOORE_CURVE_3D
+    } Type;
+
+    // Action of the turtle for a symbol which is not rewritten any further.
+    typedef enum {
+      NONE,
+      DRAW,
+      MOVE,
+      TURN,
+      PUSH,
+      POP
+    } Command;
+
+    // Next symbol to walk in a rule, and the number of times the rule's
+    // symbols can still be rewritten.
+    typedef struct {
+      const GLchar* symbols;
+      GLuint depth;
+    } Frame;
+
+    // Position of the turtle, and its heading, left and up directions as the
+    // columns of its orientation, with the orientation's rows in order.
+    typedef struct {
+      GLdouble position[3];
+      GLdouble orientation[9];
+    } Turtle;
+
+    /**
+     * type - preset curve
+     * iterationCount - number of times the axiom is rewritten
+     * vertexLimit - largest number of vertices of the curve, up to INT_MAX
+     * axiom - symbols the curve is rewritten from
+     * rules - symbols that each symbol is rewritten as, or empty if the
+     *         symbol is kept
+     * commands - action of the turtle for each symbol
+     * rotations - rotation of the turtle by each turning symbol
+     * lengthScale - length of a step after each rewrite, relative to before
+     *
+     * frames - rules being walked, one for each level of rewriting
+     * turtle - current state of the turtle
+     * turtles - states of the turtle saved by the push command
+     * stepLength - distance moved by each step of the turtle
+     * isStripOpen - whether the next step continues the last line strip
+     * vertexCount - number of vertices generated so far
+     * stripFirsts - first vertex of each line strip
+     * stripCounts - number of vertices of each line strip
+     * minimum - lowest corner of the vertices' bounds
+     * maximum - highest corner of the vertices' bounds
+     */
+    Type type;
+    GLuint iterationCount;
+    GLdouble vertexLimit;
+    std::string axiom;
+    std::vector<std::string> rules;
+    std::vector<Command> commands;
+    std::vector<std::array<GLdouble, 9>> rotations;
+    GLdouble lengthScale;
+
+    std::vector<Frame> frames;
+    Turtle turtle;
+    std::vector<Turtle> turtles;
+    GLdouble stepLength;
+    GLuint isStripOpen;
+    GLuint vertexCount;
+    std::vector<GLint> stripFirsts;
+    std::vector<GLsizei> stripCounts;
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+
+    LSystem(std::map<std::string, GLfloat>& env);
+    static const GLchar* getName(GLuint type);
+    GLvoid setRules(const std::string& desiredAxiom,
+                    const std::map<GLchar, std::string>& desiredRules,
+                    GLdouble angle, GLdouble desiredLengthScale);
+    GLvoid setRotation(GLchar symbol, GLuint axis, GLdouble angle);
+    GLdouble countVertices(GLuint iterations);
+    GLvoid restart();
+    GLuint generate(GLfloat* vertices, GLuint capacity);
+    GLvoid addVertex(GLfloat* vertex);
+    GLuint isFinished();
+};
+
+#endif
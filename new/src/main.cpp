@@ -10,14 +10,37 @@ GLint frameWidth, frameHeight;
 GLfloat aspectRatio;
 
 // Buffer and shader info.
-GLuint vao[1], vbo[1], ebo[1], fractalShader, normalShader;
+GLuint vao[Shader::NONE], vbo[Shader::NONE], ebo[Shader::NONE], fractalShader, wireframeShader, normalShader;
+GLsizeiptr vboSizes[Shader::NONE], eboSizes[Shader::NONE];
 
 // environment info
 const GLchar* profile;
 std::map<std::string, GLfloat> env;
+GLuint isStorageBenchmarkEnabled = false;
+GLuint isExportEnabled = false;
+GLuint headlessFrameCount = 0;
+GLuint isHeadlessCaptureEnabled = false;
+HeadlessContext headless;
+Recorder recorder;
+const GLchar* recordingFilename = nullptr;
+const GLchar* replayFilename = nullptr;
+FrameCapture capture;
+GLuint isCaptureEnabled = false;
+GLuint captureFrameRate = 60;
+const GLchar* terrainFilename = nullptr;
+const GLchar* compressedTerrainFilename = nullptr;
+const GLchar* locationFilename = nullptr;
+GLuint rayMarchFrameCount = 0;
+const GLchar* ifsFilename = nullptr;
+GLuint64 chaosGameIterationCount = 0;
 
 // keyboard info
 GLuint keyPressed[512];
+const GLint heldKeys[] = {
+  GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_U,
+  GLFW_KEY_J, GLFW_KEY_O, GLFW_KEY_L, GLFW_KEY_I, GLFW_KEY_K
+};
+const GLuint heldKeyCount = sizeof(heldKeys) / sizeof(heldKeys[0]);
 
 // mouse info
 GLfloat lastMouseX = DEFAULT_WINDOW_WIDTH / 2.0f;
@@ -37,16 +60,41 @@ Camera camera(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f),
 glm::vec3 lightPosition(0.0f);
 
 // fractal info
-Fractal fractal(0, 0.0f, 0.0f, glm::vec3(0.0f));
+Fractal fractal(0, 0.0f, 0.0f, glm::vec3(0.0f), 0, 0, HeightPlane::LINEAR,
+                false);
+Culler culler;
+TerrainCache terrainCache;
+Exporter exporter;
+GLuint isFractalCached = false;
+std::string escapeCentreReal, escapeCentreImaginary;
+GLdouble escapeWidth;
 GLuint isPointLightingEnabled;
 GLuint areFacesEnabled;
 GLuint areNormalsEnabled;
 GLuint isWireframeEnabled;
 GLuint isCullingEnabled;
+GLuint isChunkCullingEnabled;
+GLuint isHorizonCullingEnabled;
+GLuint instanceRingCount;
 GLfloat shineValue = 1.0f;
 GLfloat defaultNormalLength, normalLength;
 glm::vec4 wireframeColour;
 
+// 3D fractal info
+GLuint isVolumeEnabled;
+GLuint isVoxelEnabled;
+GLuint isChaosCloudEnabled;
+GLuint isLSystemEnabled;
+GLuint volumeTriangleIndexCount = 0, volumeLineIndexCount = 0;
+GLuint volumePointCount = 0;
+GLfloat volumeRadius = 1.0f;
+glm::vec3 volumeCentre(0.0f);
+std::vector<GLint> curveStripFirsts;
+std::vector<GLsizei> curveStripCounts;
+glm::vec3 curveColour(0.0f);
+std::unique_ptr<VoxelFractal> voxelFractal;
+glm::vec3 voxelViewPosition;
+
 // misc. info
 glm::vec3 backgroundColour(0.0f);
 
@@ -56,6 +104,11 @@ glm::vec3 backgroundColour(0.0f);
 GLvoid keyboard(GLFWwindow* window, GLint key, GLint scancode,
                 GLint action, GLint mode)
 {
+  // Ignore the keyboard during a replay, other than to quit.
+  if (recorder.mode == Recorder::REPLAYING && key != GLFW_KEY_ESCAPE) {
+    return;
+  }
+
   // Store the action state of the given key.
   keyPressed[key] = action;
 
@@ -63,19 +116,76 @@ GLvoid keyboard(GLFWwindow* window, GLint key, GLint scancode,
     return;
   }
 
+  // Pick the seed for any random numbers the key needs, so that a replay of
+  // the key press generates the same fractal.
+  GLuint seed = rand();
+
+  if (key != GLFW_KEY_ESCAPE) {
+    recorder.recordKey(currentTime, key, seed);
+  }
+
+  pressKey(key, seed);
+}
+
+/**
+ * Perform the action of a key press.
+ */
+GLvoid pressKey(GLint key, GLuint seed)
+{
   switch(key) {
     case GLFW_KEY_ESCAPE:
       glfwSetWindowShouldClose(window, GL_TRUE);
       break;
     case GLFW_KEY_1:
+      if (exporter.isBusy) {
+        break;
+      }
+      srand(seed);
       initialiseEnvironment();
-      generateFractal();
+      loadFractal();
       updateFractalBuffer();
+      loadVolume();
       break;
     case GLFW_KEY_SPACE:
+      if (exporter.isBusy) {
+        break;
+      }
+      srand(seed);
+      generateFractal();
+      isFractalCached = false;
+      updateFractalBuffer();
+      break;
+    case GLFW_KEY_T:
+      if (exporter.isBusy) {
+        break;
+      }
+      env["fractalType"] = ((GLuint)env["fractalType"] + 1) %
+                           Generator::typeCount;
+      updateGenerator();
+      printf("fractal type: %s\n", Generator::getName(env["fractalType"]));
+      srand(seed);
       generateFractal();
+      isFractalCached = false;
       updateFractalBuffer();
       break;
+    case GLFW_KEY_LEFT:
+      moveEscapeTimeView(-0.125f, 0.0f, 1.0f);
+      break;
+    case GLFW_KEY_RIGHT:
+      moveEscapeTimeView(0.125f, 0.0f, 1.0f);
+      break;
+    case GLFW_KEY_UP:
+      moveEscapeTimeView(0.0f, 0.125f, 1.0f);
+      break;
+    case GLFW_KEY_DOWN:
+      moveEscapeTimeView(0.0f, -0.125f, 1.0f);
+      break;
+    case GLFW_KEY_EQUAL:
+      moveEscapeTimeView(0.0f, 0.0f, 2.0f);
+      break;
+    case GLFW_KEY_MINUS:
+      moveEscapeTimeView(0.0f, 0.0f, 0.5f);
+      break;
     case GLFW_KEY_F:
       areFacesEnabled = !areFacesEnabled;
       env["areFacesEnabled"] = !env["areFacesEnabled"];
@@ -84,10 +194,30 @@ GLvoid keyboard(GLFWwindow* window, GLint key, GLint scancode,
       isCullingEnabled = !isCullingEnabled;
       env["isCullingEnabled"] = isCullingEnabled;
       break;
+    case GLFW_KEY_V:
+      isChunkCullingEnabled = !isChunkCullingEnabled;
+      env["isChunkCullingEnabled"] = isChunkCullingEnabled;
+      break;
+    case GLFW_KEY_H:
+      isHorizonCullingEnabled = !isHorizonCullingEnabled;
+      env["isHorizonCullingEnabled"] = isHorizonCullingEnabled;
+      break;
     case GLFW_KEY_N:
       areNormalsEnabled = !areNormalsEnabled;
       env["areNormalsEnabled"] = areNormalsEnabled;
       break;
+    case GLFW_KEY_M:
+      toggleVolume(isVolumeEnabled);
+      break;
+    case GLFW_KEY_B:
+      toggleVolume(isVoxelEnabled);
+      break;
+    case GLFW_KEY_G:
+      toggleVolume(isChaosCloudEnabled);
+      break;
+    case GLFW_KEY_Y:
+      toggleVolume(isLSystemEnabled);
+      break;
     case GLFW_KEY_X:
       isWireframeEnabled = !isWireframeEnabled;
       env["isWireframeEnabled"] = isWireframeEnabled;
@@ -99,6 +229,12 @@ GLvoid keyboard(GLFWwindow* window, GLint key, GLint scancode,
     case GLFW_KEY_Z:
       shineValue = -shineValue;
       break;
+    case GLFW_KEY_E:
+      exportFractal();
+      break;
+    case GLFW_KEY_R:
+      toggleCapture();
+      break;
   }
 }
 
@@ -107,6 +243,10 @@ GLvoid keyboard(GLFWwindow* window, GLint key, GLint scancode,
  */
 GLvoid mouseMovement(GLFWwindow* window, GLdouble x, GLdouble y)
 {
+  if (recorder.mode == Recorder::REPLAYING) {
+    return;
+  }
+
   // Set the last x and y values for the mouse's initial movement capture.
   if (initialMouseMovement) {
     lastMouseX = x;
@@ -130,6 +270,10 @@ GLvoid mouseMovement(GLFWwindow* window, GLdouble x, GLdouble y)
  */
 GLvoid mouseScroll(GLFWwindow* window, GLdouble x, GLdouble y)
 {
+  if (recorder.mode == Recorder::REPLAYING) {
+    return;
+  }
+
   camera.setFov(camera.getFov() + y);
 }
 
@@ -143,6 +287,58 @@ GLvoid updateTime()
   deltaTime = currentTime - lastTime;
 }
 
+/**
+ * Advance the time variables by a fixed step, regardless of how long the last
+ * frame took, so that every run of the same input does the same work.
+ */
+GLvoid stepTime()
+{
+  lastTime = currentTime;
+  currentTime += REPLAY_TIMESTEP;
+  deltaTime = REPLAY_TIMESTEP;
+}
+
+/**
+ * Record the held keys and the camera's position and orientation for this
+ * frame, before the held keys move the camera.
+ */
+GLvoid recordInput()
+{
+  GLuint heldKeyMask = 0;
+
+  for (GLuint i = 0; i < heldKeyCount; i++) {
+    if (keyPressed[heldKeys[i]] != GLFW_RELEASE) {
+      heldKeyMask |= 1 << i;
+    }
+  }
+
+  recorder.recordState(currentTime, heldKeyMask, camera.position,
+                       camera.getYaw(), camera.getPitch(), camera.getFov());
+}
+
+/**
+ * Apply the recorded input which was given up to the current time.
+ */
+GLvoid replayInput()
+{
+  Recorder::Sample sample;
+
+  while (recorder.readSample(currentTime, sample)) {
+    for (GLuint i = 0; i < heldKeyCount; i++) {
+      keyPressed[heldKeys[i]] = (sample.heldKeys >> i) & 1;
+    }
+
+    camera.position = glm::vec3(sample.position[0], sample.position[1],
+                                sample.position[2]);
+    camera.updateOrientation(sample.yaw, sample.pitch);
+    camera.setFov(sample.fov);
+
+    if (sample.key != 0) {
+      pressKey(sample.key, sample.seed);
+    }
+  }
+}
+
 /**
  * Initialise the environment properties, camera and fractal.
  */
@@ -228,11 +424,27 @@ GLvoid initialiseFractal()
                     env["fractalYDeviance"],
                     glm::vec3(env["fractalColourRed"],
                               env["fractalColourGreen"],
-                              env["fractalColourBlue"]));
+                              env["fractalColourBlue"]),
+                    env["fractalChunkSize"],
+                    env["instanceLodCount"],
+                    env["isMortonStorageEnabled"] ? HeightPlane::MORTON :
+                                                    HeightPlane::LINEAR,
+                    env["isQuantisedStorageEnabled"]);
+  initialiseEscapeTimeView();
+  updateGenerator();
   areFacesEnabled = env["areFacesEnabled"];
   areNormalsEnabled = env["areNormalsEnabled"];
   isWireframeEnabled = env["isWireframeEnabled"];
+  isVolumeEnabled = env["isVolumeEnabled"];
+  isVoxelEnabled = env["isVoxelEnabled"] && !isVolumeEnabled;
+  isChaosCloudEnabled = env["isChaosCloudEnabled"] && !isVolumeEnabled &&
+                        !isVoxelEnabled;
+  isLSystemEnabled = env["isLSystemEnabled"] && !isVolumeEnabled &&
+                     !isVoxelEnabled && !isChaosCloudEnabled;
   isCullingEnabled = env["isCullingEnabled"];
+  isChunkCullingEnabled = env["isChunkCullingEnabled"];
+  isHorizonCullingEnabled = env["isHorizonCullingEnabled"];
+  instanceRingCount = env["instanceRingCount"];
   normalLength = env["normalLength"];
   wireframeColour.r = env["wireframeColourRed"];
   wireframeColour.g = env["wireframeColourGreen"];
@@ -245,9 +457,25 @@ GLvoid initialiseFractal()
  */
 GLvoid generateFractal()
 {
-  fractal.generate();
   GLuint isModified = false;
 
+  // Use the heights of a compressed terrain, when one is given. Its coarsest
+  // levels are used if it has more levels than the fractal.
+  if (terrainFilename != nullptr) {
+    HeightPlane plane = HeightCodec::decode(terrainFilename, fractal.depth);
+
+    if (plane.size != fractal.size) {
+      fprintf(stderr, "terrain is smaller than the fractal: %s\n",
+              terrainFilename);
+
+      exit(EXIT_FAILURE);
+    }
+
+    fractal.setHeights(plane);
+  } else {
+    fractal.generate();
+  }
+
   if (env["isSmoothingPositionsEnabled"]) {
     fractal.smoothPositions(fractal.createGaussianKernel(
                             env["smoothPositionsKernelSize"],
@@ -274,36 +502,176 @@ GLvoid generateFractal()
     fractal.updateVertexData();
   }
 
+  if (env["isSimplificationEnabled"]) {
+    fractal.simplify(env["simplificationTolerance"]);
+  }
+
   defaultNormalLength = 1.0f / (GLfloat)fractal.size;
 }
 
 /**
- * Draw the fractal.
+ * Load the fractal described by the profile from the terrain cache, or
+ * generate it and add it to the cache. Only seeded fractals are cached, since
+ * a fractal seeded by the time is different on every run.
  */
-GLvoid drawFractal()
+GLvoid loadFractal()
+{
+  GLuint seed = env["fractalSeed"];
+  GLuint isCacheable = env["isTerrainCacheEnabled"] && seed != 0 &&
+                       terrainFilename == nullptr &&
+                       locationFilename == nullptr && ifsFilename == nullptr;
+  GLuint64 key = TerrainCache::hashParameters(env);
+
+  if (seed != 0) {
+    srand(seed);
+  }
+
+  isFractalCached = isCacheable && terrainCache.load(key, fractal);
+
+  if (isFractalCached) {
+    defaultNormalLength = 1.0f / (GLfloat)fractal.size;
+    return;
+  }
+
+  generateFractal();
+
+  if (isCacheable) {
+    terrainCache.save(key, fractal);
+  }
+}
+
+/**
+ * Start capturing the frames to the `captures` directory, or stop if a
+ * capture is already running.
+ */
+GLvoid toggleCapture()
+{
+  if (capture.isCapturing) {
+    capture.stop();
+    return;
+  }
+
+  capture.start(frameWidth, frameHeight,
+                env["captureFormat"] ? FrameCapture::Y4M : FrameCapture::PPM,
+                captureFrameRate);
+}
+
+/**
+ * Initialise the view of the Mandelbrot and Julia sets from the location
+ * file, if there is one, or from the profile. The location file holds the
+ * real and imaginary parts of the centre and the width of the view, with as
+ * many digits as a deep zoom needs.
+ */
+GLvoid initialiseEscapeTimeView()
+{
+  if (locationFilename == nullptr) {
+    GLchar text[32];
+
+    snprintf(text, sizeof(text), "%.17g", env["escapeCentreReal"]);
+    escapeCentreReal = text;
+    snprintf(text, sizeof(text), "%.17g", env["escapeCentreImaginary"]);
+    escapeCentreImaginary = text;
+    escapeWidth = env["escapeWidth"];
+    return;
+  }
+
+  std::ifstream file(locationFilename);
+
+  if (!(file >> escapeCentreReal >> escapeCentreImaginary >> escapeWidth) ||
+      escapeWidth <= 0.0) {
+    fprintf(stderr, "failed to read location: %s\n", locationFilename);
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * Create the fractal's generator from the profile, with the current view if
+ * it generates a Mandelbrot or Julia set.
+ */
+GLvoid updateGenerator()
+{
+  fractal.generator = Generator::create(env);
+
+  std::shared_ptr<EscapeTimeGenerator> escapeTimeGenerator =
+    std::dynamic_pointer_cast<EscapeTimeGenerator>(fractal.generator);
+
+  if (escapeTimeGenerator) {
+    escapeTimeGenerator->setView(escapeCentreReal, escapeCentreImaginary,
+                                 escapeWidth);
+  }
+
+  std::shared_ptr<ChaosGameGenerator> chaosGameGenerator =
+    std::dynamic_pointer_cast<ChaosGameGenerator>(fractal.generator);
+
+  if (chaosGameGenerator && ifsFilename != nullptr) {
+    chaosGameGenerator->chaosGame.loadMaps(ifsFilename);
+  }
+}
+
+/**
+ * Move or zoom the view of a Mandelbrot or Julia set and regenerate it. The
+ * offsets are fractions of the width of the view.
+ *
+ * The centre is moved at the precision of the zoom, so it can go deeper than
+ * a double allows, and the new view is printed in the location file's format.
+ */
+GLvoid moveEscapeTimeView(GLfloat realOffset, GLfloat imaginaryOffset,
+                          GLfloat zoom)
+{
+  GLuint type = env["fractalType"];
+
+  if ((type != Generator::MANDELBROT && type != Generator::JULIA) ||
+      exporter.isBusy) {
+    return;
+  }
+
+  GLdouble precision = escapeWidth / fractal.size;
+  GLuint limbCount = BigFloat::getLimbCount(precision);
+  GLuint digitCount = std::max(-log10(precision), 0.0) + 17;
+  BigFloat real = BigFloat::fromString(escapeCentreReal, limbCount);
+  BigFloat imaginary = BigFloat::fromString(escapeCentreImaginary, limbCount);
+
+  real = real.add(BigFloat(limbCount, realOffset * escapeWidth));
+  imaginary = imaginary.add(BigFloat(limbCount,
+                                     imaginaryOffset * escapeWidth));
+  escapeCentreReal = real.toString(digitCount);
+  escapeCentreImaginary = imaginary.toString(digitCount);
+  escapeWidth /= zoom;
+
+  env["escapeCentreReal"] = atof(escapeCentreReal.c_str());
+  env["escapeCentreImaginary"] = atof(escapeCentreImaginary.c_str());
+  env["escapeWidth"] = escapeWidth;
+  printf("location: %s %s %.17g\n", escapeCentreReal.c_str(),
+         escapeCentreImaginary.c_str(), escapeWidth);
+
+  updateGenerator();
+  generateFractal();
+  isFractalCached = false;
+  updateFractalBuffer();
+}
+
+/**
+ * Use one of the fractal's shader programs and set its uniforms.
+ */
+GLvoid useFractalShader(GLuint shaderID, glm::mat4 model)
 {
   using namespace glm;
 
-  mat4 model;
-  GLuint normalLengthLoc, facesLoc, wireframeLoc, wireframeColourLoc;
+  GLuint facesLoc, wireframeColourLoc;
   GLuint matAmbientLoc, matDiffuseLoc, matSpecularLoc, matShineLoc;
   GLuint lightPositionLoc, lightAmbientLoc, lightDiffuseLoc, lightSpecularLoc;
-  GLuint modelLoc, viewLoc, projectionLoc, viewPosLoc;
+  GLuint modelLoc, viewLoc, projectionLoc, viewPosLoc, normalMatrixLoc;
+  GLuint positionScaleLoc, positionOffsetLoc;
+  mat3 normalMatrix = transpose(inverse(mat3(model)));
 
-  GLfloat scaleFactor = 100.0f;
-  GLfloat yOffset = fractal.getYPosition(fractal.size / 2, fractal.size / 2) +
-                                         (2.0f / scaleFactor);
-  model = scale(model, vec3(scaleFactor));
-  model = translate(model, vec3(-0.5f, -yOffset, -0.5f));
-
-  glUseProgram(fractalShader);
+  glUseProgram(shaderID);
 
   // Transform the shader program's vertices with the model, view and
   // projection matrices.
-  viewPosLoc  = glGetUniformLocation(fractalShader, "viewPosition");
-  modelLoc      = glGetUniformLocation(fractalShader, "model");
-  viewLoc       = glGetUniformLocation(fractalShader, "view");
-  projectionLoc = glGetUniformLocation(fractalShader, "projection");
+  viewPosLoc  = glGetUniformLocation(shaderID, "viewPosition");
+  modelLoc      = glGetUniformLocation(shaderID, "model");
+  viewLoc       = glGetUniformLocation(shaderID, "view");
+  projectionLoc = glGetUniformLocation(shaderID, "projection");
 
   glUniform4f(viewPosLoc, camera.position.x,
               camera.position.y, camera.position.z, 1.0f);
@@ -311,11 +679,22 @@ GLvoid drawFractal()
   glUniformMatrix4fv(viewLoc, 1, GL_FALSE, value_ptr(camera.view));
   glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, value_ptr(camera.projection));
 
+  // The normal matrix only changes with the model, so it is calculated here
+  // rather than for every vertex.
+  normalMatrixLoc = glGetUniformLocation(shaderID, "normalMatrix");
+  glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, value_ptr(normalMatrix));
+
+  // Quantised vertex positions are scaled back into the fractal's space.
+  positionScaleLoc  = glGetUniformLocation(shaderID, "positionScale");
+  positionOffsetLoc = glGetUniformLocation(shaderID, "positionOffset");
+  glUniform3fv(positionScaleLoc, 1, value_ptr(fractal.getPositionScale()));
+  glUniform3fv(positionOffsetLoc, 1, value_ptr(fractal.getPositionOffset()));
+
   // Material uniforms
-  matAmbientLoc  = glGetUniformLocation(fractalShader, "material.ambient");
-  matDiffuseLoc  = glGetUniformLocation(fractalShader, "material.diffuse");
-  matSpecularLoc = glGetUniformLocation(fractalShader, "material.specular");
-  matShineLoc    = glGetUniformLocation(fractalShader, "material.shininess"); 
+  matAmbientLoc  = glGetUniformLocation(shaderID, "material.ambient");
+  matDiffuseLoc  = glGetUniformLocation(shaderID, "material.diffuse");
+  matSpecularLoc = glGetUniformLocation(shaderID, "material.specular");
+  matShineLoc    = glGetUniformLocation(shaderID, "material.shininess"); 
 
   glUniform3f(matAmbientLoc,  0.0f, 0.0f, 0.0f);
   glUniform3f(matDiffuseLoc,  0.5f, 0.5f, 0.5f);
@@ -323,10 +702,10 @@ GLvoid drawFractal()
   glUniform1f(matShineLoc, shineValue);
 
   // Light uniforms
-  lightPositionLoc = glGetUniformLocation(fractalShader, "light.position");
-  lightAmbientLoc  = glGetUniformLocation(fractalShader, "light.ambient");
-  lightDiffuseLoc  = glGetUniformLocation(fractalShader, "light.diffuse");
-  lightSpecularLoc = glGetUniformLocation(fractalShader, "light.specular");
+  lightPositionLoc = glGetUniformLocation(shaderID, "light.position");
+  lightAmbientLoc  = glGetUniformLocation(shaderID, "light.ambient");
+  lightDiffuseLoc  = glGetUniformLocation(shaderID, "light.diffuse");
+  lightSpecularLoc = glGetUniformLocation(shaderID, "light.specular");
 
   glUniform4f(lightPositionLoc, lightPosition.x,
               lightPosition.y, lightPosition.z, isPointLightingEnabled);
@@ -334,22 +713,124 @@ GLvoid drawFractal()
   glUniform3f(lightDiffuseLoc,  1.0f, 1.0f, 1.0f);
   glUniform3f(lightSpecularLoc, 1.0f, 1.0f, 1.0f);
 
-  facesLoc = glGetUniformLocation(fractalShader, "areFacesEnabled");
-  wireframeLoc = glGetUniformLocation(fractalShader, "isWireframeEnabled");
-  wireframeColourLoc = glGetUniformLocation(fractalShader, "wireframeColour");
-  glUniform1f(facesLoc, areFacesEnabled);
-  glUniform1f(wireframeLoc, isWireframeEnabled);
+  facesLoc = glGetUniformLocation(shaderID, "areFacesEnabled");
+  wireframeColourLoc = glGetUniformLocation(shaderID, "wireframeColour");
+  glUniform1i(facesLoc, areFacesEnabled);
   glUniform4f(wireframeColourLoc, wireframeColour.r, wireframeColour.g,
                                   wireframeColour.b, wireframeColour.a);
-  
-  if (isCullingEnabled) {
-    glEnable(GL_CULL_FACE);
+}
+
+/**
+ * Draw the fractal and its copies as either triangles or wireframe lines
+ * with the shader program currently in use.
+ */
+GLvoid drawFractalMesh(GLuint shaderID, GLenum mode)
+{
+  GLuint isLines = (mode == GL_LINES);
+  GLuint instanceRingLoc = glGetUniformLocation(shaderID, "instanceRing");
+
+  glUniform1i(instanceRingLoc, 0);
+
+  // Only draw the chunks which may be visible from the camera.
+  if (isChunkCullingEnabled) {
+    glMultiDrawElements(mode, isLines ? culler.visibleLineCounts.data() :
+                                        culler.visibleCounts.data(),
+                        GL_UNSIGNED_INT,
+                        isLines ? culler.visibleLineOffsets.data() :
+                                  culler.visibleOffsets.data(),
+                        culler.visibleChunkCount);
+  } else {
+    glDrawElements(mode, isLines ? fractal.lodLineCounts[0] :
+                                   fractal.lodIndexCounts[0],
+                   GL_UNSIGNED_INT,
+                   (GLvoid*)((isLines ? fractal.lodLineOffsets[0] :
+                                        fractal.lodIndexOffsets[0]) *
+                             sizeof(GLuint)));
   }
+
+  // Surround the fractal with rings of copies, each ring using a lower level
+  // of detail than the last. Every ring is drawn with a single call. Copies
+  // of a fractal which doesn't wrap around would leave seams, so only the
+  // fractal itself is drawn.
+  GLuint ringCount = fractal.generator->isPeriodic ? instanceRingCount : 0;
+
+  for (GLuint ring = 1; ring <= ringCount; ring++) {
+    GLuint lod = std::min(ring, fractal.lodCount - 1);
+    GLuint offset = isLines ? fractal.lodLineOffsets[lod] :
+                              fractal.lodIndexOffsets[lod];
+
+    glUniform1i(instanceRingLoc, ring);
+    glDrawElementsInstanced(mode, isLines ? fractal.lodLineCounts[lod] :
+                                            fractal.lodIndexCounts[lod],
+                            GL_UNSIGNED_INT,
+                            (GLvoid*)(offset * sizeof(GLuint)), 8 * ring);
+  }
+}
+
+/**
+ * Draw the fractal. The faces and the wireframe are drawn by separate shader
+ * programs, so only the programs needed for the enabled features are used.
+ */
+GLvoid drawFractal()
+{
+  using namespace glm;
+
+  mat4 model;
+  GLuint modelLoc, viewLoc, projectionLoc, normalLengthLoc;
+  GLuint isWireframeDrawn = isWireframeEnabled || !areFacesEnabled;
+
+  if (isVolumeEnabled || isVoxelEnabled || isChaosCloudEnabled) {
+    drawVolume();
+
+    return;
+  }
+
+  if (isLSystemEnabled) {
+    drawCurve();
+
+    return;
+  }
+
+  GLfloat scaleFactor = 100.0f;
+  GLfloat yOffset = fractal.getYPosition(fractal.size / 2, fractal.size / 2) +
+                                         (2.0f / scaleFactor);
+  model = scale(model, vec3(scaleFactor));
+  model = translate(model, vec3(-0.5f, -yOffset, -0.5f));
+
+  if (isChunkCullingEnabled) {
+    culler.cullChunks(fractal, model, camera.view, camera.projection,
+                      camera.position, isHorizonCullingEnabled);
+  }
+
   glBindVertexArray(vao[Shader::FRACTAL]);
-  glDrawElements(GL_TRIANGLES, fractal.indexCount, GL_UNSIGNED_INT, 0);
-  if (isCullingEnabled) {
-    glDisable(GL_CULL_FACE);
+
+  if (areFacesEnabled) {
+    useFractalShader(fractalShader, model);
+
+    // Push the faces back slightly so the wireframe lines win the depth test.
+    if (isWireframeDrawn) {
+      glEnable(GL_POLYGON_OFFSET_FILL);
+      glPolygonOffset(1.0f, 1.0f);
+    }
+    if (isCullingEnabled) {
+      glEnable(GL_CULL_FACE);
+    }
+
+    drawFractalMesh(fractalShader, GL_TRIANGLES);
+
+    if (isCullingEnabled) {
+      glDisable(GL_CULL_FACE);
+    }
+    if (isWireframeDrawn) {
+      glDisable(GL_POLYGON_OFFSET_FILL);
+    }
   }
+
+  if (isWireframeDrawn) {
+    useFractalShader(wireframeShader, model);
+    drawFractalMesh(wireframeShader, GL_LINES);
+  }
+
   glBindVertexArray(0);
 
   if (areNormalsEnabled) {
@@ -364,15 +845,115 @@ GLvoid drawFractal()
     glUniformMatrix4fv(modelLoc, 1, GL_FALSE, value_ptr(model));
 
     normalLengthLoc = glGetUniformLocation(normalShader, "normalLength");
-    glUniform1f(normalLengthLoc, defaultNormalLength *
-                                 normalLength * scaleFactor);
-    
-    glBindVertexArray(vao[Shader::FRACTAL]);
-    glDrawElements(GL_TRIANGLES, fractal.indexCount, GL_UNSIGNED_INT, 0);
+    glUniform1f(normalLengthLoc, defaultNormalLength * normalLength);
+
+    glBindVertexArray(vao[Shader::NORMAL]);
+    glDrawArrays(GL_LINES, 0, fractal.normalVertexCount);
     glBindVertexArray(0);
   }
 }
 
+/**
+ * Get the model matrix of the 3D fractals, which centres them in front of
+ * where the camera starts.
+ */
+glm::mat4 getVolumeModel()
+{
+  glm::mat4 model;
+
+  model = glm::translate(model, glm::vec3(0.5f, 0.0f, -10.0f));
+  model = glm::scale(model, glm::vec3(5.0f / volumeRadius));
+  model = glm::translate(model, -volumeCentre);
+
+  return model;
+}
+
+/**
+ * Draw the mesh of the 3D fractal in place of the terrain. The mesh has no
+ * copies or chunks, so it is drawn whole. Point clouds are drawn whether or
+ * not the facets are enabled, since they have none.
+ */
+GLvoid drawVolume()
+{
+  using namespace glm;
+
+  mat4 model = getVolumeModel();
+  GLuint isWireframeDrawn = isWireframeEnabled || !areFacesEnabled;
+  GLuint shaders[2] = {fractalShader, wireframeShader};
+  GLuint isDrawn[2] = {areFacesEnabled || volumePointCount > 0,
+                       isWireframeDrawn && volumePointCount == 0};
+
+  glBindVertexArray(vao[Shader::VOLUME]);
+
+  for (GLuint i = 0; i < 2; i++) {
+    if (!isDrawn[i]) {
+      continue;
+    }
+
+    useFractalShader(shaders[i], model);
+
+    // The mesh's positions are stored as they are, unlike quantised terrain.
+    glUniform3f(glGetUniformLocation(shaders[i], "positionScale"),
+                1.0f, 1.0f, 1.0f);
+    glUniform3f(glGetUniformLocation(shaders[i], "positionOffset"),
+                0.0f, 0.0f, 0.0f);
+    glUniform1i(glGetUniformLocation(shaders[i], "instanceRing"), 0);
+
+    if (volumePointCount > 0) {
+      glPointSize(2.0f);
+      glDrawArrays(GL_POINTS, 0, volumePointCount);
+    } else if (i == 0) {
+      // Push the faces back slightly so the wireframe lines win the depth
+      // test.
+      if (isWireframeDrawn) {
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(1.0f, 1.0f);
+      }
+      if (isCullingEnabled) {
+        glEnable(GL_CULL_FACE);
+      }
+
+      glDrawElements(GL_TRIANGLES, volumeTriangleIndexCount, GL_UNSIGNED_INT,
+                     (GLvoid*)0);
+
+      glDisable(GL_CULL_FACE);
+      glDisable(GL_POLYGON_OFFSET_FILL);
+    } else {
+      glDrawElements(GL_LINES, volumeLineIndexCount, GL_UNSIGNED_INT,
+                     (GLvoid*)(volumeTriangleIndexCount * sizeof(GLuint)));
+    }
+  }
+
+  glBindVertexArray(0);
+}
+
+/**
+ * Draw the L-system curve in place of the terrain, as one line strip for each
+ * unbroken run of its steps. The curve is drawn whether or not the facets are
+ * enabled, since it has none.
+ */
+GLvoid drawCurve()
+{
+  useFractalShader(fractalShader, getVolumeModel());
+
+  // The curve's positions are stored as they are, and it has the same normal
+  // and colour everywhere, so they are given as constant attributes.
+  glUniform3f(glGetUniformLocation(fractalShader, "positionScale"),
+              1.0f, 1.0f, 1.0f);
+  glUniform3f(glGetUniformLocation(fractalShader, "positionOffset"),
+              0.0f, 0.0f, 0.0f);
+  glUniform1i(glGetUniformLocation(fractalShader, "instanceRing"), 0);
+  glVertexAttrib3f(glGetAttribLocation(fractalShader, "normal"),
+                   0.0f, 1.0f, 0.0f);
+  glVertexAttrib3f(glGetAttribLocation(fractalShader, "colour"),
+                   curveColour.r, curveColour.g, curveColour.b);
+
+  glBindVertexArray(vao[Shader::CURVE]);
+  glMultiDrawArrays(GL_LINE_STRIP, curveStripFirsts.data(),
+                    curveStripCounts.data(), curveStripCounts.size());
+  glBindVertexArray(0);
+}
+
 /**
  * Run the close event loop. This is where elements are drawn and window
  * events are polled.
@@ -383,15 +964,31 @@ GLvoid runMainLoop()
 
   while(!glfwWindowShouldClose(window))
   {
-    // Update the time variables.
-    updateTime();
+    // Update the time variables, and the input when replaying.
+    if (recorder.mode == Recorder::REPLAYING) {
+      stepTime();
+      replayInput();
+
+      if (recorder.isFinished()) {
+        glfwSetWindowShouldClose(window, GL_TRUE);
+      }
+    } else {
+      updateTime();
+    }
 
     // Listen for events from the window.
     glfwPollEvents();
 
-    // Update the camera attributes.
+    // Update the camera attributes, and the voxel fractal's levels of
+    // detail as the camera moves. The input is recorded first, so a replay
+    // starts each frame from the same position.
+    recordInput();
     updateCamera();
 
+    if (isVoxelEnabled) {
+      updateVoxelBuffer(false);
+    }
+
     // Clear the screen.
     glClearColor(backgroundColour.r, backgroundColour.g,
                  backgroundColour.b, 1.0f);
@@ -400,10 +997,138 @@ GLvoid runMainLoop()
     // Draw functions.
     drawFractal();
 
+    // Read the frame back before it is swapped away, if capturing.
+    capture.captureFrame();
+
     glfwSwapBuffers(window);
   }
 }
 
+/**
+ * Render a fixed number of frames without a window and print their timings.
+ * Time advances at a fixed rate, and the camera turns a full circle over the
+ * run so that the frames see every side of the fractal, unless a recording is
+ * being replayed, in which case the run lasts as long as the recording. Each
+ * frame is finished before it is timed, so the timings include all of its
+ * rendering.
+ */
+GLvoid runHeadlessLoop()
+{
+  using namespace std::chrono;
+
+  std::vector<GLdouble> frameTimes;
+  GLdouble totalTime = 0.0;
+  GLchar filename[64];
+
+  if (isHeadlessCaptureEnabled) {
+    mkdir("frames", 0755);
+  }
+
+  for (GLuint frame = 0; recorder.mode == Recorder::REPLAYING ?
+                         !recorder.isFinished() : frame < headlessFrameCount;
+       frame++) {
+    steady_clock::time_point start = steady_clock::now();
+
+    stepTime();
+
+    if (recorder.mode == Recorder::REPLAYING) {
+      replayInput();
+    } else {
+      camera.updateOrientation(camera.getYaw() + 360.0f / headlessFrameCount,
+                               camera.getPitch());
+    }
+
+    updateCamera();
+
+    glClearColor(backgroundColour.r, backgroundColour.g,
+                 backgroundColour.b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    drawFractal();
+    glFinish();
+
+    steady_clock::time_point end = steady_clock::now();
+    frameTimes.push_back(duration<GLdouble, std::milli>(end - start).count());
+    totalTime += frameTimes.back();
+
+    capture.captureFrame();
+
+    if (isHeadlessCaptureEnabled) {
+      snprintf(filename, sizeof(filename), "frames/frame-%04d.ppm", frame);
+      headless.saveFrame(filename);
+    }
+  }
+
+  printf("renderer:  %s\n", glGetString(GL_RENDERER));
+  printFrameTimings(frameTimes, totalTime, frameWidth, frameHeight);
+}
+
+/**
+ * Print the number of frames, of the given size, and the average, median,
+ * 95th percentile and extremes of their times (in milliseconds). The times are
+ * sorted in place.
+ */
+GLvoid printFrameTimings(std::vector<GLdouble>& frameTimes,
+                         GLdouble totalTime, GLuint width, GLuint height)
+{
+  std::sort(frameTimes.begin(), frameTimes.end());
+
+  GLuint count = frameTimes.size();
+
+  printf("frames:    %d at %dx%d\n", count, width, height);
+  printf("average:   %.2f ms (%.1f fps)\n", totalTime / count,
+         1000.0 * count / totalTime);
+  printf("median:    %.2f ms\n", frameTimes[count / 2]);
+  printf("95th:      %.2f ms\n", frameTimes[count * 95 / 100]);
+  printf("min/max:   %.2f / %.2f ms\n", frameTimes[0], frameTimes[count - 1]);
+}
+
+/**
+ * Render frames of the profile's 3D fractal with the CPU ray marcher, save
+ * them to the `frames` directory and print their timings. The camera circles
+ * the fractal over the run, far enough back to fit its bounding sphere in
+ * view. No graphics context is needed.
+ */
+GLvoid renderRayMarchedFrames()
+{
+  using namespace std::chrono;
+
+  RayMarcher rayMarcher(env);
+  std::vector<GLdouble> frameTimes;
+  GLdouble totalTime = 0.0;
+  GLchar filename[64];
+
+  initialiseCamera();
+  mkdir("frames", 0755);
+
+  GLfloat distance = rayMarcher.estimator.boundingRadius /
+                     sinf(glm::radians(camera.getFov()) / 2.0f);
+
+  for (GLuint frame = 0; frame < rayMarchFrameCount; frame++) {
+    GLfloat angle = 2.0f * M_PI * frame / rayMarchFrameCount;
+
+    camera.position = distance * glm::vec3(sinf(angle), 0.4f, cosf(angle));
+    camera.front = glm::normalize(-camera.position);
+
+    steady_clock::time_point start = steady_clock::now();
+    rayMarcher.render(camera);
+    steady_clock::time_point end = steady_clock::now();
+
+    frameTimes.push_back(duration<GLdouble, std::milli>(end - start).count());
+    totalTime += frameTimes.back();
+
+    snprintf(filename, sizeof(filename), "frames/raymarch-%04d.ppm", frame);
+    rayMarcher.saveImage(filename);
+  }
+
+  printf("fractal:   %s\n",
+         DistanceEstimator::getName(rayMarcher.estimator.type));
+  printf("threads:   %d\n", getThreadCount());
+  printFrameTimings(frameTimes, totalTime, rayMarcher.width,
+                    rayMarcher.height);
+  printf("rays:      %.2f M/s\n", (GLdouble)rayMarcher.width *
+         rayMarcher.height * frameTimes.size() / (totalTime * 1000.0));
+}
+
 /**
  * Setup the buffer objects and shaders for each object type.
  */
@@ -415,33 +1140,320 @@ GLvoid initialiseBuffersAndShaders()
     glGenBuffers(1, &ebo[i]);
   }
 
-  // Load the vertex and fragment shaders into a shader program.
-  Shader shader("src/shaders/fractal.vert", "src/shaders/fractal.frag",
-                "src/shaders/fractal.geom");
+  // Load the vertex and fragment shaders into shader programs. The wireframe
+  // is a variant of the fractal's shaders and is drawn as lines.
+  Shader shader("src/shaders/fractal.vert", "src/shaders/fractal.frag");
   fractalShader = shader.programID;
-  shader = Shader("src/shaders/fractal.vert", "src/shaders/normal.frag",
-                  "src/shaders/normal.geom");
+  shader = Shader("src/shaders/fractal.vert", "src/shaders/fractal.frag", "",
+                  {"WIREFRAME"});
+  wireframeShader = shader.programID;
+  shader = Shader("src/shaders/normal.vert", "src/shaders/normal.frag");
   normalShader = shader.programID;
 }
 
+/**
+ * Upload data to the bound buffer, reusing the buffer's storage when it is
+ * already the right size, as it is when the fractal is regenerated.
+ */
+GLvoid uploadBuffer(GLenum target, GLsizeiptr& bufferSize, GLsizeiptr size,
+                    const GLvoid* data)
+{
+  if (size == bufferSize) {
+    glBufferSubData(target, 0, size, data);
+  } else {
+    glBufferData(target, size, data, GL_STATIC_DRAW);
+    bufferSize = size;
+  }
+}
+
 /**
  * Generate the fractal and load the vertex/index data into the buffers.
  */
 GLvoid updateFractalBuffer()
 {
-  GLfloat vertexBufferSize = fractal.vertexCount * fractal.DIMENSIONS *
-                             fractal.attributeCount * sizeof(GLfloat);
-  GLfloat indexBufferSize = fractal.indexCount * sizeof(GLuint);
+  GLsizeiptr vertexBufferSize = (GLsizeiptr)fractal.vertexCount *
+                                fractal.vertexStride;
+  GLsizeiptr indexBufferSize = (GLsizeiptr)fractal.totalIndexCount *
+                               sizeof(GLuint);
+  const GLvoid* vertexData = fractal.isQuantised ?
+                             (const GLvoid*)fractal.packedVertexData :
+                             (const GLvoid*)fractal.vertexData;
+  const GLvoid* indexData = fractal.indexData;
+  const GLvoid* normalVertexData = fractal.normalVertexData;
+
+  // A fractal loaded from the cache is uploaded straight from its mapping.
+  if (terrainCache.isMapped()) {
+    vertexData = terrainCache.vertexData;
+    indexData = terrainCache.indexData;
+    normalVertexData = terrainCache.normalVertexData;
+  }
 
   glBindVertexArray(vao[Shader::FRACTAL]);
   glBindBuffer(GL_ARRAY_BUFFER, vbo[Shader::FRACTAL]);
-  glBufferData(GL_ARRAY_BUFFER, vertexBufferSize,
-               fractal.vertexData, GL_STATIC_DRAW);
+  uploadBuffer(GL_ARRAY_BUFFER, vboSizes[Shader::FRACTAL], vertexBufferSize,
+               vertexData);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo[Shader::FRACTAL]);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize,
-               fractal.indexData, GL_STATIC_DRAW);
+  uploadBuffer(GL_ELEMENT_ARRAY_BUFFER, eboSizes[Shader::FRACTAL],
+               indexBufferSize, indexData);
+
+  addVertexAttributes(fractalShader, fractal.isQuantised);
+
+  // The visualised normals are drawn from their own buffer of lines.
+  GLsizeiptr normalBufferSize = (GLsizeiptr)fractal.normalVertexCount *
+                                fractal.DIMENSIONS * fractal.attributeCount *
+                                sizeof(GLfloat);
+
+  glBindVertexArray(vao[Shader::NORMAL]);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo[Shader::NORMAL]);
+  uploadBuffer(GL_ARRAY_BUFFER, vboSizes[Shader::NORMAL], normalBufferSize,
+               normalVertexData);
+
+  addVertexAttributes(normalShader, false);
+
+  terrainCache.unmap();
+
+  // Unbind the vao, vbo and ebo.
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Mesh the profile's 3D fractal and load it into its own buffers, in the same
+ * layout as the terrain so the fractal's shaders draw it unchanged.
+ */
+GLvoid updateVolumeBuffer()
+{
+  using namespace std::chrono;
+
+  VolumeMesher mesher(env);
+
+  steady_clock::time_point start = steady_clock::now();
+  mesher.generate();
+  steady_clock::time_point end = steady_clock::now();
+
+  printf("volume mesh: %s, %d triangles from %d of %d blocks in %.2f ms\n",
+         DistanceEstimator::getName(mesher.estimator.type),
+         mesher.triangleIndexCount / 3, mesher.meshedBlockCount,
+         mesher.blockCount,
+         duration<GLdouble, std::milli>(end - start).count());
+
+  volumeRadius = mesher.estimator.boundingRadius;
+  uploadVolumeBuffer(mesher.vertexData, mesher.indexData,
+                     mesher.triangleIndexCount, mesher.lineIndexCount);
+}
+
+/**
+ * Mesh the profile's voxel fractal for the camera's position and load it into
+ * the 3D fractals' buffers. Unless forced, the fractal is only meshed again
+ * once the camera has moved far enough for the levels of detail to change,
+ * and the chunks it has already meshed are reused.
+ */
+GLvoid updateVoxelBuffer(GLuint isForced)
+{
+  using namespace std::chrono;
+
+  glm::vec3 viewPosition = glm::vec3(glm::inverse(getVolumeModel()) *
+                                     glm::vec4(camera.position, 1.0f));
+  GLfloat distance = glm::length(viewPosition - voxelViewPosition);
+
+  if (!isForced && distance < VOXEL_REMESH_DISTANCE *
+                              glm::length(voxelViewPosition)) {
+    return;
+  }
+
+  if (isForced) {
+    voxelFractal.reset(new VoxelFractal(env));
+  }
+
+  voxelViewPosition = viewPosition;
+
+  steady_clock::time_point start = steady_clock::now();
+  voxelFractal->generate(viewPosition);
+  steady_clock::time_point end = steady_clock::now();
+
+  printf("voxel mesh: %s level %d, %d quads in %d chunks in %.2f ms\n",
+         VoxelFractal::getName(voxelFractal->type), voxelFractal->levelCount,
+         voxelFractal->quadCount, voxelFractal->chunkCount,
+         duration<GLdouble, std::milli>(end - start).count());
+
+  volumeRadius = 1.0f;
+  uploadVolumeBuffer(voxelFractal->vertexData, voxelFractal->indexData,
+                     voxelFractal->triangleIndexCount,
+                     voxelFractal->lineIndexCount);
+}
+
+/**
+ * Run the chaos game of the profile's iterated function system, or of the
+ * maps file, into a cube of cells and load the cells it lands in into the 3D
+ * fractals' buffers as a cloud of points.
+ */
+GLvoid updateChaosCloudBuffer()
+{
+  using namespace std::chrono;
+
+  ChaosGame chaosGame(env);
+  std::vector<GLfloat> vertexData;
+
+  if (ifsFilename != nullptr) {
+    chaosGame.loadMaps(ifsFilename);
+  }
+
+  steady_clock::time_point start = steady_clock::now();
+  chaosGame.createPointCloud(((GLuint64)rand() << 32) ^ rand(),
+                             std::max(env["chaosResolution"], 1.0f),
+                             glm::vec3(env["fractalColourRed"],
+                                       env["fractalColourGreen"],
+                                       env["fractalColourBlue"]),
+                             vertexData);
+  steady_clock::time_point end = steady_clock::now();
+
+  printf("chaos game: %llu iterations, %d points in %.2f ms\n",
+         (unsigned long long)chaosGame.iterationCount,
+         (GLuint)(vertexData.size() / VOLUME_VERTEX_SIZE),
+         duration<GLdouble, std::milli>(end - start).count());
+
+  volumeRadius = 1.0f;
+  uploadVolumeBuffer(vertexData, std::vector<GLuint>(), 0, 0);
+}
+
+/**
+ * Generate the profile's L-system curve straight into its own vertex buffer.
+ * The buffer is sized for the most vertices the curve can have, and the curve
+ * is written into it through a mapping of one batch of vertices at a time, so
+ * the whole curve is never held in memory.
+ */
+GLvoid updateCurveBuffer()
+{
+  using namespace std::chrono;
+
+  LSystem lSystem(env);
+  GLsizeiptr vertexCapacity = lSystem.countVertices(lSystem.iterationCount);
+  GLsizeiptr vertexSize = L_SYSTEM_VERTEX_SIZE * sizeof(GLfloat);
+  GLsizeiptr vertexCount = 0;
+
+  if (lSystem.iterationCount < (GLuint)env["lSystemIterationCount"]) {
+    printf("L-system: %d iterations fit within %.0f vertices\n",
+           lSystem.iterationCount, lSystem.vertexLimit);
+  }
+
+  glBindVertexArray(vao[Shader::CURVE]);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo[Shader::CURVE]);
+  glBufferData(GL_ARRAY_BUFFER, vertexCapacity * vertexSize, nullptr,
+               GL_STATIC_DRAW);
+  vboSizes[Shader::CURVE] = vertexCapacity * vertexSize;
+
+  steady_clock::time_point start = steady_clock::now();
+
+  // Any symbols left once the buffer is full can't add more vertices.
+  while (!lSystem.isFinished() && vertexCount < vertexCapacity) {
+    GLsizeiptr batchSize = std::min((GLsizeiptr)CURVE_BATCH_SIZE,
+                                    vertexCapacity - vertexCount);
+    GLfloat* vertices = (GLfloat*)glMapBufferRange(GL_ARRAY_BUFFER,
+                                                   vertexCount * vertexSize,
+                                                   batchSize * vertexSize,
+                                                   GL_MAP_WRITE_BIT |
+                                                   GL_MAP_INVALIDATE_RANGE_BIT);
+
+    if (vertices == nullptr) {
+      fprintf(stderr, "failed to map the curve's vertex buffer\n");
+      exit(EXIT_FAILURE);
+    }
+
+    vertexCount += lSystem.generate(vertices, batchSize);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+  }
+
+  steady_clock::time_point end = steady_clock::now();
+
+  printf("L-system: %s iteration %d, %ld vertices in %.2f ms\n",
+         LSystem::getName(lSystem.type), lSystem.iterationCount,
+         (long)vertexCount,
+         duration<GLdouble, std::milli>(end - start).count());
+
+  // The curve only stores its positions.
+  GLint attribute = glGetAttribLocation(fractalShader, "position");
+  glVertexAttribPointer(attribute, 3, GL_FLOAT, GL_FALSE, vertexSize,
+                        (GLvoid*)0);
+  glEnableVertexAttribArray(attribute);
+
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // Centre the curve and scale its longest side to the size of the other 3D
+  // fractals.
+  glm::vec3 size = lSystem.maximum - lSystem.minimum;
+
+  curveStripFirsts = lSystem.stripFirsts;
+  curveStripCounts = lSystem.stripCounts;
+  curveColour = glm::vec3(env["fractalColourRed"], env["fractalColourGreen"],
+                          env["fractalColourBlue"]);
+  volumeCentre = 0.5f * (lSystem.minimum + lSystem.maximum);
+  volumeRadius = 0.5f * std::max(std::max(size.x, size.y), size.z);
+}
+
+/**
+ * Turn one of the 3D fractals on or off in place of the terrain. They are
+ * drawn in the same place, so turning one on turns the others off.
+ */
+GLvoid toggleVolume(GLuint& isEnabled)
+{
+  GLuint isNowEnabled = !isEnabled;
+
+  isVolumeEnabled = false;
+  isVoxelEnabled = false;
+  isChaosCloudEnabled = false;
+  isLSystemEnabled = false;
+  isEnabled = isNowEnabled;
+  env["isVolumeEnabled"] = isVolumeEnabled;
+  env["isVoxelEnabled"] = isVoxelEnabled;
+  env["isChaosCloudEnabled"] = isChaosCloudEnabled;
+  env["isLSystemEnabled"] = isLSystemEnabled;
+
+  loadVolume();
+}
+
+/**
+ * Load whichever 3D fractal is turned on into its buffers. Only the curve is
+ * moved to be centred, as the others are generated around the origin.
+ */
+GLvoid loadVolume()
+{
+  volumeCentre = glm::vec3(0.0f);
+
+  if (isVolumeEnabled) {
+    updateVolumeBuffer();
+  } else if (isVoxelEnabled) {
+    updateVoxelBuffer(true);
+  } else if (isChaosCloudEnabled) {
+    updateChaosCloudBuffer();
+  } else if (isLSystemEnabled) {
+    updateCurveBuffer();
+  }
+}
+
+/**
+ * Load a 3D fractal's mesh, whose triangles are followed by its lines, into
+ * the 3D fractals' buffers. Vertices without any indices are drawn as points.
+ */
+GLvoid uploadVolumeBuffer(const std::vector<GLfloat>& vertexData,
+                          const std::vector<GLuint>& indexData,
+                          GLuint triangleIndexCount, GLuint lineIndexCount)
+{
+  volumeTriangleIndexCount = triangleIndexCount;
+  volumeLineIndexCount = lineIndexCount;
+  volumePointCount = indexData.empty() ?
+                     vertexData.size() / VOLUME_VERTEX_SIZE : 0;
 
-  addVertexAttributes(fractalShader);
+  glBindVertexArray(vao[Shader::VOLUME]);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo[Shader::VOLUME]);
+  uploadBuffer(GL_ARRAY_BUFFER, vboSizes[Shader::VOLUME],
+               vertexData.size() * sizeof(GLfloat), vertexData.data());
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo[Shader::VOLUME]);
+  uploadBuffer(GL_ELEMENT_ARRAY_BUFFER, eboSizes[Shader::VOLUME],
+               indexData.size() * sizeof(GLuint), indexData.data());
+
+  addVertexAttributes(fractalShader, false);
 
   // Unbind the vao, vbo and ebo.
   glBindVertexArray(0);
@@ -450,9 +1462,10 @@ GLvoid updateFractalBuffer()
 }
 
 /**
- * Add vertex layout attributes to the given shader.
+ * Add vertex layout attributes to the given shader. Packed vertices store the
+ * same attributes as integers, as described by Fractal::PackedVertex.
  */
-GLvoid addVertexAttributes(GLuint shaderID)
+GLvoid addVertexAttributes(GLuint shaderID, GLuint isPacked)
 {
   // Vertex attributes. These are consistent accross all shaders used.
   const GLint attributeCount = 3;
@@ -462,6 +1475,29 @@ GLvoid addVertexAttributes(GLuint shaderID)
 
   GLint i, stride = 0, offset = 0;
 
+  if (isPacked) {
+    const GLint packedSizes[attributeCount] = {3, 4, 4};
+    const GLenum packedTypes[attributeCount] =
+                 {GL_UNSIGNED_SHORT, GL_INT_2_10_10_10_REV, GL_UNSIGNED_BYTE};
+    const GLboolean packedNormalised[attributeCount] =
+                    {GL_FALSE, GL_TRUE, GL_TRUE};
+    const size_t packedOffsets[attributeCount] =
+                 {offsetof(Fractal::PackedVertex, position),
+                  offsetof(Fractal::PackedVertex, normal),
+                  offsetof(Fractal::PackedVertex, colour)};
+
+    for (i = 0; i < attributeCount; i++) {
+      GLint attribute = glGetAttribLocation(shaderID,
+                                            attributeNames[i]);
+      glVertexAttribPointer(attribute, packedSizes[i], packedTypes[i],
+                            packedNormalised[i], sizeof(Fractal::PackedVertex),
+                            (GLvoid*)packedOffsets[i]);
+      glEnableVertexAttribArray(attribute);
+    }
+
+    return;
+  }
+
   for (i = 0; i < attributeCount; i++) {
     stride += attributeSizes[i];
   }
@@ -478,9 +1514,49 @@ GLvoid addVertexAttributes(GLuint shaderID)
 }
 
 /**
- * Initialise the graphics libraries and window.
+ * Initialise the graphics libraries and the window, or the framebuffer which
+ * replaces it when rendering headlessly.
  */
 GLvoid initialiseGraphics(GLint argc, GLchar* argv[])
+{
+  if (headlessFrameCount > 0) {
+    headless.create(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+  } else {
+    initialiseWindow();
+  }
+
+  // Initialise GLEW.
+  glewExperimental = GL_TRUE;
+  glewInit();
+
+  // Define the viewport dimensions.
+  if (headlessFrameCount > 0) {
+    headless.createFramebuffer();
+    frameWidth = headless.width;
+    frameHeight = headless.height;
+  } else {
+    glfwGetFramebufferSize(window, &frameWidth, &frameHeight);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+  }
+
+  aspectRatio = (GLfloat)frameWidth / (GLfloat)frameHeight;
+  glViewport(0, 0, frameWidth, frameHeight);
+
+  // Set extra options.
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  // Set the clear colour value.
+  backgroundColour.r = env["backgroundColourRed"];
+  backgroundColour.g = env["backgroundColourGreen"];
+  backgroundColour.b = env["backgroundColourBlue"];
+}
+
+/**
+ * Initialise GLFW and create the window.
+ */
+GLvoid initialiseWindow()
 {
   GLint majorVersion, minorVersion, revision;
   GLuint isFullscreen = env["isFullScreenEnabled"];
@@ -506,6 +1582,12 @@ GLvoid initialiseGraphics(GLint argc, GLchar* argv[])
     width = videoMode->width;
     height = videoMode->height;
   }
+
+  // Captures play back at the display rate, unless a replay sets its own.
+  if (replayFilename == nullptr) {
+    captureFrameRate = glfwGetVideoMode(glfwGetPrimaryMonitor())->refreshRate;
+  }
+
   window = glfwCreateWindow(width, height, "Fractals", monitor, nullptr);
 
   glfwMakeContextCurrent(window);
@@ -514,26 +1596,6 @@ GLvoid initialiseGraphics(GLint argc, GLchar* argv[])
   glfwSetKeyCallback(window, keyboard);
   glfwSetCursorPosCallback(window, mouseMovement);
   glfwSetScrollCallback(window, mouseScroll);
-
-  // Initialise GLEW.
-  glewExperimental = GL_TRUE;
-  glewInit();
-
-  // Define the viewport dimensions.
-  glfwGetFramebufferSize(window, &frameWidth, &frameHeight);
-  aspectRatio = (GLfloat)frameWidth / (GLfloat)frameHeight;
-  glViewport(0, 0, frameWidth, frameHeight);
-
-  // Set extra options.
-  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  // Set the clear colour value.
-  backgroundColour.r = env["backgroundColourRed"];
-  backgroundColour.g = env["backgroundColourGreen"];
-  backgroundColour.b = env["backgroundColourBlue"];
 }
 
 /**
@@ -543,6 +1605,8 @@ GLvoid initialiseGraphics(GLint argc, GLchar* argv[])
 GLvoid terminateGraphics()
 {
   glDeleteProgram(fractalShader);
+  glDeleteProgram(wireframeShader);
+  glDeleteProgram(normalShader);
 
   for (GLuint i = Shader::FRACTAL; i != Shader::NONE; i++) {
     glDeleteVertexArrays(1, &vao[i]);
@@ -550,7 +1614,234 @@ GLvoid terminateGraphics()
     glDeleteBuffers(1, &ebo[i]);
   }
 
-  glfwTerminate();
+  if (headlessFrameCount > 0) {
+    headless.destroy();
+  } else {
+    glfwTerminate();
+  }
+}
+
+/**
+ * Time the chaos game of the profile's iterated function system, or of the
+ * maps file, and save its density to the `frames` directory as a PGM image.
+ */
+GLvoid benchmarkChaosGame()
+{
+  using namespace std::chrono;
+
+  ChaosGame chaosGame(env);
+  GLuint sizes[3] = {CHAOS_IMAGE_SIZE, CHAOS_IMAGE_SIZE, 1};
+  std::vector<GLuint64> histogram;
+
+  if (ifsFilename != nullptr) {
+    chaosGame.loadMaps(ifsFilename);
+  }
+
+  chaosGame.iterationCount = std::min(chaosGameIterationCount,
+                                      CHAOS_ITERATION_LIMIT);
+
+  steady_clock::time_point start = steady_clock::now();
+  chaosGame.accumulate(((GLuint64)rand() << 32) ^ rand(), sizes, histogram);
+  steady_clock::time_point end = steady_clock::now();
+
+  GLdouble time = duration<GLdouble, std::milli>(end - start).count();
+
+  printf("maps:       %s\n", ifsFilename != nullptr ? ifsFilename :
+                              ChaosGame::getName(chaosGame.type));
+  printf("threads:    %d\n", getThreadCount());
+  printf("iterations: %llu\n", (unsigned long long)chaosGame.iterationCount);
+  printf("time:       %.2f ms (%.2f M iterations/s)\n", time,
+         chaosGame.iterationCount / (time * 1000.0));
+
+  // Save the log of the density, with the Y axis pointing up.
+  GLfloat logMaximum = log1pf(*std::max_element(histogram.begin(),
+                                                histogram.end()));
+  std::vector<GLubyte> pixels(histogram.size());
+
+  for (GLuint y = 0; y < CHAOS_IMAGE_SIZE; y++) {
+    for (GLuint x = 0; x < CHAOS_IMAGE_SIZE; x++) {
+      GLuint64 count = histogram[(CHAOS_IMAGE_SIZE - 1 - y) *
+                                 CHAOS_IMAGE_SIZE + x];
+
+      pixels[y * CHAOS_IMAGE_SIZE + x] = 255.0f * log1pf(count) / logMaximum;
+    }
+  }
+
+  mkdir("frames", 0755);
+
+  std::ofstream file("frames/chaosgame.pgm", std::ios::binary);
+
+  file << "P5\n" << CHAOS_IMAGE_SIZE << " " << CHAOS_IMAGE_SIZE << "\n255\n";
+  file.write((const GLchar*)pixels.data(), pixels.size());
+}
+
+/**
+ * Time the generation of height planes stored in each layout, including the
+ * conversion of the heights back into rows, and print the results.
+ */
+GLvoid benchmarkHeightStorage()
+{
+  using namespace std::chrono;
+
+  const GLuint layoutCount = 2;
+  const HeightPlane::Layout layouts[layoutCount] = {HeightPlane::LINEAR,
+                                                    HeightPlane::MORTON};
+  const GLchar* layoutNames[layoutCount] = {"row-major", "Morton"};
+
+  printf("%-6s %-10s %10s\n", "depth", "layout", "time (ms)");
+
+  for (GLuint depth = 11; depth <= 14; depth++) {
+    for (GLuint i = 0; i < layoutCount; i++) {
+      HeightPlane plane(2 << (depth - 1), layouts[i]);
+
+      // Use the same random numbers for each layout.
+      srand(depth);
+
+      steady_clock::time_point start = steady_clock::now();
+      DiamondSquareGenerator(env["fractalYRange"],
+                             env["fractalYDeviance"]).generate(plane);
+      plane.convertToLayout(HeightPlane::LINEAR);
+      steady_clock::time_point end = steady_clock::now();
+
+      printf("%-6d %-10s %10.1f\n", depth, layoutNames[i],
+             duration<GLdouble, std::milli>(end - start).count());
+    }
+  }
+}
+
+/**
+ * Export the fractal in each format enabled by the profile, in the background.
+ * The fractal can't be regenerated until the export is finished.
+ */
+GLvoid exportFractal()
+{
+  std::vector<Exporter::Format> formats;
+
+  if (exporter.isBusy) {
+    printf("the previous export is still being written\n");
+    return;
+  }
+
+  // A fractal loaded from the cache only has its vertex buffers and heights,
+  // so generate it again from the same seed to fill in its normals and
+  // colours.
+  if (isFractalCached) {
+    srand(env["fractalSeed"]);
+    generateFractal();
+    isFractalCached = false;
+  }
+
+  if (env["isRawExportEnabled"]) {
+    formats.push_back(Exporter::RAW16);
+  }
+  if (env["isPgmExportEnabled"]) {
+    formats.push_back(Exporter::PGM);
+  }
+  if (env["isPlyExportEnabled"]) {
+    formats.push_back(Exporter::PLY);
+  }
+  if (env["isObjExportEnabled"]) {
+    formats.push_back(Exporter::OBJ);
+  }
+
+  mkdir("exports", 0755);
+  exporter.start(fractal, "exports/fractal-" + std::to_string(time(nullptr)),
+                 formats);
+}
+
+/**
+ * Generate the fractal's heights and write them to a compressed terrain file,
+ * then read them back and print the size of the file and the largest error.
+ */
+GLvoid compressTerrain()
+{
+  using namespace std::chrono;
+
+  if (env["fractalSeed"] != 0) {
+    srand(env["fractalSeed"]);
+  }
+
+  fractal.generate();
+
+  steady_clock::time_point start = steady_clock::now();
+  HeightCodec::encode(fractal.heights, env["terrainPrecision"],
+                      compressedTerrainFilename);
+  steady_clock::time_point end = steady_clock::now();
+
+  HeightPlane plane = HeightCodec::decode(compressedTerrainFilename,
+                                          fractal.depth);
+  std::ifstream file(compressedTerrainFilename,
+                     std::ios::binary | std::ios::ate);
+  GLdouble rawSize = (GLdouble)fractal.size * fractal.size * sizeof(GLfloat);
+  GLdouble compressedSize = file.tellg();
+  GLfloat largestError = 0.0f;
+
+  for (GLuint x = 0; x < fractal.size; x++) {
+    for (GLuint z = 0; z < fractal.size; z++) {
+      largestError = std::max(largestError, fabsf(plane.get(x, z) -
+                                                  fractal.getYPosition(x, z)));
+    }
+  }
+
+  printf("raw heights:   %.0f bytes\n", rawSize);
+  printf("compressed:    %.0f bytes (%.1fx smaller)\n", compressedSize,
+         rawSize / compressedSize);
+  printf("largest error: %g\n", largestError);
+  printf("encode time:   %.1f ms\n",
+         duration<GLdouble, std::milli>(end - start).count());
+}
+
+/**
+ * Read the command line arguments. Arguments starting with "--" are options,
+ * and any other argument is the profile to use.
+ */
+GLvoid parseArguments(GLint argc, GLchar* argv[])
+{
+  profile = "profile.txt";
+
+  for (GLint i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+
+    if (argument == "--benchmark-storage") {
+      isStorageBenchmarkEnabled = true;
+    } else if (argument == "--headless" && i + 1 < argc) {
+      headlessFrameCount = std::max(atoi(argv[++i]), 1);
+    } else if (argument == "--headless-capture") {
+      isHeadlessCaptureEnabled = true;
+    } else if ((argument == "--record" ||
+                argument == "--replay") && i + 1 < argc) {
+      if (argument == "--record") {
+        recordingFilename = argv[++i];
+      } else {
+        replayFilename = argv[++i];
+      }
+    } else if (argument == "--capture") {
+      isCaptureEnabled = true;
+    } else if (argument == "--export") {
+      isExportEnabled = true;
+    } else if ((argument == "--terrain" ||
+                argument == "--compress-terrain") && i + 1 < argc) {
+      if (argument == "--terrain") {
+        terrainFilename = argv[++i];
+      } else {
+        compressedTerrainFilename = argv[++i];
+      }
+    } else if (argument == "--ray-march" && i + 1 < argc) {
+      rayMarchFrameCount = std::max(atoi(argv[++i]), 1);
+    } else if (argument == "--location" && i + 1 < argc) {
+      locationFilename = argv[++i];
+    } else if (argument == "--ifs" && i + 1 < argc) {
+      ifsFilename = argv[++i];
+    } else if (argument == "--chaos-game" && i + 1 < argc) {
+      chaosGameIterationCount = std::max(atof(argv[++i]), 1.0);
+    } else if (argument.compare(0, 2, "--") == 0) {
+      fprintf(stderr, "unknown option: %s\n", argv[i]);
+
+      exit(EXIT_FAILURE);
+    } else {
+      profile = argv[i];
+    }
+  }
 }
 
 /**
@@ -558,28 +1849,108 @@ GLvoid terminateGraphics()
  */
 GLint main(GLint argc, GLchar* argv[])
 {
-  srand(time(nullptr));
+  GLuint seed = time(nullptr);
 
-  // Read in the profile.
-  profile = (argc >= 2) ? argv[1] : "profile.txt";
+  // Read in the profile and options.
+  parseArguments(argc, argv);
+
+  // Start from the same random numbers as the recording being replayed.
+  if (replayFilename != nullptr) {
+    recorder.startReplay(replayFilename);
+    seed = recorder.header.seed;
+  }
+
+  srand(seed);
 
   // Initialise the envorinment properties.
   initialiseEnvironment();
 
+  if (replayFilename != nullptr &&
+      recorder.header.profileKey != TerrainCache::hashParameters(env)) {
+    fprintf(stderr, "warning: the recording was made with different fractal "
+                    "settings\n");
+  }
+
+  // Run the benchmark instead of the simulation, if requested.
+  if (isStorageBenchmarkEnabled) {
+    benchmarkHeightStorage();
+
+    return 0;
+  }
+
+  if (chaosGameIterationCount > 0) {
+    benchmarkChaosGame();
+
+    return 0;
+  }
+
+  // Generate and export the fractal instead of running the simulation.
+  if (isExportEnabled) {
+    if (env["fractalSeed"] != 0) {
+      srand(env["fractalSeed"]);
+    }
+
+    generateFractal();
+    exportFractal();
+    exporter.wait();
+
+    return 0;
+  }
+
+  // Write the compressed terrain instead of running the simulation.
+  if (compressedTerrainFilename != nullptr) {
+    compressTerrain();
+
+    return 0;
+  }
+
+  // Ray march the 3D fractal on the CPU instead of running the simulation.
+  if (rayMarchFrameCount > 0) {
+    renderRayMarchedFrames();
+
+    return 0;
+  }
+
   // Initialise the graphics environment.
   initialiseGraphics(argc, argv);
   
+  // Load the fractal from the cache, or generate it, on another thread while
+  // the buffers and shaders are initialised. Only the main thread uses the
+  // OpenGL context, and generating the fractal doesn't need it.
+  std::thread generator(loadFractal);
+
   // Initialise the buffers and shaders.
   initialiseBuffersAndShaders();
 
-  // Generate the fractal.
-  generateFractal();
+  generator.join();
 
   // Push the vertex data into the buffers.
   updateFractalBuffer();
 
-  // Run the graphics loop.
-  runMainLoop();
+  loadVolume();
+
+  if (isCaptureEnabled) {
+    toggleCapture();
+  }
+
+  // Run the graphics loop, or render the benchmark frames.
+  if (headlessFrameCount > 0) {
+    runHeadlessLoop();
+  } else {
+    if (recordingFilename != nullptr && replayFilename == nullptr) {
+      recorder.startRecording(recordingFilename, seed,
+                              TerrainCache::hashParameters(env),
+                              glfwGetTime());
+    }
+
+    runMainLoop();
+  }
+
+  recorder.stop();
+  capture.stop();
+
+  // Let any export in progress finish.
+  exporter.wait();
 
   // Close the application gracefully.
   terminateGraphics();
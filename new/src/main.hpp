@@ -15,28 +15,99 @@
 #include "helpers.hpp"
 #include "camera.cpp"
 #include "shader.cpp"
+#include "heightplane.cpp"
+#include "heightcodec.cpp"
+#include "chaosgame.cpp"
+#include "generator.cpp"
+#include "noisegenerator.cpp"
+#include "fouriertransform.cpp"
+#include "spectralgenerator.cpp"
+#include "bigfloat.cpp"
+#include "deepzoom.cpp"
+#include "escapetimegenerator.cpp"
+#include "chaosgamegenerator.cpp"
+#include "distanceestimator.cpp"
+#include "raymarcher.cpp"
+#include "volumemesher.cpp"
+#include "voxelfractal.cpp"
+#include "lsystem.cpp"
+#include "meshoptimiser.cpp"
+#include "terrainsimplifier.cpp"
 #include "fractal.cpp"
+#include "culler.cpp"
+#include "terraincache.cpp"
+#include "exporter.cpp"
+#include "headless.cpp"
+#include "recorder.cpp"
+#include "capture.cpp"
 
 #define true  1
 #define false 0
 #define DEFAULT_WINDOW_WIDTH  1200
 #define DEFAULT_WINDOW_HEIGHT 675
 
+// Distance the camera moves, as a fraction of its distance from the voxel
+// fractal, before the fractal is meshed again.
+#define VOXEL_REMESH_DISTANCE 0.1f
+
+// Width/height of the density image saved by the chaos game benchmark.
+#define CHAOS_IMAGE_SIZE 1024
+
+// Number of vertices of an L-system curve written into its vertex buffer
+// through each mapping of the buffer.
+#define CURVE_BATCH_SIZE 262144
+
 GLvoid initialiseAll();
 GLvoid keyboard(GLFWwindow* window, GLint key, GLint scancode,
                 GLint action, GLint mode);
 GLvoid mouse(GLFWwindow* window, GLdouble x, GLdouble y);
+GLvoid pressKey(GLint key, GLuint seed);
 GLvoid updateTime();
+GLvoid stepTime();
+GLvoid recordInput();
+GLvoid replayInput();
 GLvoid initialiseEnvironment();
 GLvoid initialiseCamera();
 GLvoid updateCamera();
 GLvoid initialiseFractal();
 GLvoid generateFractal();
+GLvoid loadFractal();
+GLvoid exportFractal();
+GLvoid toggleCapture();
+GLvoid initialiseEscapeTimeView();
+GLvoid updateGenerator();
+GLvoid moveEscapeTimeView(GLfloat realOffset, GLfloat imaginaryOffset,
+                          GLfloat zoom);
+GLvoid useFractalShader(GLuint shaderID, glm::mat4 model);
+GLvoid drawFractalMesh(GLuint shaderID, GLenum mode);
 GLvoid drawFractal();
+glm::mat4 getVolumeModel();
+GLvoid drawVolume();
+GLvoid drawCurve();
 GLvoid runMainLoop();
+GLvoid runHeadlessLoop();
+GLvoid printFrameTimings(std::vector<GLdouble>& frameTimes, GLdouble totalTime,
+                         GLuint width, GLuint height);
+GLvoid renderRayMarchedFrames();
 GLvoid initialiseBuffersAndShaders();
+GLvoid uploadBuffer(GLenum target, GLsizeiptr& bufferSize, GLsizeiptr size,
+                    const GLvoid* data);
 GLvoid updateFractalBuffer();
-GLvoid addVertexAttributes(GLuint shaderID);
+GLvoid updateVolumeBuffer();
+GLvoid updateVoxelBuffer(GLuint isForced);
+GLvoid updateChaosCloudBuffer();
+GLvoid updateCurveBuffer();
+GLvoid toggleVolume(GLuint& isEnabled);
+GLvoid loadVolume();
+GLvoid uploadVolumeBuffer(const std::vector<GLfloat>& vertexData,
+                          const std::vector<GLuint>& indexData,
+                          GLuint triangleIndexCount, GLuint lineIndexCount);
+GLvoid addVertexAttributes(GLuint shaderID, GLuint isPacked);
 GLvoid initialiseGraphics(GLint argc, GLchar* argv[]);
+GLvoid initialiseWindow();
 GLvoid terminateGraphics();
+GLvoid benchmarkChaosGame();
+GLvoid benchmarkHeightStorage();
+GLvoid compressTerrain();
+GLvoid parseArguments(GLint argc, GLchar* argv[]);
 GLint main(GLint argc, GLchar* argv[]);
\ No newline at end of file
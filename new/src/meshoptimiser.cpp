@@ -0,0 +1,181 @@
+/**
+ * [Program description]
+ */
+
+#include "meshoptimiser.hpp"
+
+/**
+ * Constructor to create an optimiser for a vertex cache of a given size.
+ */
+MeshOptimiser::MeshOptimiser(GLuint desiredCacheSize)
+{
+  cacheSize = desiredCacheSize;
+}
+
+/**
+ * Calculate the average cache miss ratio (ACMR) of a list of triangles, which
+ * is the number of vertex shader invocations per triangle when drawn through
+ * a FIFO vertex cache. The best possible ratio for a large grid is 0.5.
+ */
+GLfloat MeshOptimiser::calculateAcmr(const GLuint* indices, GLuint indexCount,
+                                     GLuint vertexCount)
+{
+  std::vector<GLuint> cacheTime(vertexCount, 0);
+  GLuint time = cacheSize + 1;
+  GLuint misses = 0;
+
+  if (indexCount == 0) {
+    return 0.0f;
+  }
+
+  for (GLuint i = 0; i < indexCount; i++) {
+    GLuint vertex = indices[i];
+
+    if (time - cacheTime[vertex] > cacheSize) {
+      cacheTime[vertex] = time++;
+      misses++;
+    }
+  }
+
+  return (GLfloat)misses / (GLfloat)(indexCount / 3);
+}
+
+/**
+ * Reorder a list of triangles in place to make better use of the vertex
+ * cache, using the Tipsify algorithm by Sander, Nehab and Barczak (2007).
+ *
+ * Triangles are emitted as fans around a vertex. The next vertex to fan
+ * around is the most recently used vertex which still has triangles left and
+ * is likely to remain in the cache while they are emitted. When no such vertex
+ * exists, the algorithm backtracks through recently used vertices before
+ * falling back to the next unfinished vertex in order.
+ */
+GLvoid MeshOptimiser::optimiseTriangles(GLuint* indices, GLuint indexCount)
+{
+  GLuint triangleCount = indexCount / 3;
+
+  if (triangleCount == 0) {
+    return;
+  }
+
+  // Number the vertices used by this list of triangles from zero so the
+  // working arrays only need to cover the vertices in the list.
+  std::vector<GLuint> vertices(indices, indices + indexCount);
+  std::sort(vertices.begin(), vertices.end());
+  vertices.erase(std::unique(vertices.begin(), vertices.end()),
+                 vertices.end());
+
+  GLuint vertexCount = vertices.size();
+  std::vector<GLuint> localIndices(indexCount);
+
+  for (GLuint i = 0; i < indexCount; i++) {
+    localIndices[i] = std::lower_bound(vertices.begin(), vertices.end(),
+                                       indices[i]) - vertices.begin();
+  }
+
+  // Build the list of triangles which use each vertex.
+  std::vector<GLuint> adjacencyOffsets(vertexCount + 1, 0);
+  std::vector<GLuint> adjacency(indexCount);
+  std::vector<GLint> liveCount(vertexCount, 0);
+
+  for (GLuint i = 0; i < indexCount; i++) {
+    liveCount[localIndices[i]]++;
+  }
+
+  for (GLuint i = 0; i < vertexCount; i++) {
+    adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveCount[i];
+  }
+
+  std::vector<GLuint> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+  for (GLuint i = 0; i < indexCount; i++) {
+    adjacency[fill[localIndices[i]]++] = i / 3;
+  }
+
+  std::vector<GLuint> cacheTime(vertexCount, 0);
+  std::vector<GLuint> emitted(triangleCount, false);
+  std::vector<GLuint> deadEnd;
+  std::vector<GLuint> candidates;
+  std::vector<GLuint> output;
+  GLuint time = cacheSize + 1;
+  GLuint cursor = 1;
+  GLint fanning = 0;
+
+  output.reserve(indexCount);
+
+  while (fanning >= 0) {
+    candidates.clear();
+
+    // Emit every remaining triangle around the current vertex.
+    for (GLuint i = adjacencyOffsets[fanning];
+         i < adjacencyOffsets[fanning + 1]; i++) {
+      GLuint triangle = adjacency[i];
+
+      if (emitted[triangle]) {
+        continue;
+      }
+
+      for (GLuint j = 0; j < 3; j++) {
+        GLuint vertex = localIndices[triangle * 3 + j];
+
+        output.push_back(vertex);
+        deadEnd.push_back(vertex);
+        candidates.push_back(vertex);
+        liveCount[vertex]--;
+
+        if (time - cacheTime[vertex] > cacheSize) {
+          cacheTime[vertex] = time++;
+        }
+      }
+
+      emitted[triangle] = true;
+    }
+
+    // Choose the candidate which is the oldest in the cache but will still be
+    // there once all of its remaining triangles have been emitted.
+    GLint next = -1;
+    GLint bestPriority = -1;
+
+    for (GLuint i = 0; i < candidates.size(); i++) {
+      GLuint vertex = candidates[i];
+
+      if (liveCount[vertex] > 0) {
+        GLint priority = 0;
+
+        if (time - cacheTime[vertex] + 2 * liveCount[vertex] <= cacheSize) {
+          priority = time - cacheTime[vertex];
+        }
+
+        if (priority > bestPriority) {
+          bestPriority = priority;
+          next = vertex;
+        }
+      }
+    }
+
+    // Otherwise backtrack through the recently used vertices, then move on to
+    // the next vertex in order.
+    while (next == -1 && !deadEnd.empty()) {
+      GLuint vertex = deadEnd.back();
+      deadEnd.pop_back();
+
+      if (liveCount[vertex] > 0) {
+        next = vertex;
+      }
+    }
+
+    while (next == -1 && cursor < vertexCount) {
+      if (liveCount[cursor] > 0) {
+        next = cursor;
+      }
+
+      cursor++;
+    }
+
+    fanning = next;
+  }
+
+  for (GLuint i = 0; i < indexCount; i++) {
+    indices[i] = vertices[output[i]];
+  }
+}
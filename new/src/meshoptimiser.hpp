@@ -0,0 +1,22 @@
+/**
+ * [Program description]
+ */
+
+#ifndef MESH_OPTIMISER_HEADER
+#define MESH_OPTIMISER_HEADER
+
+class MeshOptimiser
+{
+  public:
+    /**
+     * cacheSize - number of vertices held by the simulated vertex cache
+     */
+    GLuint cacheSize;
+
+    MeshOptimiser(GLuint desiredCacheSize);
+    GLfloat calculateAcmr(const GLuint* indices, GLuint indexCount,
+                          GLuint vertexCount);
+    GLvoid optimiseTriangles(GLuint* indices, GLuint indexCount);
+};
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * [Program description]
+ */
+
+#include "noisegenerator.hpp"
+
+// Directions of the gradients at the lattice points.
+const GLfloat noiseGradientX[8] = {1.0f, -1.0f, 1.0f, -1.0f,
+                                   1.0f, -1.0f, 0.0f, 0.0f};
+const GLfloat noiseGradientZ[8] = {1.0f, 1.0f, -1.0f, -1.0f,
+                                   0.0f, 0.0f, 1.0f, -1.0f};
+
+/**
+ * Constructor to create a fractional Brownian motion (fBm) generator, which
+ * adds together octaves of Perlin gradient noise, from the profile's values.
+ */
+NoiseGenerator::NoiseGenerator(std::map<std::string, GLfloat>& env)
+{
+  yRange = env["fractalYRange"];
+  octaveCount = std::max(env["noiseOctaveCount"], 1.0f);
+  frequency = env["noiseFrequency"];
+  lacunarity = env["noiseLacunarity"];
+  gain = env["noiseGain"];
+}
+
+/**
+ * Generate the heights with new random gradients. The frequency of each
+ * octave is rounded to a whole number of cells, and the lattice wraps around
+ * at the edges of the plane, so the noise tiles like the rest of the fractal.
+ * Each octave's hashes are a shuffle of its cells, so the noise never repeats
+ * within the plane, however many cells the octave has.
+ */
+GLvoid NoiseGenerator::generate(HeightPlane& plane)
+{
+  GLfloat octaveFrequency = frequency;
+  GLfloat octaveRange = yRange;
+
+  octaveFrequencies = std::vector<GLuint>(octaveCount);
+  octaveRanges = std::vector<GLfloat>(octaveCount);
+  permutations = std::vector<std::vector<GLuint>>(octaveCount);
+
+  for (GLuint octave = 0; octave < octaveCount; octave++) {
+    std::vector<GLuint>& table = permutations[octave];
+
+    octaveFrequencies[octave] = std::min(std::max(lroundf(octaveFrequency),
+                                                  1l), (long)plane.size);
+    octaveRanges[octave] = octaveRange;
+    octaveFrequency *= lacunarity;
+    octaveRange *= gain;
+
+    table = std::vector<GLuint>(octaveFrequencies[octave]);
+
+    for (GLuint i = 0; i < table.size(); i++) {
+      table[i] = i;
+    }
+
+    for (GLuint i = table.size() - 1; i > 0; i--) {
+      std::swap(table[i], table[rand() % (i + 1)]);
+    }
+  }
+
+  PointGenerator<NoiseGenerator>::generate(plane);
+}
+
+/**
+ * Calculate one row of heights, adding the octaves of noise together.
+ */
+GLvoid NoiseGenerator::generateRow(GLuint x, GLuint size, GLfloat* row)
+{
+  std::fill(row, row + size, 0.0f);
+
+  for (GLuint octave = 0; octave < octaveCount; octave++) {
+    addOctave(octave, x, size, row);
+  }
+}
+
+/**
+ * Add one octave of noise to a row of heights, one lattice cell at a time.
+ * The hashes and gradients of a cell's corners are looked up once, and the
+ * points within the cell are calculated in a loop of plain arithmetic, which
+ * the compiler turns into SIMD instructions.
+ */
+GLvoid NoiseGenerator::addOctave(GLuint octave, GLuint x, GLuint size,
+                                 GLfloat* row)
+{
+  const GLuint* table = permutations[octave].data();
+  GLuint period = octaveFrequencies[octave];
+  GLfloat range = octaveRanges[octave];
+  GLfloat scale = (GLfloat)period / size;
+
+  // The row shares its cell and fade along X.
+  GLfloat u = x * scale;
+  GLuint cellX0 = u;
+  GLuint cellX1 = (cellX0 + 1 == period) ? 0 : cellX0 + 1;
+  GLfloat x0 = u - cellX0;
+  GLfloat x1 = x0 - 1.0f;
+  GLfloat sx = x0 * x0 * x0 * (x0 * (x0 * 6.0f - 15.0f) + 10.0f);
+  GLuint hashX0 = table[cellX0];
+  GLuint hashX1 = table[cellX1];
+
+  for (GLuint cellZ0 = 0; cellZ0 < period; cellZ0++) {
+    GLuint cellZ1 = (cellZ0 + 1 == period) ? 0 : cellZ0 + 1;
+    GLuint start = ((size_t)cellZ0 * size + period - 1) / period;
+    GLuint end = ((size_t)(cellZ0 + 1) * size + period - 1) / period;
+
+    GLuint h00 = table[(hashX0 + cellZ0) % period] & 7;
+    GLuint h01 = table[(hashX0 + cellZ1) % period] & 7;
+    GLuint h10 = table[(hashX1 + cellZ0) % period] & 7;
+    GLuint h11 = table[(hashX1 + cellZ1) % period] & 7;
+
+    // The X part of each corner's gradient is the same for the whole cell.
+    GLfloat a00 = noiseGradientX[h00] * x0, b00 = noiseGradientZ[h00];
+    GLfloat a01 = noiseGradientX[h01] * x0, b01 = noiseGradientZ[h01];
+    GLfloat a10 = noiseGradientX[h10] * x1, b10 = noiseGradientZ[h10];
+    GLfloat a11 = noiseGradientX[h11] * x1, b11 = noiseGradientZ[h11];
+
+    for (GLuint z = start; z < end; z++) {
+      GLfloat z0 = z * scale - cellZ0;
+      GLfloat z1 = z0 - 1.0f;
+      GLfloat sz = z0 * z0 * z0 * (z0 * (z0 * 6.0f - 15.0f) + 10.0f);
+
+      GLfloat n00 = a00 + b00 * z0;
+      GLfloat n01 = a01 + b01 * z1;
+      GLfloat n10 = a10 + b10 * z0;
+      GLfloat n11 = a11 + b11 * z1;
+
+      GLfloat n0 = n00 + sz * (n01 - n00);
+      GLfloat n1 = n10 + sz * (n11 - n10);
+
+      row[z] += range * (n0 + sx * (n1 - n0));
+    }
+  }
+}
@@ -0,0 +1,39 @@
+/**
+ * [Program description]
+ */
+
+#ifndef NOISE_GENERATOR_HEADER
+#define NOISE_GENERATOR_HEADER
+
+class NoiseGenerator : public PointGenerator<NoiseGenerator>
+{
+  public:
+    /**
+     * yRange - Y value range of the first octave
+     * octaveCount - number of octaves of noise added together
+     * frequency - number of noise cells across the plane in the first octave
+     * lacunarity - factor the frequency is scaled by each octave
+     * gain - factor the Y value range is scaled by each octave
+     *
+     * octaveFrequencies - number of noise cells across the plane per octave
+     * octaveRanges - Y value range of each octave
+     * permutations - shuffled lattice hashes of each octave, one for each
+     *                cell across the plane
+     */
+    GLfloat yRange;
+    GLuint octaveCount;
+    GLfloat frequency;
+    GLfloat lacunarity;
+    GLfloat gain;
+
+    std::vector<GLuint> octaveFrequencies;
+    std::vector<GLfloat> octaveRanges;
+    std::vector<std::vector<GLuint>> permutations;
+
+    NoiseGenerator(std::map<std::string, GLfloat>& env);
+    GLvoid generate(HeightPlane& plane);
+    GLvoid generateRow(GLuint x, GLuint size, GLfloat* row);
+    GLvoid addOctave(GLuint octave, GLuint x, GLuint size, GLfloat* row);
+};
+
+#endif
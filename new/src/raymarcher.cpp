@@ -0,0 +1,261 @@
+/**
+ * [Program description]
+ */
+
+#include <float.h>
+
+#include "raymarcher.hpp"
+
+// Offsets of the points sampled around a hit to find its normal.
+const GLfloat rayNormalOffsets[4][3] = {
+  {1.0f, -1.0f, -1.0f}, {-1.0f, -1.0f, 1.0f},
+  {-1.0f, 1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}
+};
+
+/**
+ * Constructor to create a ray marcher of the profile's 3D fractal, which
+ * renders images on the CPU.
+ */
+RayMarcher::RayMarcher(std::map<std::string, GLfloat>& env) :
+  estimator(env)
+{
+  width = std::max(env["rayMarchWidth"], 1.0f);
+  height = std::max(env["rayMarchHeight"], 1.0f);
+  stepCount = std::max(env["rayMarchStepCount"], 1.0f);
+  detail = env["rayMarchDetail"];
+  colour = glm::vec3(env["fractalColourRed"], env["fractalColourGreen"],
+                     env["fractalColourBlue"]);
+  backgroundColour = glm::vec3(env["backgroundColourRed"],
+                               env["backgroundColourGreen"],
+                               env["backgroundColourBlue"]);
+  lightDirection = glm::normalize(glm::vec3(env["lightPositionX"],
+                                            env["lightPositionY"],
+                                            env["lightPositionZ"]));
+  pixels = std::vector<GLubyte>(width * height * 3);
+}
+
+/**
+ * Render an image of the fractal from the camera.
+ *
+ * The image is split into tiles, and each thread starts with its own run of
+ * neighbouring tiles. A thread which runs out takes tiles from the far end of
+ * another thread's run (work stealing), so the threads stay busy even though
+ * the tiles covering the fractal take much longer than the empty ones.
+ */
+GLvoid RayMarcher::render(Camera& camera)
+{
+  origin = camera.position;
+  forward = glm::normalize(camera.front);
+  right = glm::normalize(glm::cross(forward, camera.up));
+  up = glm::cross(right, forward);
+  halfHeight = tanf(glm::radians(camera.getFov()) / 2.0f);
+  pixelAngle = 2.0f * halfHeight / height;
+
+  GLuint tilesX = (width + RAY_MARCH_TILE_SIZE - 1) / RAY_MARCH_TILE_SIZE;
+  GLuint tilesY = (height + RAY_MARCH_TILE_SIZE - 1) / RAY_MARCH_TILE_SIZE;
+  GLuint tileCount = tilesX * tilesY;
+  GLuint threadCount = getThreadCount();
+  std::vector<std::deque<GLuint>> queues(threadCount);
+  std::unique_ptr<std::mutex[]> queueMutexes(new std::mutex[threadCount]);
+
+  for (GLuint tile = 0; tile < tileCount; tile++) {
+    queues[(GLuint64)tile * threadCount / tileCount].push_back(tile);
+  }
+
+  // Take the next tile of a thread's own run, or steal the last tile of
+  // another thread's run.
+  auto takeTile = [&](GLuint thread, GLuint& tile) {
+    for (GLuint i = 0; i < threadCount; i++) {
+      GLuint victim = (thread + i) % threadCount;
+      std::lock_guard<std::mutex> lock(queueMutexes[victim]);
+
+      if (queues[victim].empty()) {
+        continue;
+      }
+
+      if (i == 0) {
+        tile = queues[victim].front();
+        queues[victim].pop_front();
+      } else {
+        tile = queues[victim].back();
+        queues[victim].pop_back();
+      }
+
+      return true;
+    }
+
+    return false;
+  };
+
+  runOnThreads([&](GLuint thread) {
+    GLuint tile;
+
+    while (takeTile(thread, tile)) {
+      renderTile(tile);
+    }
+  });
+}
+
+/**
+ * Render one tile of the image, a packet of neighbouring rays along each row
+ * at a time.
+ */
+GLvoid RayMarcher::renderTile(GLuint tile)
+{
+  GLuint tilesX = (width + RAY_MARCH_TILE_SIZE - 1) / RAY_MARCH_TILE_SIZE;
+  GLuint startX = (tile % tilesX) * RAY_MARCH_TILE_SIZE;
+  GLuint startY = (tile / tilesX) * RAY_MARCH_TILE_SIZE;
+  GLuint endX = std::min(startX + RAY_MARCH_TILE_SIZE, width);
+  GLuint endY = std::min(startY + RAY_MARCH_TILE_SIZE, height);
+
+  for (GLuint y = startY; y < endY; y++) {
+    for (GLuint x = startX; x < endX; x += RAY_PACKET_SIZE) {
+      marchPacket(x, y, std::min(endX - x, (GLuint)RAY_PACKET_SIZE));
+    }
+  }
+}
+
+/**
+ * March a packet of rays through neighbouring pixels of a row, and shade
+ * them. Each ray starts where it enters the sphere bounding the fractal, and
+ * steps forward by the estimated distance to the fractal until it's closer
+ * than the footprint of a pixel at that distance, scaled by the detail, or
+ * leaves the sphere. Rays further from the camera stop sooner, so the steps
+ * spent on each ray match the detail that its pixel can show.
+ */
+GLvoid RayMarcher::marchPacket(GLuint x, GLuint y, GLuint count)
+{
+  GLfloat directionXs[RAY_PACKET_SIZE], directionYs[RAY_PACKET_SIZE];
+  GLfloat directionZs[RAY_PACKET_SIZE];
+  GLfloat pointXs[RAY_PACKET_SIZE], pointYs[RAY_PACKET_SIZE];
+  GLfloat pointZs[RAY_PACKET_SIZE];
+  GLfloat distances[RAY_PACKET_SIZE];
+  GLfloat nears[RAY_PACKET_SIZE], fars[RAY_PACKET_SIZE];
+  GLint isActive[RAY_PACKET_SIZE], isHit[RAY_PACKET_SIZE];
+  GLuint steps[RAY_PACKET_SIZE];
+  GLfloat radius = estimator.boundingRadius;
+  GLfloat aspectRatio = (GLfloat)width / height;
+
+  for (GLuint i = 0; i < RAY_PACKET_SIZE; i++) {
+    GLuint pixelX = x + std::min(i, count - 1);
+    GLfloat u = (2.0f * (pixelX + 0.5f) / width - 1.0f) * aspectRatio *
+                halfHeight;
+    GLfloat v = (1.0f - 2.0f * (y + 0.5f) / height) * halfHeight;
+    glm::vec3 direction = glm::normalize(forward + u * right + v * up);
+
+    GLfloat b = glm::dot(origin, direction);
+    GLfloat c = glm::dot(origin, origin) - radius * radius;
+    GLfloat discriminant = b * b - c;
+    GLfloat root = sqrtf(std::max(discriminant, 0.0f));
+
+    directionXs[i] = direction.x;
+    directionYs[i] = direction.y;
+    directionZs[i] = direction.z;
+    nears[i] = std::max(-b - root, 0.0f);
+    fars[i] = -b + root;
+    isActive[i] = discriminant > 0.0f && fars[i] > 0.0f;
+    isHit[i] = false;
+    steps[i] = 0;
+  }
+
+  for (GLuint step = 0; step < stepCount; step++) {
+    GLint activeCount = 0;
+
+    for (GLuint i = 0; i < RAY_PACKET_SIZE; i++) {
+      pointXs[i] = origin.x + directionXs[i] * nears[i];
+      pointYs[i] = origin.y + directionYs[i] * nears[i];
+      pointZs[i] = origin.z + directionZs[i] * nears[i];
+    }
+
+    estimator.getDistances(pointXs, pointYs, pointZs, distances,
+                           RAY_PACKET_SIZE);
+
+    for (GLuint i = 0; i < RAY_PACKET_SIZE; i++) {
+      GLfloat epsilon = std::max(detail * pixelAngle * nears[i],
+                                 RAY_MARCH_MIN_EPSILON);
+      GLint isHitting = isActive[i] & (distances[i] < epsilon);
+      GLint isStepping = isActive[i] & !isHitting;
+
+      isHit[i] |= isHitting;
+      nears[i] += isStepping ? distances[i] : 0.0f;
+      steps[i] += isStepping;
+      isActive[i] = isStepping & (nears[i] < fars[i]);
+      activeCount += isActive[i];
+    }
+
+    if (activeCount == 0) {
+      break;
+    }
+  }
+
+  // Find the normals of the hits from the distances around them, sampled
+  // over the footprint of their pixels.
+  glm::vec3 normals[RAY_PACKET_SIZE];
+  GLint hitCount = 0;
+
+  for (GLuint i = 0; i < RAY_PACKET_SIZE; i++) {
+    normals[i] = glm::vec3(0.0f);
+    hitCount += isHit[i];
+  }
+
+  for (GLuint j = 0; j < 4 && hitCount > 0; j++) {
+    for (GLuint i = 0; i < RAY_PACKET_SIZE; i++) {
+      GLfloat offset = std::max(detail * pixelAngle * nears[i],
+                                RAY_MARCH_MIN_EPSILON);
+
+      pointXs[i] = origin.x + directionXs[i] * nears[i] +
+                   rayNormalOffsets[j][0] * offset;
+      pointYs[i] = origin.y + directionYs[i] * nears[i] +
+                   rayNormalOffsets[j][1] * offset;
+      pointZs[i] = origin.z + directionZs[i] * nears[i] +
+                   rayNormalOffsets[j][2] * offset;
+    }
+
+    estimator.getDistances(pointXs, pointYs, pointZs, distances,
+                           RAY_PACKET_SIZE);
+
+    for (GLuint i = 0; i < RAY_PACKET_SIZE; i++) {
+      normals[i] += distances[i] * glm::vec3(rayNormalOffsets[j][0],
+                                             rayNormalOffsets[j][1],
+                                             rayNormalOffsets[j][2]);
+    }
+  }
+
+  // Light the hits, darkening those which took many steps to reach, since
+  // they're in the crevices of the fractal. Where the distances are the same
+  // on every side there is no gradient, so the hit faces back along the ray.
+  for (GLuint i = 0; i < count; i++) {
+    glm::vec3 pixelColour = backgroundColour;
+
+    if (isHit[i]) {
+      glm::vec3 normal = -glm::vec3(directionXs[i], directionYs[i],
+                                    directionZs[i]);
+
+      if (glm::dot(normals[i], normals[i]) > FLT_MIN) {
+        normal = glm::normalize(normals[i]);
+      }
+
+      GLfloat diffuse = std::max(glm::dot(normal, lightDirection), 0.0f);
+      GLfloat occlusion = 1.0f - (GLfloat)steps[i] / stepCount;
+
+      pixelColour = colour * (0.25f + 0.75f * diffuse) * occlusion;
+    }
+
+    GLubyte* pixel = &pixels[(y * width + x + i) * 3];
+
+    for (GLuint j = 0; j < 3; j++) {
+      pixel[j] = std::min(std::max(pixelColour[j], 0.0f), 1.0f) * 255.0f;
+    }
+  }
+}
+
+/**
+ * Save the image as a binary PPM file.
+ */
+GLvoid RayMarcher::saveImage(std::string filename)
+{
+  std::ofstream file(filename.c_str(), std::ios::binary);
+
+  file << "P6\n" << width << " " << height << "\n255\n";
+  file.write((const GLchar*)pixels.data(), pixels.size());
+}
@@ -0,0 +1,64 @@
+/**
+ * [Program description]
+ */
+
+#ifndef RAY_MARCHER_HEADER
+#define RAY_MARCHER_HEADER
+
+// Width/height of the screen tiles handed out to the threads.
+#define RAY_MARCH_TILE_SIZE 16
+
+// Number of neighbouring rays marched together.
+#define RAY_PACKET_SIZE DISTANCE_PACKET_SIZE
+
+// Smallest distance at which a ray hits the fractal, for rays which start
+// right next to the camera.
+#define RAY_MARCH_MIN_EPSILON 1e-6f
+
+class RayMarcher
+{
+  public:
+    /**
+     * estimator - distance estimator of the fractal
+     * width - width of the image in pixels
+     * height - height of the image in pixels
+     * stepCount - largest number of steps along each ray
+     * detail - size of the smallest details drawn, in pixels
+     * colour - colour of the fractal
+     * backgroundColour - colour of rays which miss the fractal
+     * lightDirection - direction of the light from the fractal
+     * pixels - colour of each pixel, top row first
+     *
+     * origin - position of the camera for the frame being rendered
+     * forward - direction the camera faces
+     * right - direction to the right of the image
+     * up - direction to the top of the image
+     * halfHeight - height of half the image one unit in front of the camera
+     * pixelAngle - angle between neighbouring rays, so that a pixel's
+     *              footprint at a distance t from the camera is t * pixelAngle
+     */
+    DistanceEstimator estimator;
+    GLuint width;
+    GLuint height;
+    GLuint stepCount;
+    GLfloat detail;
+    glm::vec3 colour;
+    glm::vec3 backgroundColour;
+    glm::vec3 lightDirection;
+    std::vector<GLubyte> pixels;
+
+    glm::vec3 origin;
+    glm::vec3 forward;
+    glm::vec3 right;
+    glm::vec3 up;
+    GLfloat halfHeight;
+    GLfloat pixelAngle;
+
+    RayMarcher(std::map<std::string, GLfloat>& env);
+    GLvoid render(Camera& camera);
+    GLvoid renderTile(GLuint tile);
+    GLvoid marchPacket(GLuint x, GLuint y, GLuint count);
+    GLvoid saveImage(std::string filename);
+};
+
+#endif
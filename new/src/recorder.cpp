@@ -0,0 +1,173 @@
+/**
+ * [Program description]
+ */
+
+#include "recorder.hpp"
+
+/**
+ * Constructor to create a recorder which neither records nor replays.
+ */
+Recorder::Recorder()
+{
+  mode = IDLE;
+  memset(&header, 0, sizeof(header));
+  memset(&lastSample, 0, sizeof(lastSample));
+  nextSample = 0;
+  startTime = 0.0f;
+}
+
+/**
+ * Start recording input to the given file. The seed of the random number
+ * generator and the key of the profile's terrain are stored, so that a replay
+ * starts from the same fractal.
+ *
+ * A recording is a header followed by samples, each of which is either a key
+ * press or the state of the held keys and camera. States are only written when
+ * they change, which keeps the file small while the camera is still.
+ */
+GLvoid Recorder::startRecording(std::string filename, GLuint seed,
+                                GLuint64 profileKey, GLfloat time)
+{
+  file.open(filename.c_str(), std::ios::binary);
+
+  if (!file) {
+    fprintf(stderr, "failed to create recording: %s\n", filename.c_str());
+
+    exit(EXIT_FAILURE);
+  }
+
+  memcpy(header.magic, "INPT", 4);
+  header.version = RECORDING_VERSION;
+  header.seed = seed;
+  header.profileKey = profileKey;
+  file.write((const GLchar*)&header, sizeof(header));
+
+  mode = RECORDING;
+  startTime = time;
+
+  // No camera has a negative field of view, so the first state is written.
+  lastSample.fov = -1.0f;
+}
+
+/**
+ * Start replaying the input of the given file.
+ */
+GLvoid Recorder::startReplay(std::string filename)
+{
+  std::ifstream input(filename.c_str(), std::ios::binary);
+  Sample sample;
+
+  if (!input.read((GLchar*)&header, sizeof(header)) ||
+      memcmp(header.magic, "INPT", 4) != 0 || header.version != RECORDING_VERSION) {
+    fprintf(stderr, "not a valid recording: %s\n", filename.c_str());
+
+    exit(EXIT_FAILURE);
+  }
+
+  while (input.read((GLchar*)&sample, sizeof(sample))) {
+    samples.push_back(sample);
+  }
+
+  mode = REPLAYING;
+  nextSample = 0;
+}
+
+/**
+ * Record a key press, along with the seed to use for any random numbers it
+ * needs.
+ */
+GLvoid Recorder::recordKey(GLfloat time, GLint key, GLuint seed)
+{
+  Sample sample = lastSample;
+
+  sample.time = time - startTime;
+  sample.key = key;
+  sample.seed = seed;
+
+  writeSample(sample);
+}
+
+/**
+ * Record the held keys and the camera's position and orientation, if they
+ * have changed since the last sample. The position is stored as well as the
+ * held keys, as a replay's frames are not the same length as the recording's,
+ * so moving by the held keys alone drifts from the recorded path.
+ */
+GLvoid Recorder::recordState(GLfloat time, GLuint heldKeys,
+                             glm::vec3 position, GLfloat yaw, GLfloat pitch,
+                             GLfloat fov)
+{
+  if (heldKeys == lastSample.heldKeys &&
+      position.x == lastSample.position[0] &&
+      position.y == lastSample.position[1] &&
+      position.z == lastSample.position[2] && yaw == lastSample.yaw &&
+      pitch == lastSample.pitch && fov == lastSample.fov) {
+    return;
+  }
+
+  Sample sample;
+
+  sample.time = time - startTime;
+  sample.key = 0;
+  sample.seed = 0;
+  sample.heldKeys = heldKeys;
+
+  for (GLuint i = 0; i < 3; i++) {
+    sample.position[i] = position[i];
+  }
+
+  sample.yaw = yaw;
+  sample.pitch = pitch;
+  sample.fov = fov;
+
+  writeSample(sample);
+}
+
+/**
+ * Write a sample to the recording.
+ */
+GLvoid Recorder::writeSample(Sample sample)
+{
+  if (mode != RECORDING) {
+    return;
+  }
+
+  file.write((const GLchar*)&sample, sizeof(sample));
+  lastSample = sample;
+}
+
+/**
+ * Read the next sample of the replay, if it was recorded at or before the
+ * given time. Returns whether there was a sample to read.
+ */
+GLuint Recorder::readSample(GLfloat time, Sample& sample)
+{
+  if (mode != REPLAYING || nextSample >= samples.size() ||
+      samples[nextSample].time > time) {
+    return false;
+  }
+
+  sample = samples[nextSample++];
+
+  return true;
+}
+
+/**
+ * Check whether every sample of the replay has been read.
+ */
+GLuint Recorder::isFinished()
+{
+  return mode == REPLAYING && nextSample >= samples.size();
+}
+
+/**
+ * Stop recording or replaying.
+ */
+GLvoid Recorder::stop()
+{
+  if (mode == RECORDING) {
+    file.close();
+  }
+
+  mode = IDLE;
+}
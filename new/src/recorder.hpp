@@ -0,0 +1,71 @@
+/**
+ * [Program description]
+ */
+
+#ifndef RECORDER_HEADER
+#define RECORDER_HEADER
+
+// Length of each frame of a replay (in seconds).
+#define REPLAY_TIMESTEP (1.0f / 60.0f)
+
+// Version of the recordings' layout, changed whenever the samples change.
+#define RECORDING_VERSION 2
+
+class Recorder
+{
+  public:
+    typedef enum {
+      IDLE,
+      RECORDING,
+      REPLAYING
+    } Mode;
+
+    typedef struct {
+      GLchar magic[4];
+      GLuint version;
+      GLuint seed;
+      GLuint64 profileKey;
+    } Header;
+
+    typedef struct {
+      GLfloat time;
+      GLint key;
+      GLuint seed;
+      GLuint heldKeys;
+      GLfloat position[3];
+      GLfloat yaw;
+      GLfloat pitch;
+      GLfloat fov;
+    } Sample;
+
+    /**
+     * mode - whether input is being recorded, replayed or neither
+     * header - header of the recording being written or replayed
+     * file - recording being written
+     * samples - samples of the recording being replayed
+     * nextSample - position of the next sample to replay
+     * lastSample - last sample written, to skip writing unchanged states
+     * startTime - time the recording was started at (in seconds)
+     */
+    Mode mode;
+    Header header;
+    std::ofstream file;
+    std::vector<Sample> samples;
+    GLuint nextSample;
+    Sample lastSample;
+    GLfloat startTime;
+
+    Recorder();
+    GLvoid startRecording(std::string filename, GLuint seed,
+                          GLuint64 profileKey, GLfloat time);
+    GLvoid startReplay(std::string filename);
+    GLvoid recordKey(GLfloat time, GLint key, GLuint seed);
+    GLvoid recordState(GLfloat time, GLuint heldKeys, glm::vec3 position,
+                       GLfloat yaw, GLfloat pitch, GLfloat fov);
+    GLvoid writeSample(Sample sample);
+    GLuint readSample(GLfloat time, Sample& sample);
+    GLuint isFinished();
+    GLvoid stop();
+};
+
+#endif
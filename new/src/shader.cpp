@@ -2,24 +2,44 @@
  * [Program description]
  */
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "shader.hpp"
 #include "helpers.hpp"
 
 /**
  * Constructor to read and create the shader. This involves retrieving the
  * shader source code from the given vertex/geometry/fragment files and
- * compiling the code, then linking them into a shader program.
+ * compiling the code, then linking them into a shader program. Variants of the
+ * same source files are created by passing a list of preprocessor defines.
+ *
+ * Linked programs are saved in the cache directory by the driver, and loaded
+ * from there instead of being compiled whenever the same sources are used
+ * with the same driver. The sources are compiled if the driver rejects the
+ * saved program.
  */
 Shader::Shader(std::string vertexFile, std::string fragmentFile,
-               std::string geometryFile = "")
+               std::string geometryFile = "",
+               std::vector<std::string> defines = std::vector<std::string>())
 {
   GLint compileStatus;
   GLchar compileLog[LOG_MSG_LENGTH];
   GLuint vertexShaderID, fragmentShaderID, geometryShaderID = 0;
   GLuint isGeometryShaderIncluded = !geometryFile.empty();
+  std::string vertexSource = addDefines(readFile(vertexFile), defines);
+  std::string fragmentSource = addDefines(readFile(fragmentFile), defines);
+  std::string geometrySource = isGeometryShaderIncluded ?
+                               addDefines(readFile(geometryFile), defines) : "";
+  std::string cachePath = getCachePath({vertexSource, fragmentSource,
+                                        geometrySource});
+
+  if (loadProgramBinary(cachePath)) {
+    return;
+  }
 
   // Vertex shader
-  const GLchar* vertexShaderSource = readFile(vertexFile);
+  const GLchar* vertexShaderSource = vertexSource.c_str();
   vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
   glShaderSource(vertexShaderID, 1, &vertexShaderSource, NULL);
   glCompileShader(vertexShaderID);
@@ -34,7 +54,7 @@ Shader::Shader(std::string vertexFile, std::string fragmentFile,
   }
 
   // Fragment shader
-  const GLchar* fragmentShaderSource = readFile(fragmentFile);
+  const GLchar* fragmentShaderSource = fragmentSource.c_str();
   fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
   glShaderSource(fragmentShaderID, 1, &fragmentShaderSource, NULL);
   glCompileShader(fragmentShaderID);
@@ -50,7 +70,7 @@ Shader::Shader(std::string vertexFile, std::string fragmentFile,
 
   // Geometry shader
   if (isGeometryShaderIncluded) {
-    const GLchar* geometryShaderSource = readFile(geometryFile);
+    const GLchar* geometryShaderSource = geometrySource.c_str();
     geometryShaderID = glCreateShader(GL_GEOMETRY_SHADER);
     glShaderSource(geometryShaderID, 1, &geometryShaderSource, NULL);
     glCompileShader(geometryShaderID);
@@ -74,6 +94,7 @@ Shader::Shader(std::string vertexFile, std::string fragmentFile,
     glAttachShader(programID, geometryShaderID);
   }
 
+  glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   glLinkProgram(programID);
   glGetProgramiv(programID, GL_LINK_STATUS, &compileStatus);
 
@@ -95,6 +116,131 @@ Shader::Shader(std::string vertexFile, std::string fragmentFile,
     glDetachShader(programID, geometryShaderID);
     glDeleteShader(geometryShaderID);
   }
+
+  saveProgramBinary(cachePath);
+}
+
+/**
+ * Get the path of the cached program for the given sources. The name is a
+ * hash of the sources along with the driver's vendor, renderer and version,
+ * since a program saved by one driver can't be used by another.
+ */
+std::string Shader::getCachePath(std::vector<std::string> sources)
+{
+  const GLenum driverStrings[3] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+  GLuint64 hash = 14695981039346656037ull;
+  GLchar name[32];
+
+  for (GLuint i = 0; i < 3; i++) {
+    const GLubyte* driverString = glGetString(driverStrings[i]);
+
+    sources.push_back(driverString ? (const GLchar*)driverString : "");
+  }
+
+  // Hash the strings with the 64-bit FNV-1a hash, including each string's
+  // terminator so that moving text between strings changes the hash.
+  for (GLuint i = 0; i < sources.size(); i++) {
+    for (GLuint j = 0; j <= sources[i].size(); j++) {
+      hash = (hash ^ (GLubyte)sources[i].c_str()[j]) * 1099511628211ull;
+    }
+  }
+
+  snprintf(name, sizeof(name), "%016llx.program", (unsigned long long)hash);
+
+  return std::string(SHADER_CACHE_DIRECTORY) + "/" + name;
+}
+
+/**
+ * Create the program from a binary saved by the driver. Returns false if
+ * there is no saved program, or if the driver rejects it.
+ */
+GLuint Shader::loadProgramBinary(std::string path)
+{
+  std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+  GLint linkStatus;
+  GLenum format;
+
+  if (!file || (size_t)file.tellg() <= sizeof(format)) {
+    return false;
+  }
+
+  std::vector<GLchar> binary((size_t)file.tellg() - sizeof(format));
+  file.seekg(0);
+  file.read((GLchar*)&format, sizeof(format));
+  file.read(binary.data(), binary.size());
+
+  if (!file) {
+    return false;
+  }
+
+  programID = glCreateProgram();
+  glProgramBinary(programID, format, binary.data(), binary.size());
+  glGetProgramiv(programID, GL_LINK_STATUS, &linkStatus);
+
+  if (linkStatus != GL_TRUE) {
+    glDeleteProgram(programID);
+    programID = 0;
+
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Save the linked program as a binary which the driver can load later. Not
+ * every driver supports this, and failing to save it is not an error. The
+ * binary is written under a temporary name of this process's own and then
+ * renamed, so a crash or another run never leaves a partial binary behind.
+ */
+GLvoid Shader::saveProgramBinary(std::string path)
+{
+  GLint formatCount = 0, length = 0;
+  GLenum format;
+
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+  glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+
+  if (formatCount == 0 || length == 0) {
+    return;
+  }
+
+  std::vector<GLchar> binary(length);
+  glGetProgramBinary(programID, length, &length, &format, binary.data());
+
+  mkdir(SHADER_CACHE_DIRECTORY, 0755);
+
+  std::string temporaryPath = path + "." + std::to_string(getpid()) + ".tmp";
+  std::ofstream file(temporaryPath.c_str(), std::ios::binary);
+
+  file.write((const GLchar*)&format, sizeof(format));
+  file.write(binary.data(), length);
+  file.close();
+
+  if (!file || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    remove(temporaryPath.c_str());
+  }
+}
+
+/**
+ * Insert preprocessor defines into shader source code. The defines must follow
+ * the #version directive, which is expected to be on the first line.
+ */
+std::string Shader::addDefines(std::string source,
+                               std::vector<std::string> defines)
+{
+  std::string directives;
+  size_t position = source.find('\n');
+
+  for (GLuint i = 0; i < defines.size(); i++) {
+    directives += "#define " + defines[i] + "\n";
+  }
+
+  if (position == std::string::npos) {
+    return source + "\n" + directives;
+  }
+
+  return source.insert(position + 1, directives);
 }
 
 /**
@@ -6,6 +6,7 @@
 #define SHADER_HEADER
 
 #define LOG_MSG_LENGTH 256
+#define SHADER_CACHE_DIRECTORY "cache"
 
 class Shader
 {
@@ -14,11 +15,19 @@ class Shader
 
     typedef enum {
       FRACTAL,
+      NORMAL,
+      VOLUME,
+      CURVE,
       NONE // only used for enum iteration
     } ShaderType;
     
     Shader(std::string vertexFile, std::string fragmentFile,
-           std::string geometryFile);
+           std::string geometryFile, std::vector<std::string> defines);
+    std::string addDefines(std::string source,
+                           std::vector<std::string> defines);
+    std::string getCachePath(std::vector<std::string> sources);
+    GLuint loadProgramBinary(std::string path);
+    GLvoid saveProgramBinary(std::string path);
     GLvoid setAttributes(GLint attributeCount, const GLchar** attributeNames,
                          GLint* attributeSizes);
 };
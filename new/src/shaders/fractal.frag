@@ -18,7 +18,6 @@ in Data {
   vec4 position;
   vec3 normal;
   vec4 colour;
-  noperspective vec3 wireframeDistance;
 } fragment;
 
 out vec4 colour;
@@ -27,13 +26,11 @@ uniform Material material;
 uniform Light light;
 uniform vec4 viewPosition;
 uniform vec4 wireframeColour;
-uniform bool isWireframeEnabled;
 uniform bool areFacesEnabled;
 
 void main()
 {
   vec3 lightDirection;
-  bool wireframeEnabled = isWireframeEnabled;
 
   if (light.position.w == 0.0f) {
     lightDirection = vec3(normalize(light.position));
@@ -54,25 +51,15 @@ void main()
 
   vec4 finalColour = fragment.colour * vec4(ambient + diffuse + specular, 1.0f);
 
-  if (!areFacesEnabled) {
-    wireframeEnabled = true;
-  }
-
-  if (wireframeEnabled) {
-    // float dist = sqrt(distance(viewPosition, fragment.position));
-    vec3 a3 = smoothstep(vec3(0.0f), fwidth(fragment.wireframeDistance) * 0.9f,
-                         fragment.wireframeDistance);
-    float lineWidth = min(min(a3.x, a3.y), a3.z);
-
-    if (!areFacesEnabled) {
-      colour = vec4(mix(finalColour.rgb, vec3(0.0f), lineWidth),
-                    1.0f - lineWidth);
-    } else {
-      colour = vec4(mix(wireframeColour.rgb, finalColour.rgb, lineWidth),
-                    finalColour.a);
-
-    }
+// The wireframe variant is drawn as lines over the faces, or on its own in the
+// fractal's colour when the faces are hidden.
+#ifdef WIREFRAME
+  if (areFacesEnabled) {
+    colour = wireframeColour;
   } else {
     colour = finalColour;
   }
+#else
+  colour = finalColour;
+#endif
 }
\ No newline at end of file
@@ -8,21 +8,47 @@ out Data {
   vec4 position;
   vec3 normal;
   vec4 colour;
-  vec4 vNormal; // temp
 } vertex;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform mat3 normalMatrix;
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform int instanceRing;
+
+// Find the offset of this copy of the fractal. Copies are drawn one ring at a
+// time, walking around the perimeter of the square ring.
+vec3 instanceOffset()
+{
+  if (instanceRing == 0) {
+    return vec3(0.0f);
+  }
+
+  int sideLength = 2 * instanceRing;
+  int side = gl_InstanceID / sideLength;
+  int offset = gl_InstanceID % sideLength - instanceRing;
+
+  if (side == 0) {
+    return vec3(offset, 0.0f, -instanceRing);
+  } else if (side == 1) {
+    return vec3(instanceRing, 0.0f, offset);
+  } else if (side == 2) {
+    return vec3(-offset, 0.0f, instanceRing);
+  }
+
+  return vec3(-instanceRing, 0.0f, -offset);
+}
 
 void main()
 {
-  gl_Position = projection * view * model * vec4(position, 1.0f);
+  vec3 scaledPosition = position * positionScale + positionOffset;
+  vec4 tiledPosition = vec4(scaledPosition + instanceOffset(), 1.0f);
 
-  vertex.position = model * vec4(position, 1.0f);
-  vertex.normal = normal;
-  vertex.colour = vec4(colour, 1.0f);
+  gl_Position = projection * view * model * tiledPosition;
 
-  vertex.vNormal = normalize(projection * vec4(mat3(
-                   transpose(inverse(view * model))) * normal, 1.0f));
+  vertex.position = model * tiledPosition;
+  vertex.normal = normalize(normalMatrix * normal);
+  vertex.colour = vec4(colour, 1.0f);
 }
\ No newline at end of file
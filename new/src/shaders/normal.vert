@@ -0,0 +1,23 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec3 colour;
+
+out Data {
+  vec4 colour;
+} vertex;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform float normalLength;
+
+void main()
+{
+  gl_Position = projection * view * model *
+                vec4(position + normal * normalLength, 1.0f);
+
+  // Fade each line out towards the end of the normal.
+  vertex.colour = vec4(colour, 1.0f - float(gl_VertexID % 2));
+}
\ No newline at end of file
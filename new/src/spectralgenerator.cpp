@@ -0,0 +1,74 @@
+/**
+ * [Program description]
+ */
+
+#include <float.h>
+
+#include "spectralgenerator.hpp"
+
+/**
+ * Constructor to create a spectral synthesis generator from the profile's
+ * values.
+ */
+SpectralGenerator::SpectralGenerator(std::map<std::string, GLfloat>& env)
+{
+  yRange = env["fractalYRange"];
+  exponent = env["spectralExponent"];
+}
+
+/**
+ * Generate the heights by spectral synthesis. Each frequency of the spectrum
+ * is given a random phase and a random amplitude whose power falls as
+ * 1/f^exponent, and the inverse FFT of the spectrum gives the heights. The
+ * result is periodic, so it tiles like the rest of the fractal, and its cost
+ * doesn't depend on the amount of detail.
+ *
+ * The real part of the inverse of an unrestricted spectrum is used, which has
+ * the same power law as a symmetric spectrum with half the power. The heights
+ * are then scaled to fill the Y range.
+ */
+GLvoid SpectralGenerator::generate(HeightPlane& plane)
+{
+  GLuint size = plane.size;
+  std::vector<GLfloat> reals(size * size);
+  std::vector<GLfloat> imaginaries(size * size);
+  FourierTransform fft(size);
+
+  for (GLuint x = 0; x < size; x++) {
+    GLint kx = (x <= size / 2) ? x : (GLint)x - (GLint)size;
+
+    for (GLuint z = 0; z < size; z++) {
+      GLint kz = (z <= size / 2) ? z : (GLint)z - (GLint)size;
+      GLfloat frequency = sqrtf(kx * kx + kz * kz);
+      GLfloat phase = randomNumber(0.0f, 2.0f * M_PI);
+      GLfloat amplitude = sqrtf(-2.0f * logf(randomNumber(0.0f, 1.0f) +
+                                             FLT_MIN));
+
+      // The constant term would only move the terrain up or down.
+      if (frequency == 0.0f) {
+        amplitude = 0.0f;
+      } else {
+        amplitude *= powf(frequency, -exponent / 2.0f);
+      }
+
+      reals[x * size + z] = amplitude * cosf(phase);
+      imaginaries[x * size + z] = amplitude * sinf(phase);
+    }
+  }
+
+  fft.transform2D(reals, imaginaries, true);
+
+  auto range = std::minmax_element(reals.begin(), reals.end());
+  GLfloat scale = yRange / std::max(std::max(-*range.first, *range.second),
+                                    FLT_MIN);
+
+  if (plane.isQuantised) {
+    plane.setRange(*range.first * scale, *range.second * scale);
+  }
+
+  for (GLuint x = 0; x < size; x++) {
+    for (GLuint z = 0; z < size; z++) {
+      plane.set(x, z, reals[x * size + z] * scale);
+    }
+  }
+}
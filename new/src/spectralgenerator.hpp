@@ -0,0 +1,22 @@
+/**
+ * [Program description]
+ */
+
+#ifndef SPECTRAL_GENERATOR_HEADER
+#define SPECTRAL_GENERATOR_HEADER
+
+class SpectralGenerator : public Generator
+{
+  public:
+    /**
+     * yRange - largest distance of a Y value from zero
+     * exponent - exponent of the power law the spectrum's power falls by
+     */
+    GLfloat yRange;
+    GLfloat exponent;
+
+    SpectralGenerator(std::map<std::string, GLfloat>& env);
+    GLvoid generate(HeightPlane& plane);
+};
+
+#endif
@@ -0,0 +1,324 @@
+/**
+ * [Program description]
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "terraincache.hpp"
+
+/**
+ * Constructor to create a cache which stores terrains in the given directory.
+ */
+TerrainCache::TerrainCache(std::string desiredDirectory = "cache")
+{
+  directory = desiredDirectory;
+  mapping = nullptr;
+  mappingSize = 0;
+  vertexData = nullptr;
+  indexData = nullptr;
+  normalVertexData = nullptr;
+}
+
+/**
+ * Hash the profile values which affect the generated terrain, along with the
+ * cache version, using the 64-bit FNV-1a hash. Any change to these values
+ * produces a different terrain, so it is stored under a different key. Values
+ * missing from the profile are hashed as missing, without adding them to it.
+ */
+GLuint64 TerrainCache::hashParameters(
+                       const std::map<std::string, GLfloat>& env)
+{
+  const GLchar* names[] = {
+    "fractalType", "fractalSeed", "fractalDepth", "fractalChunkSize",
+    "instanceLodCount", "isMortonStorageEnabled", "isQuantisedStorageEnabled",
+    "fractalYRange", "fractalYDeviance", "fractalColourRed",
+    "fractalColourGreen", "fractalColourBlue", "isSmoothingPositionsEnabled",
+    "isSmoothingNormalsEnabled", "isSmoothingColoursEnabled",
+    "isColourNoiseEnabled", "smoothPositionsKernelSize",
+    "smoothPositionsSigmaValue", "smoothNormalsKernelSize",
+    "smoothColoursKernelSize", "smoothColoursSigmaValue", "colourNoiseLevel",
+    "isSimplificationEnabled", "simplificationTolerance", "noiseOctaveCount",
+    "noiseFrequency", "noiseLacunarity", "noiseGain", "spectralExponent",
+    "escapeIterationCount", "escapeCentreReal", "escapeCentreImaginary",
+    "escapeWidth", "juliaReal", "juliaImaginary", "chaosType",
+    "chaosIterationCount"
+  };
+  GLuint nameCount = sizeof(names) / sizeof(names[0]);
+  GLuint64 hash = 14695981039346656037ull;
+
+  auto addBytes = [&hash](const GLvoid* data, size_t size) {
+    const GLubyte* bytes = (const GLubyte*)data;
+
+    for (size_t i = 0; i < size; i++) {
+      hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+  };
+
+  GLuint version = TERRAIN_CACHE_VERSION;
+  addBytes(&version, sizeof(version));
+
+  for (GLuint i = 0; i < nameCount; i++) {
+    auto found = env.find(names[i]);
+    GLubyte isFound = found != env.end();
+
+    addBytes(names[i], strlen(names[i]));
+    addBytes(&isFound, sizeof(isFound));
+
+    if (isFound) {
+      addBytes(&found->second, sizeof(found->second));
+    }
+  }
+
+  return hash;
+}
+
+/**
+ * Get the size of the cache file of a fractal with the given number of
+ * indices, which is smaller when the fractal has been simplified. The file is
+ * a header followed by the vertex, index and normal line streams, then the
+ * chunk and detail level tables and the heights, all of which are sized by
+ * the fractal.
+ */
+size_t TerrainCache::getFileSize(Fractal& fractal, GLuint totalIndexCount)
+{
+  size_t chunks = fractal.chunkCount * fractal.chunkCount;
+  size_t heights = (size_t)fractal.heights.size * fractal.heights.size;
+
+  return sizeof(Header) +
+         (size_t)fractal.vertexCount * fractal.vertexStride +
+         (size_t)totalIndexCount * sizeof(GLuint) +
+         (size_t)fractal.normalVertexCount * Fractal::DIMENSIONS *
+         fractal.attributeCount * sizeof(GLfloat) +
+         chunks * (2 * sizeof(GLfloat) + 2 * sizeof(GLuint) +
+                   2 * sizeof(GLsizei)) +
+         fractal.lodCount * (2 * sizeof(GLuint) + 2 * sizeof(GLsizei)) +
+         heights * (fractal.heights.isQuantised ? sizeof(GLushort) :
+                                                  sizeof(GLfloat));
+}
+
+/**
+ * Get the path of the cache file stored under the given key.
+ */
+std::string TerrainCache::getPath(GLuint64 key)
+{
+  GLchar name[32];
+
+  snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+
+  return directory + "/" + name;
+}
+
+/**
+ * Copy a table of the cache file into the given array, which must already be
+ * the size of the table. Returns the position after the table.
+ */
+template <typename T>
+const GLchar* readTable(const GLchar* cursor, std::vector<T>& values)
+{
+  memcpy(values.data(), cursor, values.size() * sizeof(T));
+
+  return cursor + values.size() * sizeof(T);
+}
+
+/**
+ * Write an array to the cache file as a table.
+ */
+template <typename T>
+GLvoid writeTable(std::ofstream& file, std::vector<T>& values)
+{
+  file.write((const GLchar*)values.data(), values.size() * sizeof(T));
+}
+
+/**
+ * Load the terrain stored under the given key into the fractal. The file is
+ * memory mapped rather than read, so the vertex, index and normal line
+ * streams are left in the mapping to be passed straight to the buffers, and
+ * only the chunk and detail level tables and the heights are copied into the
+ * fractal. The heights are needed to place the terrain, so it is drawn in the
+ * same place as when it was generated. Returns false if there is no usable
+ * cache file.
+ */
+GLuint TerrainCache::load(GLuint64 key, Fractal& fractal)
+{
+  unmap();
+
+  GLint file = open(getPath(key).c_str(), O_RDONLY);
+
+  if (file < 0) {
+    return false;
+  }
+
+  struct stat fileStatus;
+
+  if (fstat(file, &fileStatus) != 0 ||
+      (size_t)fileStatus.st_size < sizeof(Header)) {
+    close(file);
+    return false;
+  }
+
+  mappingSize = fileStatus.st_size;
+  mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    mappingSize = 0;
+    return false;
+  }
+
+  // The whole file is about to be uploaded, so start reading it in now.
+  madvise(mapping, mappingSize, MADV_WILLNEED);
+
+  // Files written by another version, or which don't match this fractal, are
+  // ignored and will be overwritten.
+  const Header* header = (const Header*)mapping;
+
+  if (memcmp(header->magic, "FRAC", 4) != 0 ||
+      header->version != TERRAIN_CACHE_VERSION || header->key != key ||
+      header->vertexCount != fractal.vertexCount ||
+      header->vertexStride != fractal.vertexStride ||
+      header->totalIndexCount > fractal.totalIndexCount ||
+      header->normalVertexCount != fractal.normalVertexCount ||
+      header->chunkCount != fractal.chunkCount ||
+      header->lodCount != fractal.lodCount ||
+      mappingSize != getFileSize(fractal, header->totalIndexCount)) {
+    unmap();
+    return false;
+  }
+
+  const GLchar* cursor = (const GLchar*)mapping + sizeof(Header);
+
+  vertexData = cursor;
+  cursor += (size_t)fractal.vertexCount * fractal.vertexStride;
+  indexData = (const GLuint*)cursor;
+  cursor += (size_t)header->totalIndexCount * sizeof(GLuint);
+  normalVertexData = (const GLfloat*)cursor;
+  cursor += (size_t)fractal.normalVertexCount * Fractal::DIMENSIONS *
+            fractal.attributeCount * sizeof(GLfloat);
+
+  cursor = readTable(cursor, fractal.chunkMinHeights);
+  cursor = readTable(cursor, fractal.chunkMaxHeights);
+  cursor = readTable(cursor, fractal.chunkIndexOffsets);
+  cursor = readTable(cursor, fractal.chunkIndexCounts);
+  cursor = readTable(cursor, fractal.chunkLineOffsets);
+  cursor = readTable(cursor, fractal.chunkLineCounts);
+  cursor = readTable(cursor, fractal.lodIndexOffsets);
+  cursor = readTable(cursor, fractal.lodIndexCounts);
+  cursor = readTable(cursor, fractal.lodLineOffsets);
+  cursor = readTable(cursor, fractal.lodLineCounts);
+
+  // The heights are stored in rows, as they are left after generation.
+  fractal.heights.layout = HeightPlane::LINEAR;
+
+  if (fractal.heights.isQuantised) {
+    cursor = readTable(cursor, fractal.heights.quantisedHeights);
+  } else {
+    cursor = readTable(cursor, fractal.heights.heights);
+  }
+
+  fractal.totalIndexCount = header->totalIndexCount;
+
+  // Quantised vertices are scaled by the height range they were packed with.
+  fractal.heights.heightScale = header->heightScale;
+  fractal.heights.heightOffset = header->heightOffset;
+
+  return true;
+}
+
+/**
+ * Store the generated terrain of the fractal under the given key. The file is
+ * written under a temporary name and then renamed, so an interrupted write
+ * never leaves a partial file to be loaded. Failing to write the cache only
+ * means the terrain is generated again next time, so it is not fatal.
+ */
+GLvoid TerrainCache::save(GLuint64 key, Fractal& fractal)
+{
+  std::string path = getPath(key);
+  std::string temporaryPath = path + ".tmp";
+
+  mkdir(directory.c_str(), 0755);
+
+  std::ofstream file(temporaryPath.c_str(), std::ios::binary);
+
+  if (!file) {
+    fprintf(stderr, "unable to write terrain cache: %s\n", path.c_str());
+    return;
+  }
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, "FRAC", 4);
+  header.version = TERRAIN_CACHE_VERSION;
+  header.key = key;
+  header.vertexCount = fractal.vertexCount;
+  header.vertexStride = fractal.vertexStride;
+  header.totalIndexCount = fractal.totalIndexCount;
+  header.normalVertexCount = fractal.normalVertexCount;
+  header.chunkCount = fractal.chunkCount;
+  header.lodCount = fractal.lodCount;
+  header.heightScale = fractal.heights.heightScale;
+  header.heightOffset = fractal.heights.heightOffset;
+
+  const GLchar* vertices = fractal.isQuantised ?
+                           (const GLchar*)fractal.packedVertexData :
+                           (const GLchar*)fractal.vertexData;
+
+  file.write((const GLchar*)&header, sizeof(header));
+  file.write(vertices, (size_t)fractal.vertexCount * fractal.vertexStride);
+  file.write((const GLchar*)fractal.indexData,
+             (size_t)fractal.totalIndexCount * sizeof(GLuint));
+  file.write((const GLchar*)fractal.normalVertexData,
+             (size_t)fractal.normalVertexCount * Fractal::DIMENSIONS *
+             fractal.attributeCount * sizeof(GLfloat));
+
+  writeTable(file, fractal.chunkMinHeights);
+  writeTable(file, fractal.chunkMaxHeights);
+  writeTable(file, fractal.chunkIndexOffsets);
+  writeTable(file, fractal.chunkIndexCounts);
+  writeTable(file, fractal.chunkLineOffsets);
+  writeTable(file, fractal.chunkLineCounts);
+  writeTable(file, fractal.lodIndexOffsets);
+  writeTable(file, fractal.lodIndexCounts);
+  writeTable(file, fractal.lodLineOffsets);
+  writeTable(file, fractal.lodLineCounts);
+
+  if (fractal.heights.isQuantised) {
+    writeTable(file, fractal.heights.quantisedHeights);
+  } else {
+    writeTable(file, fractal.heights.heights);
+  }
+
+  file.close();
+
+  if (!file || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    fprintf(stderr, "unable to write terrain cache: %s\n", path.c_str());
+    remove(temporaryPath.c_str());
+  }
+}
+
+/**
+ * Check whether a cached terrain is currently mapped.
+ */
+GLuint TerrainCache::isMapped()
+{
+  return mapping != nullptr;
+}
+
+/**
+ * Release the mapping of the loaded terrain, once it has been uploaded.
+ */
+GLvoid TerrainCache::unmap()
+{
+  if (mapping != nullptr) {
+    munmap(mapping, mappingSize);
+  }
+
+  mapping = nullptr;
+  mappingSize = 0;
+  vertexData = nullptr;
+  indexData = nullptr;
+  normalVertexData = nullptr;
+}
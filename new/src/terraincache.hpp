@@ -0,0 +1,57 @@
+/**
+ * [Program description]
+ */
+
+#ifndef TERRAIN_CACHE_HEADER
+#define TERRAIN_CACHE_HEADER
+
+// Increase this whenever a change to the generation code alters its output,
+// so that terrains cached by older builds are no longer used.
+#define TERRAIN_CACHE_VERSION 4
+
+class TerrainCache
+{
+  public:
+    typedef struct {
+      GLchar magic[4];
+      GLuint version;
+      GLuint64 key;
+      GLuint vertexCount;
+      GLuint vertexStride;
+      GLuint totalIndexCount;
+      GLuint normalVertexCount;
+      GLuint chunkCount;
+      GLuint lodCount;
+      GLfloat heightScale;
+      GLfloat heightOffset;
+    } Header;
+
+    /**
+     * directory - directory the cached terrains are stored in
+     * mapping - memory mapping of the loaded cache file
+     * mappingSize - size of the memory mapping (in bytes)
+     *
+     * vertexData - vertex stream of the loaded terrain within the mapping
+     * indexData - index stream of the loaded terrain within the mapping
+     * normalVertexData - normal line stream of the loaded terrain
+     */
+    std::string directory;
+    GLvoid* mapping;
+    size_t mappingSize;
+
+    const GLvoid* vertexData;
+    const GLuint* indexData;
+    const GLfloat* normalVertexData;
+
+    TerrainCache(std::string desiredDirectory);
+    static GLuint64 hashParameters(
+                    const std::map<std::string, GLfloat>& env);
+    static size_t getFileSize(Fractal& fractal, GLuint totalIndexCount);
+    std::string getPath(GLuint64 key);
+    GLuint load(GLuint64 key, Fractal& fractal);
+    GLvoid save(GLuint64 key, Fractal& fractal);
+    GLuint isMapped();
+    GLvoid unmap();
+};
+
+#endif
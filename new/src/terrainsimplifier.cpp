@@ -0,0 +1,203 @@
+/**
+ * [Program description]
+ */
+
+#include "terrainsimplifier.hpp"
+
+/**
+ * Constructor to create a simplifier for square tiles of a given size.
+ *
+ * Tiles are simplified as a right-triangulated irregular network (RTIN), in
+ * the same way as Vladimir Agafonkin's MARTINI. The tile is split into two
+ * right triangles, and each triangle can be split in two across its longest
+ * edge until the triangles are the size of half a quad. The triangles of this
+ * hierarchy are numbered so that children always come after their parents,
+ * and the ends of each triangle's longest edge are precomputed here.
+ */
+TerrainSimplifier::TerrainSimplifier(GLuint desiredTileSize)
+{
+  tileSize = desiredTileSize;
+  gridSize = tileSize + 1;
+
+  GLuint triangleCount = tileSize * tileSize * 2 - 2;
+  triangleCoordinates = std::vector<GLushort>(triangleCount * 4);
+
+  for (GLuint i = 0; i < triangleCount; i++) {
+    GLuint id = i + 2;
+    GLint ax = 0, az = 0, bx = 0, bz = 0, cx = 0, cz = 0;
+
+    if (id & 1) {
+      bx = bz = cx = tileSize;
+    } else {
+      ax = az = cz = tileSize;
+    }
+
+    // Each remaining bit of the id picks the left or right child.
+    while ((id >>= 1) > 1) {
+      GLint mx = (ax + bx) >> 1;
+      GLint mz = (az + bz) >> 1;
+
+      if (id & 1) {
+        bx = ax;
+        bz = az;
+        ax = cx;
+        az = cz;
+      } else {
+        ax = bx;
+        az = bz;
+        bx = cx;
+        bz = cz;
+      }
+
+      cx = mx;
+      cz = mz;
+    }
+
+    triangleCoordinates[i * 4]     = ax;
+    triangleCoordinates[i * 4 + 1] = az;
+    triangleCoordinates[i * 4 + 2] = bx;
+    triangleCoordinates[i * 4 + 3] = bz;
+  }
+}
+
+/**
+ * Calculate the error of each vertex of a tile, given the heights of its
+ * vertices as [x * gridSize + z]. A vertex's error is the largest difference
+ * between a height and its interpolated height that would be introduced by
+ * merging the triangles which are split at that vertex, including the errors
+ * of any of their children which would have to be merged first.
+ *
+ * Unlike MARTINI, which only measures the error at the split vertex itself,
+ * every vertex covered by a triangle is measured against the triangle, so
+ * the error is a true bound on the error of the simplified tile.
+ *
+ * The vertices along the edges of the tile are given an infinite error, which
+ * locks the edges at full resolution so that tiles which are simplified
+ * separately still meet without cracks.
+ */
+std::vector<GLfloat> TerrainSimplifier::calculateErrors(
+                     std::vector<GLfloat>& heights)
+{
+  std::vector<GLfloat> errors(gridSize * gridSize, 0.0f);
+  GLuint triangleCount = triangleCoordinates.size() / 4;
+  GLuint parentCount = triangleCount - tileSize * tileSize;
+
+  for (GLuint i = 0; i < gridSize; i++) {
+    errors[i] = INFINITY;
+    errors[tileSize * gridSize + i] = INFINITY;
+    errors[i * gridSize] = INFINITY;
+    errors[i * gridSize + tileSize] = INFINITY;
+  }
+
+  // Work from the smallest triangles up to the largest.
+  for (GLint i = triangleCount - 1; i >= 0; i--) {
+    GLint ax = triangleCoordinates[i * 4];
+    GLint az = triangleCoordinates[i * 4 + 1];
+    GLint bx = triangleCoordinates[i * 4 + 2];
+    GLint bz = triangleCoordinates[i * 4 + 3];
+    GLint mx = (ax + bx) >> 1;
+    GLint mz = (az + bz) >> 1;
+    GLint cx = mx + mz - az;
+    GLint cz = mz + ax - mx;
+    GLuint middle = mx * gridSize + mz;
+
+    errors[middle] = std::max(errors[middle],
+                              getTriangleError(heights, ax, az, bx, bz,
+                                               cx, cz));
+
+    if (i < (GLint)parentCount) {
+      GLuint left = ((ax + cx) >> 1) * gridSize + ((az + cz) >> 1);
+      GLuint right = ((bx + cx) >> 1) * gridSize + ((bz + cz) >> 1);
+
+      errors[middle] = std::max(errors[middle],
+                                std::max(errors[left], errors[right]));
+    }
+  }
+
+  return errors;
+}
+
+/**
+ * Find the largest difference between the height of a vertex covered by a
+ * triangle and the height of the triangle at that vertex.
+ */
+GLfloat TerrainSimplifier::getTriangleError(std::vector<GLfloat>& heights,
+                                            GLint ax, GLint az,
+                                            GLint bx, GLint bz,
+                                            GLint cx, GLint cz)
+{
+  GLfloat ha = heights[ax * gridSize + az];
+  GLfloat hb = heights[bx * gridSize + bz];
+  GLfloat hc = heights[cx * gridSize + cz];
+  GLint area = (bx - ax) * (cz - az) - (bz - az) * (cx - ax);
+  GLfloat error = 0.0f;
+
+  for (GLint x = std::min(ax, std::min(bx, cx));
+       x <= std::max(ax, std::max(bx, cx)); x++) {
+    for (GLint z = std::min(az, std::min(bz, cz));
+         z <= std::max(az, std::max(bz, cz)); z++) {
+      // Weights of the corners at the vertex, which all have the sign of
+      // the area when the vertex is inside the triangle.
+      GLint wa = (bx - x) * (cz - z) - (bz - z) * (cx - x);
+      GLint wb = (cx - x) * (az - z) - (cz - z) * (ax - x);
+      GLint wc = area - wa - wb;
+
+      if (wa * area < 0 || wb * area < 0 || wc * area < 0) {
+        continue;
+      }
+
+      GLfloat interpolatedHeight = (wa * ha + wb * hb + wc * hc) / area;
+
+      error = std::max(error, fabsf(interpolatedHeight -
+                                    heights[x * gridSize + z]));
+    }
+  }
+
+  return error;
+}
+
+/**
+ * Triangulate a tile with as few triangles as possible while keeping every
+ * height within the given tolerance. Returns the triangles as triplets of
+ * vertices numbered [x * gridSize + z].
+ */
+std::vector<GLuint> TerrainSimplifier::simplifyTile(
+                    std::vector<GLfloat>& heights, GLfloat tolerance)
+{
+  std::vector<GLfloat> errors = calculateErrors(heights);
+  std::vector<GLuint> triangles;
+
+  addTriangles(errors, tolerance, 0, 0, tileSize, tileSize, tileSize, 0,
+               triangles);
+  addTriangles(errors, tolerance, tileSize, tileSize, 0, 0, 0, tileSize,
+               triangles);
+
+  return triangles;
+}
+
+/**
+ * Add a triangle of the hierarchy to the list of triangles, with A and B at
+ * the ends of its longest edge, or split it if merging it would exceed the
+ * tolerance. Since a vertex splits the triangles on both sides of an edge,
+ * neighbouring triangles are always split together and no cracks appear.
+ */
+GLvoid TerrainSimplifier::addTriangles(std::vector<GLfloat>& errors,
+                                       GLfloat tolerance,
+                                       GLint ax, GLint az, GLint bx, GLint bz,
+                                       GLint cx, GLint cz,
+                                       std::vector<GLuint>& triangles)
+{
+  GLint mx = (ax + bx) >> 1;
+  GLint mz = (az + bz) >> 1;
+
+  if (abs(ax - cx) + abs(az - cz) > 1 &&
+      errors[mx * gridSize + mz] > tolerance) {
+    addTriangles(errors, tolerance, cx, cz, ax, az, mx, mz, triangles);
+    addTriangles(errors, tolerance, bx, bz, cx, cz, mx, mz, triangles);
+    return;
+  }
+
+  triangles.push_back(ax * gridSize + az);
+  triangles.push_back(bx * gridSize + bz);
+  triangles.push_back(cx * gridSize + cz);
+}
@@ -0,0 +1,33 @@
+/**
+ * [Program description]
+ */
+
+#ifndef TERRAIN_SIMPLIFIER_HEADER
+#define TERRAIN_SIMPLIFIER_HEADER
+
+class TerrainSimplifier
+{
+  public:
+    /**
+     * tileSize - width/height of a tile (in quads, a power of two)
+     * gridSize - width/height of a tile (in vertices)
+     * triangleCoordinates - ends of the longest edge of every triangle in the
+     *                       tile's hierarchy, as [ax, az, bx, bz]
+     */
+    GLuint tileSize;
+    GLuint gridSize;
+    std::vector<GLushort> triangleCoordinates;
+
+    TerrainSimplifier(GLuint desiredTileSize);
+    std::vector<GLfloat> calculateErrors(std::vector<GLfloat>& heights);
+    GLfloat getTriangleError(std::vector<GLfloat>& heights,
+                             GLint ax, GLint az, GLint bx, GLint bz,
+                             GLint cx, GLint cz);
+    std::vector<GLuint> simplifyTile(std::vector<GLfloat>& heights,
+                                     GLfloat tolerance);
+    GLvoid addTriangles(std::vector<GLfloat>& errors, GLfloat tolerance,
+                        GLint ax, GLint az, GLint bx, GLint bz,
+                        GLint cx, GLint cz, std::vector<GLuint>& triangles);
+};
+
+#endif
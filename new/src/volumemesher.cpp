@@ -0,0 +1,396 @@
+/**
+ * [Program description]
+ */
+
+#include <float.h>
+#include <unordered_map>
+
+#include "volumemesher.hpp"
+
+// Corners at each end of a cell's edges, where corner c is at (c & 1,
+// (c >> 1) & 1, c >> 2). Edges 0-3 run along X, 4-7 along Y and 8-11 along Z.
+const GLubyte volumeEdgeCorners[12][2] = {
+  {0, 1}, {2, 3}, {4, 5}, {6, 7},
+  {0, 2}, {1, 3}, {4, 6}, {5, 7},
+  {0, 4}, {1, 5}, {2, 6}, {3, 7}
+};
+
+// Offsets of the points sampled around a vertex to find its normal.
+const GLfloat volumeNormalOffsets[4][3] = {
+  {1.0f, -1.0f, -1.0f}, {-1.0f, -1.0f, 1.0f},
+  {-1.0f, 1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}
+};
+
+std::vector<std::vector<GLubyte>> VolumeMesher::triangleTable;
+
+/**
+ * Constructor to create a mesher of the profile's 3D fractal, which turns its
+ * distance estimate into triangles with marching cubes.
+ */
+VolumeMesher::VolumeMesher(std::map<std::string, GLfloat>& env) :
+  estimator(env)
+{
+  resolution = std::max(env["volumeResolution"], 1.0f);
+  colour = glm::vec3(env["fractalColourRed"], env["fractalColourGreen"],
+                     env["fractalColourBlue"]);
+  minimum = -estimator.boundingRadius;
+  cellSize = 2.0f * estimator.boundingRadius / resolution;
+  isoLevel = 0.5f * cellSize;
+  vertexCount = 0;
+  triangleIndexCount = 0;
+  lineIndexCount = 0;
+  blockCount = 0;
+  meshedBlockCount = 0;
+
+  if (triangleTable.empty()) {
+    generateTriangleTable();
+  }
+}
+
+/**
+ * Mesh the surface of the fractal where its estimated distance is half a cell
+ * wide, since some estimates are never negative.
+ *
+ * The volume is split into blocks, which are handed out to the threads one at
+ * a time. Blocks which the distance estimate shows are too far from the
+ * surface are skipped after a single estimate, so only the blocks along the
+ * surface are sampled in full. The blocks' meshes are joined in order
+ * afterwards, so the mesh is the same however many threads made it. The
+ * triangles are followed by their edges as lines, for the wireframe.
+ */
+GLvoid VolumeMesher::generate()
+{
+  GLuint blocksPerSide = (resolution + VOLUME_BLOCK_SIZE - 1) /
+                         VOLUME_BLOCK_SIZE;
+  std::vector<BlockMesh> meshes(blocksPerSide * blocksPerSide *
+                                blocksPerSide);
+  std::atomic<GLuint> meshedCount(0);
+
+  blockCount = meshes.size();
+
+  runInParallel(blockCount, [&](GLuint block) {
+    meshedCount += meshBlock(block, meshes[block]);
+  });
+
+  meshedBlockCount = meshedCount;
+  vertexCount = 0;
+  triangleIndexCount = 0;
+
+  for (GLuint i = 0; i < blockCount; i++) {
+    vertexCount += meshes[i].vertexData.size() / VOLUME_VERTEX_SIZE;
+    triangleIndexCount += meshes[i].indexData.size();
+  }
+
+  lineIndexCount = triangleIndexCount * 2;
+  vertexData.clear();
+  vertexData.reserve(vertexCount * VOLUME_VERTEX_SIZE);
+  indexData = std::vector<GLuint>(triangleIndexCount + lineIndexCount);
+
+  GLuint vertexOffset = 0;
+  GLuint* triangles = indexData.data();
+  GLuint* lines = triangles + triangleIndexCount;
+
+  for (GLuint i = 0; i < blockCount; i++) {
+    std::vector<GLuint>& blockIndices = meshes[i].indexData;
+
+    vertexData.insert(vertexData.end(), meshes[i].vertexData.begin(),
+                      meshes[i].vertexData.end());
+
+    for (GLuint j = 0; j < blockIndices.size(); j += 3) {
+      for (GLuint k = 0; k < 3; k++) {
+        *triangles++ = blockIndices[j + k] + vertexOffset;
+        *lines++ = blockIndices[j + k] + vertexOffset;
+        *lines++ = blockIndices[j + (k + 1) % 3] + vertexOffset;
+      }
+    }
+
+    vertexOffset += meshes[i].vertexData.size() / VOLUME_VERTEX_SIZE;
+  }
+}
+
+/**
+ * Mesh one block of cells, unless it's too far from the surface, and return
+ * whether it was meshed.
+ *
+ * The distances at the corners of the block's cells are estimated a packet
+ * at a time. Neighbouring cells share the vertices on their shared edges,
+ * which are looked up by edge in a hash table kept for the block. The normal
+ * of each vertex is the gradient of the distance estimate around it.
+ */
+GLuint VolumeMesher::meshBlock(GLuint block, BlockMesh& mesh)
+{
+  GLuint blocksPerSide = (resolution + VOLUME_BLOCK_SIZE - 1) /
+                         VOLUME_BLOCK_SIZE;
+  GLuint starts[3], counts[3];
+  glm::vec3 centre;
+  GLfloat halfDiagonal2 = 0.0f;
+
+  starts[0] = block % blocksPerSide * VOLUME_BLOCK_SIZE;
+  starts[1] = block / blocksPerSide % blocksPerSide * VOLUME_BLOCK_SIZE;
+  starts[2] = block / (blocksPerSide * blocksPerSide) * VOLUME_BLOCK_SIZE;
+
+  for (GLuint axis = 0; axis < 3; axis++) {
+    counts[axis] = std::min(resolution - starts[axis],
+                            (GLuint)VOLUME_BLOCK_SIZE);
+    centre[axis] = minimum + (starts[axis] + counts[axis] / 2.0f) * cellSize;
+    halfDiagonal2 += powf(counts[axis] * cellSize / 2.0f, 2.0f);
+  }
+
+  // The surface can't pass through a block further from the fractal than the
+  // distance from the block's centre to its corners, allowing for estimates
+  // which are a little too far.
+  if (estimator.getDistance(centre) - isoLevel >
+      sqrtf(halfDiagonal2) * VOLUME_CULL_MARGIN) {
+    return false;
+  }
+
+  GLuint sizeX = counts[0] + 1, sizeY = counts[1] + 1, sizeZ = counts[2] + 1;
+  GLuint sampleCount = sizeX * sizeY * sizeZ;
+  std::vector<GLfloat> xs(sampleCount), ys(sampleCount), zs(sampleCount);
+  std::vector<GLfloat> distances(sampleCount);
+
+  for (GLuint z = 0, i = 0; z < sizeZ; z++) {
+    for (GLuint y = 0; y < sizeY; y++) {
+      for (GLuint x = 0; x < sizeX; x++, i++) {
+        xs[i] = minimum + (starts[0] + x) * cellSize;
+        ys[i] = minimum + (starts[1] + y) * cellSize;
+        zs[i] = minimum + (starts[2] + z) * cellSize;
+      }
+    }
+  }
+
+  estimator.getDistances(xs.data(), ys.data(), zs.data(), distances.data(),
+                         sampleCount);
+
+  std::unordered_map<GLuint, GLuint> vertexIndices;
+  std::vector<GLfloat> vertexXs, vertexYs, vertexZs;
+  GLuint cornerOffsets[8];
+
+  for (GLuint corner = 0; corner < 8; corner++) {
+    cornerOffsets[corner] = (corner & 1) + ((corner >> 1) & 1) * sizeX +
+                            (corner >> 2) * sizeX * sizeY;
+  }
+
+  for (GLuint z = 0; z < counts[2]; z++) {
+    for (GLuint y = 0; y < counts[1]; y++) {
+      for (GLuint x = 0; x < counts[0]; x++) {
+        GLuint cell = (z * sizeY + y) * sizeX + x;
+        GLuint configuration = 0;
+
+        for (GLuint corner = 0; corner < 8; corner++) {
+          configuration |= (distances[cell + cornerOffsets[corner]] <
+                            isoLevel) << corner;
+        }
+
+        const std::vector<GLubyte>& edges = triangleTable[configuration];
+
+        for (GLuint i = 0; i < edges.size(); i++) {
+          GLuint start = cell + cornerOffsets[volumeEdgeCorners[edges[i]][0]];
+          GLuint end = cell + cornerOffsets[volumeEdgeCorners[edges[i]][1]];
+          GLuint key = start * 3 + edges[i] / 4;
+          auto found = vertexIndices.find(key);
+
+          if (found != vertexIndices.end()) {
+            mesh.indexData.push_back(found->second);
+            continue;
+          }
+
+          GLfloat t = (isoLevel - distances[start]) /
+                      (distances[end] - distances[start]);
+          GLuint index = vertexXs.size();
+
+          vertexXs.push_back(xs[start] + t * (xs[end] - xs[start]));
+          vertexYs.push_back(ys[start] + t * (ys[end] - ys[start]));
+          vertexZs.push_back(zs[start] + t * (zs[end] - zs[start]));
+          vertexIndices[key] = index;
+          mesh.indexData.push_back(index);
+        }
+      }
+    }
+  }
+
+  GLuint meshVertexCount = vertexXs.size();
+  std::vector<glm::vec3> normals(meshVertexCount, glm::vec3(0.0f));
+  GLfloat offset = 0.5f * cellSize;
+
+  if (meshVertexCount > sampleCount) {
+    xs.resize(meshVertexCount);
+    ys.resize(meshVertexCount);
+    zs.resize(meshVertexCount);
+    distances.resize(meshVertexCount);
+  }
+
+  for (GLuint j = 0; j < 4; j++) {
+    for (GLuint i = 0; i < meshVertexCount; i++) {
+      xs[i] = vertexXs[i] + volumeNormalOffsets[j][0] * offset;
+      ys[i] = vertexYs[i] + volumeNormalOffsets[j][1] * offset;
+      zs[i] = vertexZs[i] + volumeNormalOffsets[j][2] * offset;
+    }
+
+    estimator.getDistances(xs.data(), ys.data(), zs.data(), distances.data(),
+                           meshVertexCount);
+
+    for (GLuint i = 0; i < meshVertexCount; i++) {
+      normals[i] += distances[i] * glm::vec3(volumeNormalOffsets[j][0],
+                                             volumeNormalOffsets[j][1],
+                                             volumeNormalOffsets[j][2]);
+    }
+  }
+
+  mesh.vertexData.reserve(meshVertexCount * VOLUME_VERTEX_SIZE);
+
+  // Where the distances are the same on every side there is no gradient, so
+  // the vertex faces up instead.
+  for (GLuint i = 0; i < meshVertexCount; i++) {
+    glm::vec3 normal = glm::vec3(0.0f, 1.0f, 0.0f);
+
+    if (glm::dot(normals[i], normals[i]) > FLT_MIN) {
+      normal = glm::normalize(normals[i]);
+    }
+
+    GLfloat vertex[VOLUME_VERTEX_SIZE] = {
+      vertexXs[i], vertexYs[i], vertexZs[i],
+      normal.x, normal.y, normal.z,
+      colour.r, colour.g, colour.b
+    };
+
+    mesh.vertexData.insert(mesh.vertexData.end(), vertex,
+                           vertex + VOLUME_VERTEX_SIZE);
+  }
+
+  return true;
+}
+
+/**
+ * Generate the triangles of every configuration of a cell's corners being
+ * inside or outside the surface, rather than copying the usual table.
+ *
+ * Each face of the cell which the surface crosses gets a line from one
+ * crossed edge to another. A face with all four edges crossed has its inside
+ * corners cut off separately, and since the neighbouring cell makes the same
+ * choice for the face, the mesh has no holes. The lines of the faces join up
+ * into loops around the cell, which are turned to face out of the surface and
+ * split into fans of triangles.
+ */
+GLvoid VolumeMesher::generateTriangleTable()
+{
+  triangleTable = std::vector<std::vector<GLubyte>>(256);
+
+  for (GLuint configuration = 0; configuration < 256; configuration++) {
+    GLint links[12][2];
+    GLuint linkCounts[12] = {0};
+
+    auto isInside = [configuration](GLuint corner) {
+      return (configuration >> corner) & 1;
+    };
+    auto getEdge = [](GLuint a, GLuint b) {
+      for (GLuint edge = 0; edge < 12; edge++) {
+        if ((volumeEdgeCorners[edge][0] == a &&
+             volumeEdgeCorners[edge][1] == b) ||
+            (volumeEdgeCorners[edge][0] == b &&
+             volumeEdgeCorners[edge][1] == a)) {
+          return edge;
+        }
+      }
+
+      return 0u;
+    };
+    auto link = [&links, &linkCounts](GLuint a, GLuint b) {
+      links[a][linkCounts[a]++] = b;
+      links[b][linkCounts[b]++] = a;
+    };
+
+    // Link the crossed edges of each face, with its corners in order around
+    // the face.
+    for (GLuint axis = 0; axis < 3; axis++) {
+      for (GLuint side = 0; side < 2; side++) {
+        GLuint u = (axis + 1) % 3, v = (axis + 2) % 3;
+        GLuint corners[4] = {
+          side << axis, side << axis | 1u << u,
+          side << axis | 1u << u | 1u << v, side << axis | 1u << v
+        };
+        GLint crossed[4];
+        GLuint crossedCount = 0;
+
+        for (GLuint i = 0; i < 4; i++) {
+          GLuint a = corners[i], b = corners[(i + 1) % 4];
+
+          crossed[i] = (isInside(a) != isInside(b)) ? getEdge(a, b) : -1;
+          crossedCount += crossed[i] >= 0;
+        }
+
+        if (crossedCount == 4) {
+          for (GLuint i = 0; i < 4; i++) {
+            if (isInside(corners[i])) {
+              link(crossed[(i + 3) % 4], crossed[i]);
+            }
+          }
+        } else if (crossedCount == 2) {
+          GLint ends[2], endCount = 0;
+
+          for (GLuint i = 0; i < 4; i++) {
+            if (crossed[i] >= 0) {
+              ends[endCount++] = crossed[i];
+            }
+          }
+
+          link(ends[0], ends[1]);
+        }
+      }
+    }
+
+    // Follow the links around each loop of crossed edges.
+    GLuint isVisited[12] = {0};
+
+    for (GLuint first = 0; first < 12; first++) {
+      if (linkCounts[first] == 0 || isVisited[first]) {
+        continue;
+      }
+
+      std::vector<GLubyte> loop;
+      GLint previous = -1, edge = first;
+
+      while (!isVisited[edge]) {
+        isVisited[edge] = true;
+        loop.push_back(edge);
+
+        GLint next = (links[edge][0] != previous) ? links[edge][0] :
+                                                    links[edge][1];
+        previous = edge;
+        edge = next;
+      }
+
+      // Turn the loop to face from the inside corners to the outside ones.
+      glm::vec3 area(0.0f), outward(0.0f);
+
+      for (GLuint i = 0; i < loop.size(); i++) {
+        glm::vec3 points[2];
+
+        for (GLuint j = 0; j < 2; j++) {
+          GLuint e = loop[(i + j) % loop.size()];
+          GLuint a = volumeEdgeCorners[e][0], b = volumeEdgeCorners[e][1];
+          glm::vec3 cornerA(a & 1, (a >> 1) & 1, a >> 2);
+          glm::vec3 cornerB(b & 1, (b >> 1) & 1, b >> 2);
+
+          points[j] = 0.5f * (cornerA + cornerB);
+
+          if (j == 0) {
+            outward += isInside(a) ? cornerB - cornerA : cornerA - cornerB;
+          }
+        }
+
+        area += glm::cross(points[0], points[1]);
+      }
+
+      if (glm::dot(area, outward) < 0.0f) {
+        std::reverse(loop.begin(), loop.end());
+      }
+
+      for (GLuint i = 1; i + 1 < loop.size(); i++) {
+        triangleTable[configuration].push_back(loop[0]);
+        triangleTable[configuration].push_back(loop[i]);
+        triangleTable[configuration].push_back(loop[i + 1]);
+      }
+    }
+  }
+}
@@ -0,0 +1,67 @@
+/**
+ * [Program description]
+ */
+
+#ifndef VOLUME_MESHER_HEADER
+#define VOLUME_MESHER_HEADER
+
+// Width/height/depth of the blocks of cells meshed by each thread.
+#define VOLUME_BLOCK_SIZE 16
+
+// Number of floats per vertex, as [position, normal, colour].
+#define VOLUME_VERTEX_SIZE 9
+
+// Factor the distance from a block's centre to its corners is scaled by before
+// the block is skipped as too far from the surface.
+#define VOLUME_CULL_MARGIN 1.25f
+
+class VolumeMesher
+{
+  public:
+    typedef struct {
+      std::vector<GLfloat> vertexData;
+      std::vector<GLuint> indexData;
+    } BlockMesh;
+
+    /**
+     * estimator - distance estimator of the fractal
+     * resolution - number of cells along each side of the volume
+     * colour - colour of the vertices
+     * minimum - position of the volume's lowest corner along each axis
+     * cellSize - width of a cell
+     * isoLevel - estimated distance at which the surface is drawn
+     *
+     * vertexData - vertices of the mesh as [position, normal, colour]
+     * indexData - triangles of the mesh, followed by its lines
+     * vertexCount - number of vertices
+     * triangleIndexCount - number of indices of the triangles
+     * lineIndexCount - number of indices of the lines
+     * blockCount - number of blocks in the volume
+     * meshedBlockCount - number of blocks near enough the surface to mesh
+     *
+     * triangleTable - edges of the triangles of each cell configuration
+     */
+    DistanceEstimator estimator;
+    GLuint resolution;
+    glm::vec3 colour;
+    GLfloat minimum;
+    GLfloat cellSize;
+    GLfloat isoLevel;
+
+    std::vector<GLfloat> vertexData;
+    std::vector<GLuint> indexData;
+    GLuint vertexCount;
+    GLuint triangleIndexCount;
+    GLuint lineIndexCount;
+    GLuint blockCount;
+    GLuint meshedBlockCount;
+
+    static std::vector<std::vector<GLubyte>> triangleTable;
+
+    VolumeMesher(std::map<std::string, GLfloat>& env);
+    GLvoid generate();
+    GLuint meshBlock(GLuint block, BlockMesh& mesh);
+    static GLvoid generateTriangleTable();
+};
+
+#endif
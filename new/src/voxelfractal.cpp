@@ -0,0 +1,468 @@
+/**
+ * [Program description]
+ */
+
+#include <array>
+
+#include "voxelfractal.hpp"
+
+/**
+ * Constructor to create the profile's voxel fractal. Every level of a
+ * self-similar fractal is made of copies of the level below it, so the DAG
+ * has a single node for each level, however many voxels the fractal has.
+ */
+VoxelFractal::VoxelFractal(std::map<std::string, GLfloat>& env)
+{
+  Node empty, solid;
+
+  type = (Type)std::min((GLuint)env["voxelType"], (GLuint)CANTOR_CUBE);
+  levelCount = std::min(std::max(env["voxelLevelCount"], 1.0f),
+                        (GLfloat)VOXEL_LEVEL_LIMIT);
+  detail = env["voxelDetail"];
+  chunkLimit = std::max(env["voxelChunkLimit"], 1.0f);
+  colour = glm::vec3(env["fractalColourRed"], env["fractalColourGreen"],
+                     env["fractalColourBlue"]);
+  vertexCount = 0;
+  triangleIndexCount = 0;
+  lineIndexCount = 0;
+  chunkCount = 0;
+  quadCount = 0;
+
+  // The solid node is its own child, so it can be divided any number of
+  // times.
+  for (GLuint i = 0; i < 27; i++) {
+    empty.children[i] = VOXEL_EMPTY_NODE;
+    solid.children[i] = VOXEL_SOLID_NODE;
+  }
+
+  empty.height = 0;
+  solid.height = 0;
+  addNode(empty);
+  root = addNode(solid);
+
+  for (GLuint level = 1; level <= levelCount; level++) {
+    Node node;
+
+    node.height = level;
+
+    for (GLuint i = 0; i < 27; i++) {
+      GLuint middleCount = (i % 3 == 1) + (i / 3 % 3 == 1) + (i / 9 == 1);
+      GLuint isKept = (type == MENGER_SPONGE) ? middleCount <= 1 :
+                                                middleCount == 0;
+
+      node.children[i] = isKept ? root : VOXEL_EMPTY_NODE;
+    }
+
+    root = addNode(node);
+  }
+}
+
+/**
+ * Get the name of a type of voxel fractal.
+ */
+const GLchar* VoxelFractal::getName(GLuint type)
+{
+  const GLchar* names[] = {"Menger sponge", "Cantor cube"};
+
+  return names[std::min(type, (GLuint)CANTOR_CUBE)];
+}
+
+/**
+ * Add a node to the DAG, unless a node with the same children already exists,
+ * and return its index.
+ */
+GLuint VoxelFractal::addNode(const Node& node)
+{
+  std::vector<GLuint> key(node.children, node.children + 27);
+  auto found = nodeIndices.find(key);
+
+  if (found != nodeIndices.end()) {
+    return found->second;
+  }
+
+  nodes.push_back(node);
+  nodeIndices[key] = nodes.size() - 1;
+
+  return nodes.size() - 1;
+}
+
+/**
+ * Get the node at a position among the 3^depth nodes along each side of the
+ * fractal, which is empty outside the fractal.
+ */
+GLuint VoxelFractal::getNode(GLuint depth, GLint x, GLint y, GLint z)
+{
+  GLint size = 1;
+
+  for (GLuint level = 0; level < depth; level++) {
+    size *= 3;
+  }
+
+  if (x < 0 || y < 0 || z < 0 || x >= size || y >= size || z >= size) {
+    return VOXEL_EMPTY_NODE;
+  }
+
+  GLuint node = root;
+
+  for (size /= 3; size > 0 && node > VOXEL_SOLID_NODE; size /= 3) {
+    node = nodes[node].children[x / size % 3 + 3 * (y / size % 3) +
+                                9 * (z / size % 3)];
+  }
+
+  return node;
+}
+
+/**
+ * Mesh the fractal as seen from a position, in the cube from -1 to 1.
+ *
+ * The fractal is split into chunks from the top of the DAG down, always
+ * splitting the chunk whose voxels look largest from the position, until
+ * every chunk's voxels look smaller than the detail or the chunk limit is
+ * reached. The number of chunks, and so the size of the mesh, is bounded
+ * however many levels the fractal has, and far chunks are drawn with coarser
+ * voxels than near ones.
+ *
+ * A chunk's mesh only depends on its node and its neighbours' nodes, which a
+ * self-similar fractal has few combinations of. The meshes are kept in voxel
+ * units, so each combination is only meshed once, and the threads mesh the
+ * new combinations one at a time.
+ */
+GLvoid VoxelFractal::generate(glm::vec3 viewPosition)
+{
+  std::vector<Chunk> queue, chunks;
+  GLuint selectedCount = 1;
+
+  auto isLower = [](const Chunk& a, const Chunk& b) {
+    return a.priority < b.priority;
+  };
+  auto createChunk = [&](GLuint node, GLuint depth, GLint x, GLint y,
+                         GLint z) {
+    Chunk chunk = {0.0f, node, depth, 0, x, y, z};
+    GLuint levels = std::min(nodes[node].height, (GLuint)VOXEL_CHUNK_LEVELS);
+    GLfloat size = 2.0f / powf(3.0f, depth);
+    glm::vec3 centre = glm::vec3(-1.0f) +
+                       (glm::vec3(x, y, z) + glm::vec3(0.5f)) * size;
+    GLfloat distance = glm::length(centre - viewPosition) -
+                       size * sqrtf(3.0f) / 2.0f;
+    GLfloat angle = size / std::max(distance, 1e-6f);
+
+    // Use as few levels as give voxels smaller than the detail, which the
+    // chunk's children would need to improve on.
+    while (chunk.levels < levels && angle > detail) {
+      chunk.levels++;
+      angle /= 3.0f;
+    }
+
+    chunk.priority = angle;
+
+    return chunk;
+  };
+
+  queue.push_back(createChunk(root, 0, 0, 0, 0));
+
+  while (!queue.empty()) {
+    std::pop_heap(queue.begin(), queue.end(), isLower);
+
+    Chunk chunk = queue.back();
+    Node& node = nodes[chunk.node];
+    GLuint childCount = 0;
+
+    queue.pop_back();
+
+    for (GLuint i = 0; i < 27; i++) {
+      childCount += node.children[i] != VOXEL_EMPTY_NODE;
+    }
+
+    if (node.height <= VOXEL_CHUNK_LEVELS || chunk.priority <= detail ||
+        selectedCount - 1 + childCount > chunkLimit) {
+      chunks.push_back(chunk);
+      continue;
+    }
+
+    for (GLuint i = 0; i < 27; i++) {
+      if (node.children[i] != VOXEL_EMPTY_NODE) {
+        queue.push_back(createChunk(node.children[i], chunk.depth + 1,
+                                    chunk.x * 3 + i % 3,
+                                    chunk.y * 3 + i / 3 % 3,
+                                    chunk.z * 3 + i / 9));
+        std::push_heap(queue.begin(), queue.end(), isLower);
+      }
+    }
+
+    selectedCount += childCount - 1;
+  }
+
+  // Find the depth of the voxels each chunk is drawn with, by its position.
+  std::map<std::array<GLint, 4>, GLuint> voxelDepths;
+
+  for (Chunk& chunk : chunks) {
+    voxelDepths[{{(GLint)chunk.depth, chunk.x, chunk.y, chunk.z}}] =
+      chunk.depth + chunk.levels;
+  }
+
+  // Get the depth of the voxels drawn at a position, from the chunk which
+  // holds it, or zero if it's split between smaller chunks.
+  auto getVoxelDepth = [&](GLint depth, GLint x, GLint y, GLint z) {
+    for (; depth >= 0; depth--, x /= 3, y /= 3, z /= 3) {
+      auto found = voxelDepths.find({{depth, x, y, z}});
+
+      if (found != voxelDepths.end()) {
+        return found->second;
+      }
+    }
+
+    return 0u;
+  };
+
+  // Find the chunks' keys, and the keys which haven't been meshed yet.
+  std::vector<ChunkKey> keys(chunks.size());
+  std::vector<ChunkKey> newKeys;
+  std::vector<ChunkMesh*> newMeshes;
+
+  for (GLuint i = 0; i < chunks.size(); i++) {
+    Chunk& chunk = chunks[i];
+
+    keys[i][0] = chunk.node;
+    keys[i][7] = chunk.levels;
+    keys[i][8] = 0;
+
+    for (GLuint j = 0; j < 6; j++) {
+      GLint cell[3] = {chunk.x, chunk.y, chunk.z};
+
+      cell[j / 2] += (j % 2) ? 1 : -1;
+      keys[i][j + 1] = getNode(chunk.depth, cell[0], cell[1], cell[2]);
+
+      if (keys[i][j + 1] > VOXEL_SOLID_NODE &&
+          getVoxelDepth(chunk.depth, cell[0], cell[1], cell[2]) !=
+          chunk.depth + chunk.levels) {
+        keys[i][8] |= 1 << j;
+      }
+    }
+
+    if (chunkMeshes.find(keys[i]) == chunkMeshes.end()) {
+      newKeys.push_back(keys[i]);
+      newMeshes.push_back(&chunkMeshes[keys[i]]);
+    }
+  }
+
+  runInParallel(newKeys.size(), [&](GLuint key) {
+    meshChunk(newKeys[key], *newMeshes[key]);
+  });
+
+  // Place the chunks' meshes in the fractal, with the triangles of every
+  // chunk before the lines.
+  std::vector<ChunkMesh*> meshes(chunks.size());
+
+  vertexCount = 0;
+  triangleIndexCount = 0;
+  lineIndexCount = 0;
+  chunkCount = chunks.size();
+
+  for (GLuint i = 0; i < chunkCount; i++) {
+    meshes[i] = &chunkMeshes[keys[i]];
+    vertexCount += meshes[i]->vertexData.size() / VOXEL_VERTEX_SIZE;
+    triangleIndexCount += meshes[i]->triangleIndices.size();
+    lineIndexCount += meshes[i]->lineIndices.size();
+  }
+
+  quadCount = triangleIndexCount / 6;
+  vertexData = std::vector<GLfloat>(vertexCount * VOXEL_VERTEX_SIZE);
+  indexData = std::vector<GLuint>(triangleIndexCount + lineIndexCount);
+
+  GLfloat* vertex = vertexData.data();
+  GLuint* triangles = indexData.data();
+  GLuint* lines = triangles + triangleIndexCount;
+  GLuint vertexOffset = 0;
+
+  for (GLuint i = 0; i < chunkCount; i++) {
+    Chunk& chunk = chunks[i];
+    ChunkMesh& mesh = *meshes[i];
+    GLfloat size = 2.0f / powf(3.0f, chunk.depth);
+    GLfloat voxelSize = size / powf(3.0f, chunk.levels);
+    glm::vec3 origin = glm::vec3(-1.0f) +
+                       glm::vec3(chunk.x, chunk.y, chunk.z) * size;
+
+    for (GLuint j = 0; j < mesh.vertexData.size(); j += VOXEL_VERTEX_SIZE) {
+      for (GLuint k = 0; k < 3; k++) {
+        *vertex++ = origin[k] + mesh.vertexData[j + k] * voxelSize;
+      }
+      for (GLuint k = 3; k < VOXEL_VERTEX_SIZE; k++) {
+        *vertex++ = mesh.vertexData[j + k];
+      }
+    }
+
+    for (GLuint j = 0; j < mesh.triangleIndices.size(); j++) {
+      *triangles++ = mesh.triangleIndices[j] + vertexOffset;
+    }
+    for (GLuint j = 0; j < mesh.lineIndices.size(); j++) {
+      *lines++ = mesh.lineIndices[j] + vertexOffset;
+    }
+
+    vertexOffset += mesh.vertexData.size() / VOXEL_VERTEX_SIZE;
+  }
+}
+
+/**
+ * Mesh a chunk's exposed faces, in voxel units.
+ *
+ * The chunk's voxels are drawn into a grid along with a layer of its
+ * neighbours' voxels, so the faces which meet a neighbour are hidden. A
+ * neighbour drawn with voxels of another size only hides the faces it's
+ * completely solid behind, as its own voxels may leave the rest open. Each
+ * slice of the grid along each axis has its exposed faces merged into as few
+ * rectangles as it can, by growing each rectangle along a row and then
+ * across the rows (greedy meshing).
+ */
+GLvoid VoxelFractal::meshChunk(const ChunkKey& key, ChunkMesh& mesh)
+{
+  GLint size = 1;
+
+  for (GLuint level = 0; level < key[7]; level++) {
+    size *= 3;
+  }
+
+  GLint gridSize = size + 2;
+  std::vector<GLubyte> grid(gridSize * gridSize * gridSize, 0);
+  std::vector<GLubyte> mask(size * size);
+
+  rasterise(key[0], 1, 1, 1, size, true, grid, gridSize);
+
+  for (GLuint i = 0; i < 6; i++) {
+    GLint origin[3] = {1, 1, 1};
+
+    origin[i / 2] += (i % 2) ? size : -size;
+    rasterise(key[i + 1], origin[0], origin[1], origin[2], size,
+              !(key[8] >> i & 1), grid, gridSize);
+  }
+
+  auto isSolid = [&](const GLint* cell) {
+    return grid[(cell[0] + 1) + ((cell[1] + 1) + (cell[2] + 1) * gridSize) *
+                gridSize];
+  };
+
+  for (GLint axis = 0; axis < 3; axis++) {
+    GLint u = (axis + 1) % 3, v = (axis + 2) % 3;
+
+    for (GLint side = 0; side < 2; side++) {
+      GLint sign = side ? 1 : -1;
+
+      for (GLint slice = 0; slice < size; slice++) {
+        for (GLint k = 0; k < size; k++) {
+          for (GLint j = 0; j < size; j++) {
+            GLint cell[3];
+
+            cell[axis] = slice;
+            cell[u] = j;
+            cell[v] = k;
+
+            GLuint isFilled = isSolid(cell);
+
+            cell[axis] += sign;
+            mask[k * size + j] = isFilled && !isSolid(cell);
+          }
+        }
+
+        for (GLint k = 0; k < size; k++) {
+          for (GLint j = 0; j < size; j++) {
+            if (!mask[k * size + j]) {
+              continue;
+            }
+
+            GLint width = 1, height = 1;
+
+            while (j + width < size && mask[k * size + j + width]) {
+              width++;
+            }
+
+            for (; k + height < size; height++) {
+              GLuint isRowFilled = true;
+
+              for (GLint i = 0; i < width && isRowFilled; i++) {
+                isRowFilled = mask[(k + height) * size + j + i];
+              }
+
+              if (!isRowFilled) {
+                break;
+              }
+            }
+
+            for (GLint y = 0; y < height; y++) {
+              memset(&mask[(k + y) * size + j], 0, width);
+            }
+
+            // Add the rectangle as a quad facing out of the voxels.
+            GLuint first = mesh.vertexData.size() / VOXEL_VERTEX_SIZE;
+            GLuint order[6] = {0, 1, 2, 0, 2, 3};
+
+            for (GLint corner = 0; corner < 4; corner++) {
+              GLfloat vertex[VOXEL_VERTEX_SIZE] = {
+                0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+                colour.r, colour.g, colour.b
+              };
+
+              vertex[axis] = slice + side;
+              vertex[u] = j + (corner == 1 || corner == 2) * width;
+              vertex[v] = k + (corner >= 2) * height;
+              vertex[3 + axis] = sign;
+              mesh.vertexData.insert(mesh.vertexData.end(), vertex,
+                                     vertex + VOXEL_VERTEX_SIZE);
+            }
+
+            if (!side) {
+              std::swap(order[1], order[2]);
+              std::swap(order[4], order[5]);
+            }
+
+            for (GLuint i = 0; i < 6; i++) {
+              mesh.triangleIndices.push_back(first + order[i]);
+            }
+            for (GLuint i = 0; i < 4; i++) {
+              mesh.lineIndices.push_back(first + i);
+              mesh.lineIndices.push_back(first + (i + 1) % 4);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Fill the voxels of a node into the part of a grid it covers, where the
+ * node is size voxels wide and its lowest corner is at (x, y, z). A node
+ * smaller than a voxel fills the voxel if it's solid, or if it's only partly
+ * solid and isPartFilled is set.
+ */
+GLvoid VoxelFractal::rasterise(GLuint node, GLint x, GLint y, GLint z,
+                               GLint size, GLuint isPartFilled,
+                               std::vector<GLubyte>& grid, GLint gridSize)
+{
+  if (node == VOXEL_EMPTY_NODE || x >= gridSize || y >= gridSize ||
+      z >= gridSize || x + size <= 0 || y + size <= 0 || z + size <= 0) {
+    return;
+  }
+
+  if (size == 1 && node != VOXEL_SOLID_NODE && !isPartFilled) {
+    return;
+  }
+
+  if (node == VOXEL_SOLID_NODE || size == 1) {
+    for (GLint k = std::max(z, 0); k < std::min(z + size, gridSize); k++) {
+      for (GLint j = std::max(y, 0); j < std::min(y + size, gridSize); j++) {
+        for (GLint i = std::max(x, 0); i < std::min(x + size, gridSize); i++) {
+          grid[i + (j + k * gridSize) * gridSize] = true;
+        }
+      }
+    }
+
+    return;
+  }
+
+  GLint childSize = size / 3;
+
+  for (GLuint i = 0; i < 27; i++) {
+    rasterise(nodes[node].children[i], x + i % 3 * childSize,
+              y + i / 3 % 3 * childSize, z + i / 9 * childSize, childSize,
+              isPartFilled, grid, gridSize);
+  }
+}
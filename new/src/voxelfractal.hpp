@@ -0,0 +1,106 @@
+/**
+ * [Program description]
+ */
+
+#ifndef VOXEL_FRACTAL_HEADER
+#define VOXEL_FRACTAL_HEADER
+
+// Number of levels of the fractal meshed together as a chunk, so a chunk is
+// up to 9 voxels wide.
+#define VOXEL_CHUNK_LEVELS 2
+
+// Largest number of levels, so that the voxels along each side can be
+// counted by a GLint.
+#define VOXEL_LEVEL_LIMIT 19
+
+// Number of floats per vertex, as [position, normal, colour].
+#define VOXEL_VERTEX_SIZE 9
+
+// Nodes of the voxel DAG which are empty and completely solid.
+#define VOXEL_EMPTY_NODE 0
+#define VOXEL_SOLID_NODE 1
+
+class VoxelFractal
+{
+  public:
+    typedef enum {
+      MENGER_SPONGE,
+      CANTOR_CUBE
+    } Type;
+
+    // Children of a node, indexed by x + 3y + 9z, and its number of levels.
+    typedef struct {
+      GLuint children[27];
+      GLuint height;
+    } Node;
+
+    // Chunk of the fractal to be meshed, as a node, its six neighbours, the
+    // number of levels of voxels it's meshed with, and a bit for each
+    // neighbour which is drawn with voxels of another size.
+    typedef std::array<GLuint, 9> ChunkKey;
+
+    typedef struct {
+      std::vector<GLfloat> vertexData;
+      std::vector<GLuint> triangleIndices;
+      std::vector<GLuint> lineIndices;
+    } ChunkMesh;
+
+    typedef struct {
+      GLfloat priority;
+      GLuint node;
+      GLuint depth;
+      GLuint levels;
+      GLint x, y, z;
+    } Chunk;
+
+    /**
+     * type - fractal made of voxels
+     * levelCount - number of levels of the fractal
+     * detail - largest size of a voxel over its distance from the view
+     * chunkLimit - largest number of chunks meshed
+     * colour - colour of the vertices
+     *
+     * nodes - nodes of the DAG, where identical subtrees share a node
+     * nodeIndices - index of each node, by its children
+     * root - node of the whole fractal, which fills the cube from -1 to 1
+     * chunkMeshes - meshes of the chunks already meshed, in voxel units
+     *
+     * vertexData - vertices of the mesh as [position, normal, colour]
+     * indexData - triangles of the mesh, followed by its lines
+     * vertexCount - number of vertices
+     * triangleIndexCount - number of indices of the triangles
+     * lineIndexCount - number of indices of the lines
+     * chunkCount - number of chunks in the mesh
+     * quadCount - number of quads in the mesh
+     */
+    Type type;
+    GLuint levelCount;
+    GLfloat detail;
+    GLuint chunkLimit;
+    glm::vec3 colour;
+
+    std::vector<Node> nodes;
+    std::map<std::vector<GLuint>, GLuint> nodeIndices;
+    GLuint root;
+    std::map<ChunkKey, ChunkMesh> chunkMeshes;
+
+    std::vector<GLfloat> vertexData;
+    std::vector<GLuint> indexData;
+    GLuint vertexCount;
+    GLuint triangleIndexCount;
+    GLuint lineIndexCount;
+    GLuint chunkCount;
+    GLuint quadCount;
+
+    VoxelFractal(std::map<std::string, GLfloat>& env);
+    static const GLchar* getName(GLuint type);
+    GLuint addNode(const Node& node);
+    GLuint getNode(GLuint depth, GLint x, GLint y, GLint z);
+    GLvoid generate(glm::vec3 viewPosition);
+    GLvoid meshChunk(const ChunkKey& key, ChunkMesh& mesh);
+    GLvoid rasterise(GLuint node, GLint x, GLint y, GLint z, GLint size,
+                     GLuint isPartFilled, std::vector<GLubyte>& grid,
+                     GLint gridSize);
+};
+
+#endif